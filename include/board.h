@@ -4,16 +4,16 @@
  */
 
 #pragma once
-#include <vector>
+#include <cstdint>
 
 namespace AI {
     /**
      * \brief Groups the board functionality
      *
      * This namespace will group all the functions and variables needed to represent the board as a
-     * graph and will be used to do path calculations. The board graph will exist as a single
-     * external global variable. This is done because the board will frequently be re-used and won't
-     * be modified or change based on the AI using it.
+     * graph and will be used to do path calculations. The board graph is a set of constant arrays
+     * that are fixed at compile time. This is done because the board will frequently be re-used
+     * and won't be modified or change based on the AI using it.
      */
     namespace Board {
         /**
@@ -30,11 +30,146 @@ namespace AI {
         /**
          * Every position on the board will be represented by exactly one node, irrespective if it
          * is a room or a cell on the floor grid. Connections (and hence valid movement paths) are
-         * represented by edges. Nodes are the vectors in the board vector, and edges are the
-         * integers within the board vectors representing the indices of the nodes they are
-         * connected to.
+         * represented by edges. The graph is stored in compressed sparse row form: the neighbours
+         * of position i are NEIGHBOURS[NEIGHBOUR_OFFSETS[i]] up to (but not including)
+         * NEIGHBOURS[NEIGHBOUR_OFFSETS[i + 1]]. Use neighbours() instead of indexing these
+         * directly.
          */
-        extern std::vector<std::vector<int>> board;
+
+        // the following code was generated using the gen_graph.py script in the src directory
+
+        const int EDGE_COUNT = 262;
+
+        constexpr uint16_t NEIGHBOUR_OFFSETS[BOARD_SIZE + 1] = {
+              0,   4,   6,   8,   9,  12,  14,  15,  18,  20,
+             22,  25,  27,  29,  33,  35,  38,  42,  45,  48,
+             51,  54,  56,  60,  64,  67,  70,  74,  78,  81,
+             84,  88,  92,  94,  97, 101, 105, 109, 113, 117,
+            121, 125, 128, 130, 132, 135, 139, 142, 145, 149,
+            153, 157, 161, 165, 168, 171, 175, 178, 181, 185,
+            189, 191, 194, 198, 201, 204, 208, 212, 215, 219,
+            222, 226, 230, 233, 235, 238, 240, 243, 246, 250,
+            253, 256, 259, 262,
+        };
+
+        constexpr uint8_t NEIGHBOURS[EDGE_COUNT] = {
+            20, 37, 68, 36, // 0
+            40, 50, // 1
+            82, 7, // 2
+            78, // 3
+            74, 5, 9, // 4
+            4, 51, // 5
+            41, // 6
+            10, 8, 2, // 7
+            7, 19, // 8
+            13, 4, // 9
+            11, 15, 7, // 10
+            10, 16, // 11
+            13, 22, // 12
+            12, 14, 23, 9, // 13
+            13, 24, // 14
+            16, 10, 25, // 15
+            15, 17, 11, 26, // 16
+            16, 18, 27, // 17
+            17, 19, 28, // 18
+            18, 20, 8, // 19
+            19, 21, 0, // 20
+            20, 22, // 21
+            21, 23, 12, 29, // 22
+            22, 24, 13, 30, // 23
+            23, 14, 31, // 24
+            26, 15, 33, // 25
+            25, 27, 16, 34, // 26
+            26, 28, 17, 35, // 27
+            27, 18, 36, // 28
+            30, 22, 37, // 29
+            29, 31, 23, 38, // 30
+            30, 32, 24, 39, // 31
+            31, 40, // 32
+            34, 25, 43, // 33
+            33, 35, 26, 44, // 34
+            34, 36, 27, 45, // 35
+            35, 28, 46, 0, // 36
+            38, 29, 47, 0, // 37
+            37, 39, 30, 48, // 38
+            38, 40, 31, 49, // 39
+            39, 32, 50, 1, // 40
+            42, 51, 6, // 41
+            41, 52, // 42
+            44, 33, // 43
+            43, 45, 34, // 44
+            44, 46, 35, 55, // 45
+            45, 36, 56, // 46
+            48, 37, 57, // 47
+            47, 49, 38, 58, // 48
+            48, 50, 39, 59, // 49
+            49, 40, 60, 1, // 50
+            52, 41, 61, 5, // 51
+            51, 53, 42, 62, // 52
+            52, 54, 63, // 53
+            53, 55, 64, // 54
+            54, 56, 45, 65, // 55
+            55, 46, 66, // 56
+            58, 47, 70, // 57
+            57, 59, 48, 71, // 58
+            58, 60, 49, 72, // 59
+            59, 50, // 60
+            62, 51, 73, // 61
+            61, 63, 52, 74, // 62
+            62, 64, 53, // 63
+            63, 65, 54, // 64
+            64, 66, 55, 75, // 65
+            65, 67, 56, 76, // 66
+            66, 68, 77, // 67
+            67, 69, 78, 0, // 68
+            68, 70, 79, // 69
+            69, 71, 57, 80, // 70
+            70, 72, 58, 81, // 71
+            71, 59, 82, // 72
+            74, 61, // 73
+            73, 62, 4, // 74
+            76, 65, // 75
+            75, 77, 66, // 76
+            76, 78, 67, // 77
+            77, 79, 68, 3, // 78
+            78, 80, 69, // 79
+            79, 81, 70, // 80
+            80, 82, 71, // 81
+            81, 72, 2, // 82
+        };
+
+        // end of generated code
+
+        /**
+         * \brief The neighbours of a single position
+         *
+         * This is a view into the NEIGHBOURS array, so it can be iterated over without copying
+         * anything.
+         */
+        class Neighbours {
+            public:
+                constexpr Neighbours(const uint8_t* first, const uint8_t* last) :
+                    first(first), last(last) {}
+
+                constexpr const uint8_t* begin() const { return first; }
+                constexpr const uint8_t* end() const { return last; }
+                constexpr int size() const { return last - first; }
+                constexpr int operator[](int i) const { return first[i]; }
+
+            private:
+                const uint8_t* first;
+                const uint8_t* last;
+        };
+
+        /**
+         * \brief Returns the neighbours of a position
+         * \note pos isn't checked, it must be a valid board position
+         */
+        constexpr Neighbours neighbours(int pos)
+        {
+            return Neighbours(NEIGHBOURS + NEIGHBOUR_OFFSETS[pos],
+                    NEIGHBOURS + NEIGHBOUR_OFFSETS[pos + 1]);
+        }
     };
 }
 
@@ -5,16 +5,24 @@
 
 #pragma once
 #include "macros.h"
+#include "metrics.h"
 #include "position.h"
+#include "random.h"
+#include "string-view.h"
 #include <vector>
 #include <utility>
 #include <map>
 #include <ostream>
 #include <mutex>
+#include <cstdint>
+#include <cstddef>
 
 namespace AI {
     class Deductor;
     class Predictor;
+    class InformationPlanner;
+    class MovePlanner;
+    class DeductionLog;
     struct Deck;
 
     /**
@@ -85,21 +93,21 @@ namespace AI {
              * \throw std::invalid_argument if the string isn't a valid player
              * \note This is case-insensitive, e.g. either "Dagger" or "dagger" will work
              */
-            static Player strToPlayer(std::string s);
+            static Player strToPlayer(StringView s);
 
             /**
              * \brief Converts a comms-protocol string to a Weapon enum
              * \throw std::invalid_argument if the string isn't a valid weapon
              * \note This is case-insensitive, e.g. either "Dagger" or "dagger" will work
              */
-            static Weapon strToWeapon(std::string s);
+            static Weapon strToWeapon(StringView s);
 
             /**
              * \brief Converts a comms-protocol string to a Room enum
              * \throw std::invalid_argument if the string isn't a valid room
              * \note This is case-insensitive, e.g. either "Dagger" or "dagger" will work
              */
-            static Room strToRoom(std::string s);
+            static Room strToRoom(StringView s);
 
             /**
              * \brief Converts a Player enum to a comms-protocol string
@@ -119,6 +127,15 @@ namespace AI {
              */
             static std::string roomToStr(Room r);
 
+            /**
+             * \brief The same as playerToStr, weaponToStr and roomToStr, but without copying the
+             * name into a new string
+             * \returns a view of a string literal, so it stays valid
+             */
+            static StringView playerName(Player p);
+            static StringView weaponName(Weapon w);
+            static StringView roomName(Room r);
+
             /**
              * \brief Alias for playerToStr
              */
@@ -179,7 +196,7 @@ namespace AI {
                  * \note This is case-insensitive
                  * \throw std::invalid_argument if the string is not a valid string for any card
                  */
-                Card(std::string s);
+                Card(StringView s);
 
                 enum Type {
                     PLAYER,
@@ -209,6 +226,20 @@ namespace AI {
                  * This will return the string with the first letter capitalized, e.g. Dagger
                  */
                 std::string str() const;
+
+                /**
+                 * \brief The same as str(), but as a view of a string literal
+                 */
+                StringView name() const;
+
+                /**
+                 * \brief Converts a comms-protocol string to a card without throwing or allocating
+                 * \returns false if the string is not a valid string for any card, card is left
+                 * unchanged then
+                 * \note This is case-insensitive and takes every name the protocol has for a card,
+                 * e.g. both "Dagger" and "knife"
+                 */
+                static bool parse(StringView s, Card& card);
             };
 
             /**
@@ -268,13 +299,232 @@ namespace AI {
                 /**
                  * \returns true if we know if the player has the card or not
                  */
-                bool concluded();
+                bool concluded() const;
 
                 /**
                  * \returns true if we know the player knows about a card. Returns false if we
                  * don't know if they know.
                  */
-                bool knows();
+                bool knows() const;
+            };
+
+            /**
+             * \brief Dense matrix holding the Notes of every player for every card
+             *
+             * Every attribute of the Notes struct is stored as a bitmask, once per player (a bit
+             * for every card) and once per card (a bit for every player). This means that questions
+             * such as "what does this player lack" or "who has this card" are answered with a
+             * single word instead of having to walk through all the notes.
+             *
+             * The familiar notes[player][card].has syntax is still supported through small proxy
+             * objects, which makes it possible to use the matrix as a drop-in replacement for a
+             * nested map of Notes.
+             */
+            class NotesMatrix {
+                public:
+                    /**
+                     * \brief The attributes that can be noted for a card, see Notes for details
+                     */
+                    enum Attribute {
+                        HAS,
+                        SEEN,
+                        LACKS,
+                        DEDUCED,
+                        TABLE,
+                        ENVELOPE,
+                        ATTRIBUTE_COUNT
+                    };
+
+                    /**
+                     * \brief Bitmask with a bit for every card, see index() for the bit positions
+                     */
+                    typedef uint32_t CardMask;
+
+                    /**
+                     * \brief Bitmask with a bit for every player, the bit position is the Player
+                     * enum value
+                     */
+                    typedef uint8_t PlayerMask;
+
+                    /**
+                     * \brief Amount of players (rows) in the matrix
+                     */
+                    static const int PLAYER_COUNT = int(MAX_PLAYER) + 1;
+
+                    /**
+                     * \brief Amount of cards (columns) in the matrix
+                     */
+                    static const int CARD_COUNT = int(MAX_PLAYER) + int(MAX_WEAPON) +
+                        int(MAX_ROOM) + 3;
+
+                    static const CardMask PLAYER_CARDS = (CardMask(1) << (int(MAX_PLAYER) + 1)) - 1;
+                    static const CardMask WEAPON_CARDS = ((CardMask(1) << (int(MAX_WEAPON) + 1)) - 1)
+                        << (int(MAX_PLAYER) + 1);
+                    static const CardMask ROOM_CARDS = ((CardMask(1) << (int(MAX_ROOM) + 1)) - 1)
+                        << (int(MAX_PLAYER) + int(MAX_WEAPON) + 2);
+                    static const CardMask ALL_CARDS = PLAYER_CARDS | WEAPON_CARDS | ROOM_CARDS;
+
+                    /**
+                     * \brief Returns the bit position of a card. Players come first, then weapons
+                     * and lastly rooms.
+                     */
+                    static int index(const Card& c)
+                    {
+                        return c.card + (c.type == Card::PLAYER ? 0 : c.type == Card::WEAPON ?
+                                int(MAX_PLAYER) + 1 : int(MAX_PLAYER) + int(MAX_WEAPON) + 2);
+                    }
+
+                    /**
+                     * \brief Inverse of index()
+                     */
+                    static Card card(int index);
+
+                    /**
+                     * \returns the mask with only the given card's bit set
+                     */
+                    static CardMask mask(const Card& c) { return CardMask(1) << index(c); }
+
+                    /**
+                     * \returns the player mask (see players()) with only the given player's bit set
+                     * \note Use mask(Card(p)) for the bit of the player's card in a CardMask
+                     */
+                    static PlayerMask playerBit(Player p) { return PlayerMask(1) << int(p); }
+
+                    /**
+                     * \returns the mask with the bits of the three cards in the suggestion set
+                     */
+                    static CardMask mask(const Suggestion& s)
+                    {
+                        return mask(Card(s.player)) | mask(Card(s.weapon)) | mask(Card(s.room));
+                    }
+
+                    /**
+                     * \returns the mask of all the cards of the given type
+                     */
+                    static CardMask typeMask(Card::Type type);
+
+                    /**
+                     * \returns true if the attribute is set for the player and card
+                     */
+                    bool get(Player p, const Card& c, Attribute a) const
+                    {
+                        return rows[a][p] & mask(c);
+                    }
+
+                    /**
+                     * \brief Sets or clears the attribute for the player and card
+                     */
+                    void set(Player p, const Card& c, Attribute a, bool value = true)
+                    {
+                        int i = index(c);
+                        if (value) {
+                            rows[a][p] |= CardMask(1) << i;
+                            cols[a][i] |= playerBit(p);
+                        } else {
+                            rows[a][p] &= ~(CardMask(1) << i);
+                            cols[a][i] &= ~playerBit(p);
+                        }
+                    }
+
+                    /**
+                     * \brief Sets the attribute for all the given cards of a player
+                     */
+                    void set(Player p, CardMask cards, Attribute a);
+
+                    /**
+                     * \returns all the cards for which the attribute is set for the player, e.g.
+                     * cards(p, LACKS) is everything the player lacks
+                     */
+                    CardMask cards(Player p, Attribute a) const { return rows[a][p]; }
+
+                    /**
+                     * \returns all the players for which the attribute is set for the card, e.g.
+                     * players(c, HAS) is everyone that has the card
+                     */
+                    PlayerMask players(const Card& c, Attribute a) const
+                    {
+                        return cols[a][index(c)];
+                    }
+
+                    /**
+                     * \returns a copy of the notes for a player and card
+                     */
+                    Notes notes(Player p, const Card& c) const;
+
+                    bool operator==(const NotesMatrix& other) const;
+                    bool operator!=(const NotesMatrix& other) const;
+
+                    /**
+                     * \brief Reference to a single attribute of a single note
+                     */
+                    class Bit {
+                        public:
+                            Bit(NotesMatrix& m, Player p, const Card& c, Attribute a) :
+                                m(m), p(p), c(c), a(a) {}
+
+                            operator bool() const { return m.get(p, c, a); }
+                            Bit& operator=(bool value) { m.set(p, c, a, value); return *this; }
+                            Bit& operator=(const Bit& other) { return *this = bool(other); }
+
+                        private:
+                            NotesMatrix& m;
+                            Player p;
+                            Card c;
+                            Attribute a;
+                    };
+
+                    /**
+                     * \brief Proxy for the notes of a single player and card, mirrors Notes
+                     */
+                    struct Entry {
+                        Entry(NotesMatrix& m, Player p, const Card& c) :
+                            has(m, p, c, HAS), seen(m, p, c, SEEN), lacks(m, p, c, LACKS),
+                            deduced(m, p, c, DEDUCED), table(m, p, c, TABLE),
+                            envelope(m, p, c, ENVELOPE) {}
+
+                        Bit has;
+                        Bit seen;
+                        Bit lacks;
+                        Bit deduced;
+                        Bit table;
+                        Bit envelope;
+
+                        bool concluded() const { return has || lacks; }
+                        bool knows() const { return has || seen; }
+                    };
+
+                    /**
+                     * \brief Proxy for the notes of a single player
+                     */
+                    class Row {
+                        public:
+                            Row(NotesMatrix& m, Player p) : m(m), p(p) {}
+                            Entry operator[](const Card& c) { return Entry(m, p, c); }
+
+                        private:
+                            NotesMatrix& m;
+                            Player p;
+                    };
+
+                    /**
+                     * \brief Read-only proxy for the notes of a single player
+                     */
+                    class ConstRow {
+                        public:
+                            ConstRow(const NotesMatrix& m, Player p) : m(m), p(p) {}
+                            Notes operator[](const Card& c) const { return m.notes(p, c); }
+
+                        private:
+                            const NotesMatrix& m;
+                            Player p;
+                    };
+
+                    Row operator[](Player p) { return Row(*this, p); }
+                    ConstRow operator[](Player p) const { return ConstRow(*this, p); }
+
+                private:
+                    CardMask rows[ATTRIBUTE_COUNT][PLAYER_COUNT] = {};
+                    PlayerMask cols[ATTRIBUTE_COUNT][CARD_COUNT] = {};
             };
 
             /**
@@ -333,17 +583,32 @@ namespace AI {
                     /**
                      * \returns true if waiting for player
                      */
-                    bool waiting();
+                    bool waiting() const;
 
                     /**
                      * \brief Stops the log from waiting (useful on next turn
                      */
                     void clear();
 
+                    /**
+                     * \brief Removes all the entries from the log
+                     *
+                     * The memory is kept, so that the log can be filled again without allocating.
+                     */
+                    void reset();
+
                     /**
                      * \returns the log
+                     * \note This is a reference to the log itself, so it is only valid for as long
+                     * as the SuggestionLog is
+                     */
+                    const std::vector<SuggestionLogItem>& log() const;
+
+                    /**
+                     * \returns the suggestion that is waiting for a show
+                     * \note This is only meaningful while waiting() is true
                      */
-                    std::vector<SuggestionLogItem> log();
+                    const SuggestionLogItem& staged() const;
 
                 private:
                     bool waitingForShow = false;
@@ -351,6 +616,55 @@ namespace AI {
                     std::vector<SuggestionLogItem> _log;
             };
 
+            /**
+             * \brief One of the events the bot can be told about, so that a backlog of them can be
+             * given to ingest() at once
+             *
+             * Events are made with the functions named after the Bot functions they stand for,
+             * e.g. Event::madeSuggestion(Bot::PLUM, suggestion). Only the members the type of the
+             * event needs are set.
+             */
+            struct Event {
+                enum Type {
+                    SET_CARDS,
+                    UPDATE_BOARD,
+                    MOVE_PLAYER,
+                    MADE_SUGGESTION,
+                    OTHER_SHOWN_CARD,
+                    NO_OTHER_SHOWN_CARD,
+                    SHOW_CARD,
+                    NO_SHOW_CARD,
+                    NEW_TURN
+                };
+
+                Type type;
+                Player player = Player(0);
+                int position = 0;
+                Suggestion suggestion = Suggestion(Player(0), Weapon(0), Room(0));
+                Card card = Card(Player(0));
+                std::vector<Card> cards;
+                std::vector<std::pair<Player, Position>> board;
+
+                /**
+                 * \brief tableCards for SET_CARDS and accuse for MADE_SUGGESTION
+                 */
+                bool flag = false;
+
+                static Event setCards(std::vector<Card> cards, bool tableCards = false);
+                static Event updateBoard(std::vector<std::pair<Player, Position>> players);
+                static Event movePlayer(Player player, Position position);
+                static Event madeSuggestion(Player player, Suggestion suggestion,
+                        bool accuse = false);
+                static Event otherShownCard(Player showed);
+                static Event noOtherShownCard();
+                static Event showCard(Player player, Card card);
+                static Event noShowCard();
+                static Event newTurn();
+
+                private:
+                    Event(Type type) : type(type) {}
+            };
+
             /**
              * \brief Bot class constructor
              * \param player The board character the AI will be playing as
@@ -359,6 +673,20 @@ namespace AI {
              */
             Bot(Player player, std::vector<Player> order);
 
+            /**
+             * \brief Bot class constructor with a seed for the bot's random choices
+             *
+             * Two bots created with the same seed that are given the same events make exactly the
+             * same choices, which makes it possible to replay a game. The other constructor seeds
+             * the bot from std::random_device.
+             *
+             * \param player The board character the AI will be playing as
+             * \param order The order in which players will play, with the first element being the
+             * first player.
+             * \param seed The seed for the bot's random number generator
+             */
+            Bot(Player player, std::vector<Player> order, uint64_t seed);
+
             ~Bot();
 
             /**
@@ -486,11 +814,187 @@ namespace AI {
              */
             void newTurn();
 
+            /**
+             * \brief Tells the bot about many events at once, in the given order
+             *
+             * This does the same as calling the functions the events stand for one after the
+             * other, but the deductions are only made once, after the last event (see
+             * beginBatch()). Use this to catch a bot up on a backlog of events, e.g. when it
+             * reconnects or replaces a human player halfway through a game.
+             *
+             * \throw whatever the function an event stands for throws, the events before it have
+             * been applied and deduced from then
+             */
+            void ingest(const std::vector<Event>& events);
+
+            /**
+             * \brief Puts off the deductions that follow every event until endBatch()
+             *
+             * Between beginBatch() and endBatch() the events only go into the notes and the log.
+             * The deductors are run once the batch ends, and end up with exactly the same notes
+             * as when they are run after every event. The only exception is showCard() or
+             * setCards() with a card the bot didn't know about yet: the deductors catch up first,
+             * since a card they find before being told about it is marked as deduced. Anything
+             * that asks the bot for an answer or its notes (getMove(), getSuggestion(), getCard(),
+             * getNotes(), serialize() and thinkAhead()) makes the deductions that are due first,
+             * so the answers don't change either. Batches can be nested, the deductions are made
+             * when the outermost one ends.
+             */
+            void beginBatch();
+
+            /**
+             * \brief Ends a batch started with beginBatch()
+             * \throw std::runtime_error if no batch was started
+             */
+            void endBatch();
+
             /**
              * \brief Used to get a copy of the current notes of the bot
              * \returns the notes the bot has made so far
              */
-            std::map<Player, std::map<Card, Notes>> getNotes();
+            NotesMatrix getNotes();
+
+            /**
+             * \brief The ways the bot can choose the player and weapon of its suggestions
+             */
+            enum Strategy {
+                /**
+                 * \brief Use the predictors' scores and the safe cards to isolate the envelope
+                 * cards one type at a time
+                 */
+                HEURISTIC,
+
+                /**
+                 * \brief Use an InformationPlanner to choose the suggestion that is expected to
+                 * tell us the most about the envelope, and a MovePlanner to move to the room
+                 * where the best suggestion can be made
+                 */
+                INFORMATION
+            };
+
+            /**
+             * \brief Changes the way the bot chooses its suggestions, the default is HEURISTIC
+             * \param budget The most time the INFORMATION strategy may spend on choosing a
+             * suggestion in microseconds, 0 for no limit
+             */
+            void setStrategy(Strategy strategy, int budget = DEFAULT_PLANNING_BUDGET);
+
+            /**
+             * \brief Default time budget for the INFORMATION strategy in microseconds
+             */
+            static const int DEFAULT_PLANNING_BUDGET = 2000;
+
+            /**
+             * \brief Writes the state of the bot to a buffer, so that it can be restored later (or
+             * in another process) with deserialize()
+             *
+             * The snapshot holds the player and order, the notes, the board, the log, the
+             * envelope, the suggestion being made, the strategy and the state of the random number
+             * generator. The notes are bit-packed and every log entry is a single varint of
+             * usually two bytes, so a snapshot is around a hundred bytes plus two bytes per
+             * suggestion. Nothing is allocated, which makes it cheap enough to checkpoint the bot
+             * after every event.
+             *
+             * \returns the size of the snapshot. If this is more than size nothing useful has been
+             * written and the call should be repeated with a buffer of at least this size.
+             */
+            size_t serialize(uint8_t* buffer, size_t size);
+
+            /**
+             * \returns a snapshot of the bot, see serialize(uint8_t*, size_t)
+             */
+            std::vector<uint8_t> serialize();
+
+            /**
+             * \brief Restores the state of the bot from a snapshot made by serialize()
+             *
+             * Everything is replaced, including the player and order the bot was created with. The
+             * deductors and predictors start over from the restored notes and log. The sampled
+             * deals of the INFORMATION strategy aren't part of the snapshot and are drawn again,
+             * so with that strategy the restored bot may choose different suggestions than the
+             * original would have.
+             *
+             * \throw std::invalid_argument if the data isn't a snapshot of SNAPSHOT_VERSION or is
+             * damaged, the bot is left unchanged in that case
+             */
+            void deserialize(const uint8_t* data, size_t size);
+
+            /**
+             * \brief Alias for deserialize(data.data(), data.size())
+             */
+            void deserialize(const std::vector<uint8_t>& data);
+
+            /**
+             * \brief Version of the snapshot format, increased whenever it changes
+             */
+            static const uint8_t SNAPSHOT_VERSION = 1;
+
+            /**
+             * \brief Starts recording the deductions and predictions the bot makes, see
+             * DeductionLog
+             *
+             * Recording doesn't allocate or format anything, so it can be left on in release
+             * builds. While recording, the deductions are no longer logged as messages, the
+             * messages are only built when the records are read with DeductionLog::messages(). Any
+             * deductions recorded before are discarded.
+             *
+             * \param capacity The amount of deductions kept, once there are more the oldest ones
+             * are overwritten. 0 stops recording.
+             */
+            void recordDeductions(int capacity = DEFAULT_DEDUCTION_CAPACITY);
+
+            /**
+             * \returns a copy of the recorded deductions, which is empty if they aren't being
+             * recorded
+             * \note Include deduction-log.h to use this
+             */
+            DeductionLog getDeductions();
+
+            /**
+             * \brief Default amount of deductions kept by recordDeductions()
+             */
+            static const int DEFAULT_DEDUCTION_CAPACITY = 4096;
+
+            /**
+             * \brief Returns the sink that the bot and its deductors and predictors log to
+             *
+             * The sink only holds the lines of this bot, so it can be used to read its reasoning
+             * while many bots are playing in the same process, and to choose which levels it
+             * keeps. It keeps everything by default.
+             */
+            LogSink& getLogSink();
+
+            /**
+             * \returns the call counts, latencies and work counters of the bot, which are only
+             * gathered when compiled with METRICS defined, see Metrics
+             */
+            Metrics getMetrics();
+
+            /**
+             * \brief Works out what the bot will answer to getMove() and getSuggestion() before
+             * it is asked, so that it can answer straight away when it is
+             *
+             * Between its turns the bot is only told about events, and all the work of choosing a
+             * move or a suggestion is done once it is asked for one. This does that work ahead of
+             * time, a small step per call: the first step works out the move for every dice roll
+             * from MIN_ROLL to MAX_ROLL, and every step after that the suggestion for one of the
+             * rooms the bot can end up in. The answers are kept until an event changes the notes
+             * or the board, and getMove() and getSuggestion() answer exactly as they would have
+             * without thinking ahead.
+             *
+             * Nothing is worked out ahead with the INFORMATION strategy, since its planner draws
+             * new random numbers every time it is used.
+             *
+             * \returns true if there is more to work out, false once everything has been worked
+             * out for the current notes and board
+             */
+            bool thinkAhead();
+
+            /**
+             * \brief The lowest and highest dice rolls thinkAhead() works out moves for
+             */
+            static const int MIN_ROLL = 2;
+            static const int MAX_ROLL = 12;
 
         /**
          * Using protected instead of private so that the BotTest subclass can access the private
@@ -528,9 +1032,36 @@ namespace AI {
              *
              * \param nolacking if true skip notesMarkLacking(), can be used if no notes have been
              * changed and only deductions should be run
+             * \note During a batch this only marks the deductions as due, see beginBatch()
              */
             void notesHook(bool nolacking=false);
 
+            /**
+             * \brief Makes the deductions notesHook() put off during a batch, if there are any
+             */
+            void settle();
+
+            /**
+             * \brief Does the work of notesHook() straight away
+             */
+            void deduce(bool nolacking);
+
+            /**
+             * \returns the wanted deck with the predictors' scores, sorted
+             */
+            Deck getSortedDeck();
+
+            /**
+             * \brief Chooses the move for getMove() with the HEURISTIC strategy
+             */
+            int chooseMove(int allowedMoves, const Deck& deck);
+
+            /**
+             * \brief Chooses curSuggestion for getSuggestion() as if the bot was at pos, without
+             * the planner of the INFORMATION strategy
+             */
+            void chooseSuggestion(int pos, const Deck& deck);
+
             /**
              * \brief Runs through all the deductors to make new deductions
              * \note This is will be run as part of the notesHook() function
@@ -615,6 +1146,12 @@ namespace AI {
              */
             Card::Type findLeastKnown();
 
+            /**
+             * \brief (Re)creates the deductors, predictors and planners for the current player,
+             * order and strategy, which discards everything they have worked out
+             */
+            void createModules();
+
             /**
              * \brief The player this bot is playing as
              */
@@ -628,7 +1165,7 @@ namespace AI {
             /**
              * \brief Holds the notes for all the cards
              */
-            std::map<Player, std::map<Card, Notes>> notes;
+            NotesMatrix notes;
 
             /**
              * \brief Holds all the positions of all the players on the board
@@ -652,6 +1189,45 @@ namespace AI {
              */
             std::vector<Predictor*> predictors;
 
+            /**
+             * \brief The way suggestions are chosen, see setStrategy()
+             */
+            Strategy strategy = HEURISTIC;
+
+            /**
+             * \brief The time budget of the INFORMATION strategy, see setStrategy()
+             */
+            int budget = DEFAULT_PLANNING_BUDGET;
+
+            /**
+             * \brief Chooses the suggestions for the INFORMATION strategy
+             * \note needs to be deleted in destructor
+             */
+            InformationPlanner* planner = nullptr;
+
+            /**
+             * \brief Chooses the moves for the INFORMATION strategy
+             * \note needs to be deleted in destructor
+             */
+            MovePlanner* movePlanner = nullptr;
+
+            /**
+             * \brief The recorded deductions, nullptr if they aren't being recorded
+             * \note needs to be deleted in destructor
+             */
+            DeductionLog* deductions = nullptr;
+
+            /**
+             * \brief Where LOG_LOGIC and LOG_INFO send the lines of this bot, see getLogSink()
+             * \note needs to be deleted in destructor
+             */
+            LogSink* logSink;
+
+            /**
+             * \brief See getMetrics()
+             */
+            Metrics metrics;
+
             /**
              * \brief See Envelope for more details
              */
@@ -667,6 +1243,65 @@ namespace AI {
              */
             bool weMadeSuggestion = false;
 
+            /**
+             * \brief The amount of batches that have been started and not ended, see beginBatch()
+             */
+            int batches = 0;
+
+            /**
+             * \brief Set when notesHook() put off its deductions during a batch, lackingDue if
+             * notesMarkLacking() has to be run too
+             */
+            bool deductionsDue = false;
+            bool lackingDue = false;
+
+            /**
+             * \brief Used for all the random choices the bot makes
+             */
+            Random rng;
+
+            /**
+             * \brief Raised whenever something that getMove() or getSuggestion() depend on changes,
+             * boardVersion for the positions on the board and notesVersion for everything else
+             * (including rng), so that thinkAhead() can tell which answers are still valid
+             */
+            uint64_t notesVersion = 0;
+            uint64_t boardVersion = 0;
+
+            /**
+             * \brief A suggestion worked out by thinkAhead() for when the bot is at pos, and the
+             * state of rng after choosing it
+             */
+            struct Thought {
+                int pos;
+                Suggestion suggestion;
+                Random rng;
+            };
+
+            /**
+             * \brief The answers worked out by thinkAhead()
+             *
+             * Everything is for notesVersion notes, and the moves also for boardVersion board.
+             */
+            struct Thoughts {
+                uint64_t notes = 0;
+                uint64_t board = 0;
+
+                /**
+                 * \brief The wanted deck for the notes, nullptr until it is needed
+                 */
+                Deck* deck = nullptr;
+
+                bool haveMoves = false;
+                int moves[MAX_ROLL + 1];
+
+                /**
+                 * \brief The rooms the moves can end in that have no suggestion yet
+                 */
+                std::vector<int> rooms;
+                std::vector<Thought> suggestions;
+            } thoughts;
+
             /**
              * \brief Used to lock class members while they are being modified
              */
@@ -34,7 +34,7 @@ namespace AI {
         /**
          * \brief returns true if the given card is in one of the decks
          */
-        bool contains(Bot::Card card);
+        bool contains(Bot::Card card) const;
     };
 };
 
@@ -0,0 +1,132 @@
+/**
+ * \file deduction-log.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "bot.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Keeps the deductions and predictions a bot made as small binary records
+     *
+     * Building a log message for every deduction takes several allocations, while all that is
+     * needed to describe it is the rule that made it, what was found and the player and card it is
+     * about. This keeps exactly that in a 4 byte record in a ring buffer of a fixed size, so that
+     * recording deductions costs next to nothing and can be left on in release builds. The
+     * records are turned back into the usual log messages with format() when they are read.
+     */
+    class DeductionLog {
+        public:
+            /**
+             * \brief The deductor, predictor or envelope check that made a deduction
+             */
+            enum Rule : uint8_t {
+                LOCAL_EXCLUDE,
+                NO_SHOW,
+                SEEN,
+                CARD_COUNT_EXCLUDE,
+                CONSTRAINT,
+                SEEN_PREDICTOR,
+                MULTIPLE_PREDICTOR,
+                NO_SHOW_PREDICTOR,
+                ALL_LACKS,
+                NO_HAS,
+                RULE_COUNT
+            };
+
+            /**
+             * \brief What was deduced about the player and card
+             */
+            enum Fact : uint8_t {
+                HAS,
+                LACKS,
+                SAW,
+                LOW_PROBABILITY,
+                HIGH_PROBABILITY,
+                VERY_HIGH_PROBABILITY,
+
+                /**
+                 * \brief The card is in the envelope, the player is the bot itself
+                 */
+                ENVELOPE,
+                FACT_COUNT
+            };
+
+            struct Record {
+                Rule rule;
+                Fact fact;
+                uint8_t player;
+
+                /**
+                 * \brief The card index, see Bot::NotesMatrix::index()
+                 */
+                uint8_t card;
+            };
+
+            /**
+             * \param capacity The amount of records kept, once there are more the oldest ones are
+             * overwritten
+             */
+            explicit DeductionLog(int capacity);
+
+            /**
+             * \brief Adds a record, this never allocates
+             */
+            void add(Rule rule, Fact fact, Bot::Player player, const Bot::Card& card)
+            {
+                if (!records.empty())
+                    records[added % records.size()] = record(rule, fact, player, card);
+                added++;
+            }
+
+            /**
+             * \returns the amount of records that are kept
+             */
+            size_t size() const;
+
+            /**
+             * \returns the amount of records that have been added, including the ones that have
+             * been overwritten
+             */
+            uint64_t total() const;
+
+            /**
+             * \returns a record, the oldest one that is kept is at index 0
+             */
+            const Record& operator[](size_t i) const;
+
+            /**
+             * \brief Removes all the records
+             */
+            void clear();
+
+            /**
+             * \returns the record for a deduction
+             */
+            static Record record(Rule rule, Fact fact, Bot::Player player, const Bot::Card& card)
+            {
+                return { rule, fact, uint8_t(player), uint8_t(Bot::NotesMatrix::index(card)) };
+            }
+
+            /**
+             * \returns the log message for a record, e.g. "Deduced that Plum lacks Rope (no-show)"
+             * \throw std::invalid_argument if the record isn't valid
+             */
+            static std::string format(const Record& record);
+
+            /**
+             * \returns the log messages of all the records that are kept, oldest first
+             */
+            std::vector<std::string> messages() const;
+
+        private:
+            std::vector<Record> records;
+            uint64_t added = 0;
+    };
+}
+
+// vim: set expandtab textwidth=100:
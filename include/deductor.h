@@ -6,6 +6,8 @@
 #pragma once
 
 #include "bot.h"
+#include "deduction-log.h"
+#include "metrics.h"
 #include <map>
 
 namespace AI {
@@ -18,10 +20,36 @@ namespace AI {
              * \brief Attemps to make a deduction
              * \returns true if a deduction was made
              */
-            virtual bool run(Bot::SuggestionLog log, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>>& notes) =0;
+            virtual bool run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes) =0;
+
+            /**
+             * \brief Sets the log the deductions are recorded in, nullptr to stop recording them
+             */
+            virtual void setDeductionLog(DeductionLog* log) { deductions = log; }
+
+            /**
+             * \brief Sets the sink the deductor logs to, nullptr to log to the LogicLog
+             */
+            virtual void setLogSink(LogSink* sink) { logSink = sink; }
 
         protected:
+            /**
+             * \brief Records a deduction in the deduction log, or logs it if there is no
+             * deduction log
+             */
+            void deduced(DeductionLog::Rule rule, DeductionLog::Fact fact, Bot::Player player,
+                    const Bot::Card& card)
+            {
+                METRIC_COUNT(Metrics::Counter(Metrics::LOCAL_EXCLUDE_FACTS + rule), 1);
+                if (deductions)
+                    deductions->add(rule, fact, player, card);
+                else
+                    LOG_LOGIC(DeductionLog::format(DeductionLog::record(rule, fact, player, card)));
+            }
+
             Bot::Player player;
+            DeductionLog* deductions = nullptr;
+            LogSink* logSink = nullptr;
     };
 }
 
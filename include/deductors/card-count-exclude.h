@@ -18,7 +18,13 @@ namespace AI {
         public:
             CardCountExcludeDeductor(Bot::Player player, std::vector<Bot::Player> order);
 
-            bool run(Bot::SuggestionLog log, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>>& notes) override;
+            bool run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes) override;
+
+            /**
+             * \brief Attempts to make a deduction for a single player
+             * \returns true if a deduction was made
+             */
+            bool deduce(Bot::Player player, Bot::NotesMatrix& notes);
         private:
             std::vector<Bot::Player> order;
             static std::vector<Bot::Card> allCards;
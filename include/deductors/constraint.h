@@ -0,0 +1,121 @@
+/**
+ * \file constraint.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "../deductor.h"
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Deduces has and lacks marks by treating the game as a set of boolean constraints
+     *
+     * Every player (and the envelope) either has a card or not, which gives a boolean variable for
+     * every location and card. The rules of the game and everything that is known restrict these
+     * variables:
+     *
+     *  - every card is in exactly one location (table cards are in none)
+     *  - every player holds exactly as many cards as they were dealt, and the envelope holds
+     *    exactly one card of every type
+     *  - a player that showed a card has at least one of the suggested cards (a clause)
+     *  - the players that couldn't show a card lack all of the suggested cards, as do the cards
+     *    marked as lacking in the notes (unit clauses)
+     *
+     * The clauses are propagated with two watched variables each, and the "exactly n" constraints
+     * by counting how many of their variables are set and cleared. Once nothing more follows,
+     * every unknown variable is probed: it is set and propagated, and if that leads to a
+     * contradiction it must be cleared (and the other way around). This finds deductions that
+     * need several log entries and hand sizes together, which the separate deductors miss.
+     *
+     * \note The seen marks are left to the IncrementalDeductor.
+     */
+    class ConstraintDeductor : public Deductor {
+        public:
+            ConstraintDeductor(Bot::Player player, std::vector<Bot::Player> order);
+
+            bool run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes) override;
+
+            /**
+             * \brief The most variables that are probed in a single run, which bounds the time a
+             * run takes
+             */
+            static const int MAX_PROBES = 1024;
+
+        private:
+            static const int CARD_COUNT = Bot::NotesMatrix::CARD_COUNT;
+            static const int VAR_COUNT = (Bot::NotesMatrix::PLAYER_COUNT + 1) * CARD_COUNT;
+
+            /**
+             * \brief Exactly count of the variables must be set
+             */
+            struct Cardinality {
+                std::vector<int> vars;
+                int count;
+                int set;
+                int cleared;
+            };
+
+            /**
+             * \brief At least one of the variables must be set, the first two are watched
+             */
+            struct Clause {
+                int vars[3];
+                int size;
+            };
+
+            /**
+             * \brief Builds the constraints from the notes and the log
+             * \returns false if they contradict each other
+             */
+            bool build(const Bot::SuggestionLog& log, const Bot::NotesMatrix& notes);
+
+            /**
+             * \brief Sets or clears a variable and queues it for propagation
+             * \returns false if the variable already has the other value
+             */
+            bool assign(int var, bool value);
+
+            /**
+             * \brief Propagates all the queued variables
+             * \returns false on a contradiction
+             */
+            bool propagate();
+
+            /**
+             * \brief Unassigns the variables assigned after the trail had the given size
+             */
+            void undo(size_t mark);
+
+            /**
+             * \brief Probes every unknown variable until nothing changes or the budget runs out
+             * \returns false on a contradiction
+             */
+            bool probe();
+
+            int var(int location, int card) const { return location * CARD_COUNT + card; }
+
+            std::vector<Bot::Player> order;
+
+            /**
+             * \brief 1 if set, -1 if cleared and 0 if unknown
+             */
+            int value[VAR_COUNT];
+
+            std::vector<Cardinality> cardinalities;
+            std::vector<int> constraintsOf[VAR_COUNT];
+            std::vector<Clause> clauses;
+            std::vector<int> watches[VAR_COUNT];
+            std::vector<int> trail;
+            size_t head;
+
+            /**
+             * \brief The has and lacks masks and log size after the previous run, nothing can be
+             * deduced if they haven't changed
+             */
+            Bot::NotesMatrix::CardMask known[2][Bot::NotesMatrix::PLAYER_COUNT];
+            size_t logSize;
+    };
+}
+
+// vim: set expandtab textwidth=100:
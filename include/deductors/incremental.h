@@ -0,0 +1,111 @@
+/**
+ * \file incremental.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "../deductor.h"
+#include "local-exclude.h"
+#include "no-show.h"
+#include "seen.h"
+#include "card-count-exclude.h"
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Event-driven version of the LocalExclude, NoShow, Seen and CardCountExclude
+     * deductors
+     *
+     * Instead of rerunning every deductor over the entire log until nothing changes, this keeps an
+     * index of the log entries each card appears in. Every new fact in the notes (a player gets a
+     * has, lacks or seen mark for a card) is pushed onto a worklist, and only the log entries that
+     * mention that card for that player are looked at again. New log entries are examined once when
+     * they arrive. This reaches the same result as running the four deductors (and marking
+     * lacking cards) until nothing changes, but the work per event stays roughly the same as the
+     * game gets longer.
+     *
+     * \note This assumes that the log it is run with only ever grows. If it is run with a shorter
+     * log the index is rebuilt from scratch.
+     */
+    class IncrementalDeductor : public Deductor {
+        public:
+            IncrementalDeductor(Bot::Player player, std::vector<Bot::Player> order);
+
+            bool run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes) override;
+
+            /**
+             * \brief Sets the deduction log of the deductors that do the work too
+             */
+            void setDeductionLog(DeductionLog* log) override;
+
+            /**
+             * \brief Sets the log sink of the deductors that do the work too
+             */
+            void setLogSink(LogSink* sink) override;
+
+        private:
+            /**
+             * \brief A single attribute that was set for a player and card
+             */
+            struct Fact {
+                Bot::Player player;
+                int card;
+                Bot::NotesMatrix::Attribute attribute;
+            };
+
+            /**
+             * \brief Compares the notes to what has already been processed and queues every
+             * attribute that has been set since then
+             */
+            void collect(const Bot::NotesMatrix& notes);
+
+            /**
+             * \brief Runs the rules that work on a single log entry
+             */
+            void examine(const Bot::SuggestionLogItem& item, Bot::NotesMatrix& notes);
+
+            /**
+             * \brief Marks the card as lacking for everyone except the player that has it
+             */
+            void markLacking(Bot::Player player, int card, Bot::NotesMatrix& notes);
+
+            /**
+             * \brief Forgets everything that has been processed
+             */
+            void reset();
+
+            std::vector<Bot::Player> order;
+
+            /**
+             * \brief Mask of all the players in the order
+             */
+            Bot::NotesMatrix::PlayerMask players;
+
+            LocalExcludeDeductor localExclude;
+            NoShowDeductor noShow;
+            SeenDeductor seen;
+            CardCountExcludeDeductor cardCount;
+
+            /**
+             * \brief The positions in the log of the entries every card appears in
+             */
+            std::vector<size_t> index[Bot::NotesMatrix::CARD_COUNT];
+
+            /**
+             * \brief The amount of log entries that have been indexed
+             */
+            size_t indexed = 0;
+
+            /**
+             * \brief The has, lacks and seen masks of every player that have been processed
+             */
+            Bot::NotesMatrix::CardMask known[3][Bot::NotesMatrix::PLAYER_COUNT];
+
+            /**
+             * \brief Facts waiting to be processed, kept between runs to reuse the memory
+             */
+            std::vector<Fact> worklist;
+    };
+}
+
+// vim: set expandtab textwidth=100:
@@ -17,7 +17,13 @@ namespace AI {
         public:
             SeenDeductor(Bot::Player player);
 
-            bool run(Bot::SuggestionLog log, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>>& notes) override;
+            bool run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes) override;
+
+            /**
+             * \brief Attempts to make a deduction from a single log entry
+             * \returns true if a deduction was made
+             */
+            bool deduce(const Bot::SuggestionLogItem& item, Bot::NotesMatrix& notes);
     };
 }
 
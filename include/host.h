@@ -0,0 +1,272 @@
+/**
+ * \file host.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "bot.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Hosts many bots and runs their events and queries on a fixed pool of threads
+     *
+     * Calling a Bot directly blocks the caller until the bot is done, so a server with many games
+     * ends up with a thread for every game that is waiting on a bot. A BotHost instead queues the
+     * events and queries of every bot it hosts and returns straight away, queries give their answer
+     * through a std::future or a callback.
+     *
+     * The tasks of a single bot are always run one at a time, in the order they were queued, so
+     * the bot sees exactly the same events as when it is called directly. Every bot has its own
+     * lock-free queue of tasks, and a bot with tasks is scheduled on one of the worker threads as a
+     * whole. Every worker has its own queue of scheduled bots, and a worker without bots takes
+     * them from the other workers.
+     *
+     * The functions of a BotHost can be called from any thread, including from a task or callback
+     * that is running on the host, except wait() and the destructor.
+     */
+    class BotHost {
+        private:
+            struct Hosted;
+
+        public:
+            /**
+             * \brief Refers to a bot on the host, it is valid from add() until remove()
+             */
+            typedef Hosted* Handle;
+
+            /**
+             * \brief Is called with the exceptions thrown by the events and callbacks of a bot
+             * \warning This is called on the worker threads and may not throw
+             */
+            typedef std::function<void(Handle, std::exception_ptr)> ErrorHandler;
+
+            /**
+             * \brief The maximum amount of tasks of a bot that is run before the worker moves on
+             * to the next bot, so that one busy bot can't hold up the others
+             */
+            static const int BATCH = 32;
+
+            /**
+             * \param threads the amount of worker threads, 0 for one per hardware thread
+             * \throw std::invalid_argument if threads is negative
+             */
+            explicit BotHost(int threads = 0);
+
+            /**
+             * \brief Waits for all the queued tasks, then stops the workers and deletes the bots
+             * that were not removed
+             */
+            ~BotHost();
+
+            BotHost(const BotHost&) = delete;
+            BotHost& operator=(const BotHost&) = delete;
+
+            /**
+             * \brief Creates a bot on the host, see Bot::Bot()
+             */
+            Handle add(Bot::Player player, std::vector<Bot::Player> order, uint64_t seed);
+
+            /**
+             * \brief Deletes a bot once all the tasks that were queued for it are done
+             * \warning The handle may not be used again after this
+             */
+            void remove(Handle bot);
+
+            /**
+             * \brief Queues a task for a bot, exceptions are passed to the error handler
+             */
+            void post(Handle bot, std::function<void(Bot&)> task);
+
+            /**
+             * \brief Queues a task for a bot that gives a result
+             * \returns the result of the task, or the exception it threw
+             */
+            template <class T>
+            std::future<T> call(Handle bot, std::function<T(Bot&)> task);
+
+            /**
+             * \brief Queues a task for a bot and passes its result to done
+             *
+             * done is run on the worker thread right after the task, before any of the bot's
+             * later tasks. If the task throws, done isn't called and the exception is passed to the
+             * error handler.
+             */
+            template <class T>
+            void call(Handle bot, std::function<T(Bot&)> task, std::function<void(T)> done);
+
+            /**
+             * \brief The events of a bot, see the Bot functions with the same names
+             */
+            void setCards(Handle bot, std::vector<Bot::Card> cards, bool tableCards = false);
+            void updateBoard(Handle bot, std::vector<std::pair<Bot::Player, Position>> players);
+            void movePlayer(Handle bot, Bot::Player player, Position position);
+            void madeSuggestion(Handle bot, Bot::Player player, Bot::Suggestion suggestion,
+                    bool accuse = false);
+            void otherShownCard(Handle bot, Bot::Player showed);
+            void noOtherShownCard(Handle bot);
+            void showCard(Handle bot, Bot::Player player, Bot::Card card);
+            void noShowCard(Handle bot);
+            void newTurn(Handle bot);
+
+            /**
+             * \brief The queries of a bot, see the Bot functions with the same names
+             */
+            std::future<int> getMove(Handle bot, int allowedMoves);
+            void getMove(Handle bot, int allowedMoves, std::function<void(int)> done);
+            std::future<Bot::Suggestion> getSuggestion(Handle bot);
+            void getSuggestion(Handle bot, std::function<void(Bot::Suggestion)> done);
+            std::future<Bot::Card> getCard(Handle bot, Bot::Player player,
+                    std::vector<Bot::Card> cards);
+            void getCard(Handle bot, Bot::Player player, std::vector<Bot::Card> cards,
+                    std::function<void(Bot::Card)> done);
+
+            /**
+             * \brief Replaces the error handler, which logs the errors by default
+             * \warning This may only be called while no tasks are queued
+             */
+            void setErrorHandler(ErrorHandler handler);
+
+            /**
+             * \brief Lets the workers think ahead for the bots (see Bot::thinkAhead()) while they
+             * have no tasks to run
+             *
+             * A bot is handed to the idle workers once it has run all its tasks, and a worker runs
+             * one step of thinking ahead at a time, so a task that is queued for the bot waits for
+             * at most one step. Thinking ahead is off by default.
+             * \warning This may only be called while no tasks are queued
+             */
+            void setThinkAhead(bool enabled);
+
+            /**
+             * \brief Blocks until all the queued tasks, and the tasks they queued, are done
+             */
+            void wait();
+
+            /**
+             * \returns the amount of worker threads
+             */
+            int threads() const;
+
+            /**
+             * \returns the amount of bots on the host
+             */
+            int size();
+
+        private:
+            struct Task {
+                std::function<void(Bot&)> run;
+                std::atomic<Task*> next;
+                bool remove = false;
+            };
+
+            /**
+             * \brief A bot and its queue of tasks
+             *
+             * The queue is a linked list that is pushed to from any thread by swapping head, and
+             * that is only popped from tail by the worker that is running the bot. pending counts
+             * the pushed tasks that haven't been run yet, and the thread that raises it from 0
+             * schedules the bot. A worker that thinks ahead for the bot raises it from 0 as well,
+             * and schedules the bot itself if tasks were pushed meanwhile. This makes sure that
+             * only one worker ever has the bot at a time.
+             */
+            struct Hosted {
+                std::unique_ptr<Bot> bot;
+                std::atomic<Task*> head;
+                Task* tail;
+                std::atomic<int> pending;
+                Task stub;
+
+                // its place in thinkers and whether it is in there, guarded by thinkLock
+                bool thinking = false;
+                std::list<Hosted*>::iterator place;
+
+                Hosted();
+                ~Hosted();
+
+                void push(Task* task);
+                Task* pop();
+            };
+
+            struct Worker {
+                std::mutex lock;
+                std::deque<Hosted*> queue;
+            };
+
+            std::vector<std::unique_ptr<Worker>> workers;
+            std::vector<std::thread> pool;
+            std::atomic<unsigned> nextWorker;
+
+            // bots scheduled on any of the workers, and the workers that are waiting for bots
+            std::atomic<int> scheduled;
+            std::atomic<int> sleeping;
+            std::mutex sleepLock;
+            std::condition_variable wake;
+            std::atomic<bool> stopping;
+
+            // bots that ran all their tasks and can still think ahead, oldest first
+            std::atomic<bool> thinkAhead;
+            std::mutex thinkLock;
+            std::list<Hosted*> thinkers;
+            std::atomic<int> thinkerCount;
+
+            // tasks that were queued but haven't been run yet, for wait()
+            std::atomic<long> tasks;
+            std::mutex idleLock;
+            std::condition_variable idle;
+
+            std::mutex hostedLock;
+            std::unordered_set<Hosted*> hosted;
+
+            ErrorHandler errorHandler;
+
+            void queue(Hosted* bot, Task* task);
+            void schedule(Hosted* bot);
+            Hosted* take(int worker);
+            void run(Hosted* bot);
+            int release(Hosted* bot, int ran, bool think);
+            void removeThinker(Hosted* bot);
+            bool think();
+            void work(int worker);
+    };
+
+    template <class T>
+    std::future<T> BotHost::call(Handle bot, std::function<T(Bot&)> task)
+    {
+        // std::function has to be copyable, so the promise is shared with the task
+        auto promise = std::make_shared<std::promise<T>>();
+        std::future<T> result = promise->get_future();
+
+        post(bot, [promise, task](Bot& b) {
+            try {
+                promise->set_value(task(b));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+
+        return result;
+    }
+
+    template <class T>
+    void BotHost::call(Handle bot, std::function<T(Bot&)> task, std::function<void(T)> done)
+    {
+        post(bot, [task, done](Bot& b) {
+            done(task(b));
+        });
+    }
+}
+
+// vim: set expandtab textwidth=100:
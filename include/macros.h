@@ -35,32 +35,153 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
 
 namespace AI {
+    /**
+     * \brief Keeps the most recent logic and info log lines of every thread
+     *
+     * Every thread that logs gets its own ring buffer of CAPACITY lines, so adding a line never
+     * takes a lock or allocates memory and the log can't grow without bound. Once a ring buffer is
+     * full the oldest lines in it are overwritten. Every line is given a number from a shared
+     * counter, which the readers use to merge the ring buffers back into the order the lines were
+     * added in. The ring buffer of a thread that has exited is handed to the next new thread.
+     */
     class LogicLog {
         public:
             /**
              * \brief Add a line to the log
+             * \note Lines longer than LINE_LENGTH are cut off
              */
-            static void addLog(std::string msg);
+            static void addLog(const std::string& msg);
 
             /**
              * \brief Returns all the log lines since the last time this function was called
+             * \note Lines that have been overwritten since then are lost, lines that are still
+             * being written are returned the next time, along with the lines after them
              */
             static std::vector<std::string> readFromLast();
 
             /**
-             * \brief Returns the full log
+             * \brief Returns the full log, which is the last CAPACITY lines of every thread
              */
             static std::vector<std::string> readFull();
 
+            /**
+             * \brief Amount of lines kept for every thread
+             */
+            static const int CAPACITY = 1024;
+
+            /**
+             * \brief The most characters kept of a line
+             */
+            static const int LINE_LENGTH = 240;
+
         private:
-            static std::vector<std::string> log;
-            static int lastPos;
+            /**
+             * \brief Returns the lines that were added after line number from, in order
+             * \param last is set to the number of the last line up to which nothing is still
+             * being written
+             */
+            static std::vector<std::string> read(uint64_t from, uint64_t& last);
     };
 
     __attribute__((unused))
     static LogicLog logicLog;
+
+    /**
+     * \brief Keeps the log lines of a single bot
+     *
+     * Every Bot owns a sink and hands it to its deductors and predictors, and the LOG_LOGIC and
+     * LOG_INFO macros used in their member functions send their lines to it. That way the lines of
+     * one bot can be read without the lines of every other bot in the process. Code that doesn't
+     * have a sink logs to the LogicLog instead.
+     *
+     * The sink only keeps the lines of the levels up to the one it is set to. The macros check
+     * the level before building the line, so a level that isn't kept costs a single comparison.
+     */
+    class LogSink {
+        public:
+            enum Level {
+                OFF,
+                INFO,
+                LOGIC
+            };
+
+            /**
+             * \param level The most verbose level that is kept
+             * \param capacity The amount of lines kept, once there are more the oldest ones are
+             * overwritten
+             */
+            explicit LogSink(Level level = LOGIC, int capacity = CAPACITY);
+
+            /**
+             * \brief Changes the most verbose level that is kept, OFF to keep nothing
+             */
+            void setLevel(Level level);
+
+            Level getLevel() const;
+
+            /**
+             * \returns whether lines of the level are kept
+             */
+            bool enabled(Level level) const
+            {
+                return level <= this->level.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * \brief Adds a line, regardless of the level
+             */
+            void add(Level level, const std::string& msg);
+
+            /**
+             * \brief Returns all the lines since the last time this function was called
+             * \note Lines that have been overwritten since then are lost
+             */
+            std::vector<std::string> readFromLast();
+
+            /**
+             * \brief Returns all the lines that are kept
+             */
+            std::vector<std::string> readFull();
+
+            /**
+             * \brief Whether the macros should log a line of the level to a sink, which is
+             * always the case if there is no sink
+             */
+            static bool wants(const LogSink* sink, Level level)
+            {
+                return !sink || sink->enabled(level);
+            }
+
+            /**
+             * \brief Adds a line to a sink, or to the LogicLog if there is no sink
+             */
+            static void write(LogSink* sink, Level level, const std::string& msg);
+
+            /**
+             * \brief Default amount of lines kept
+             */
+            static const int CAPACITY = 1024;
+
+        private:
+            std::vector<std::string> read(uint64_t from);
+
+            std::vector<std::string> lines;
+            uint64_t added = 0;
+            uint64_t lastRead = 0;
+            std::atomic<int> level;
+            std::mutex lock;
+    };
+
+    /**
+     * \brief The sink the logging macros find outside of classes that have their own
+     */
+    __attribute__((unused))
+    static LogSink* const logSink = nullptr;
 }
 
 #include <string.h>
@@ -97,12 +218,12 @@ namespace AI {
     #else
         /**
          * \def LOG_LOGIC_TO_COUT
-         * \brief If defined, all logic logging will be sent directly to std out
+         * \brief If defined, all logic logging will be sent to std out as well
          */
         #ifdef LOG_LOGIC_TO_COUT
-            #define LOG_LOGIC(msg) std::cout << LOG_FORMAT(Bot::playerToStr(this->player), YELLOW) << msg << std::endl
+            #define LOG_LOGIC(msg) LOG_TO_SINK_AND_COUT(LOGIC, msg, YELLOW)
         #else
-            #define LOG_LOGIC(msg) AI::logicLog.addLog(std::string(msg))
+            #define LOG_LOGIC(msg) LOG_TO_SINK(LOGIC, msg)
         #endif
     #endif
 
@@ -115,14 +236,35 @@ namespace AI {
     #else
         /**
          * \def LOG_INFO_TO_COUT
-         * \brief If defined, all informational logging will be sent directly to std out
+         * \brief If defined, all informational logging will be sent to std out as well
          */
         #ifdef LOG_INFO_TO_COUT
-            #define LOG_INFO(msg) std::cout << LOG_FORMAT(Bot::playerToStr(this->player), NORMAL) << msg << std::endl
+            #define LOG_INFO(msg) LOG_TO_SINK_AND_COUT(INFO, msg, NORMAL)
         #else
-            #define LOG_INFO(msg) AI::logicLog.addLog(std::string(msg))
+            #define LOG_INFO(msg) LOG_TO_SINK(INFO, msg)
         #endif
     #endif
+
+    /**
+     * \brief Sends a line to the logSink in scope (see AI::LogSink), the line is only built if the
+     * sink keeps the level
+     */
+    #define LOG_TO_SINK(level, msg) do { \
+            if (AI::LogSink::wants(logSink, AI::LogSink::level)) \
+                AI::LogSink::write(logSink, AI::LogSink::level, std::string(msg)); \
+        } while (0)
+
+    /**
+     * \brief Same as LOG_TO_SINK, but prints the line to std out too
+     */
+    #define LOG_TO_SINK_AND_COUT(level, msg, color) do { \
+            if (AI::LogSink::wants(logSink, AI::LogSink::level)) { \
+                std::string line(msg); \
+                std::cout << LOG_FORMAT(Bot::playerToStr(this->player), color) << line << \
+                    std::endl; \
+                AI::LogSink::write(logSink, AI::LogSink::level, line); \
+            } \
+        } while (0)
 #endif
 
 // vim: set expandtab textwidth=100:
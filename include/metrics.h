@@ -0,0 +1,209 @@
+/**
+ * \file metrics.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace AI {
+    /**
+     * \brief Call counts, latencies and work counters of a bot
+     *
+     * Every Bot keeps its own Metrics, see Bot::getMetrics(), and the metrics of many bots can be
+     * added together with merge(). The bot's entry points make its metrics the current ones for
+     * the thread while they run, so that code that doesn't know about the bot (like
+     * Position::path()) can still count its work with the METRIC_COUNT and METRIC_TIMER macros.
+     *
+     * The metrics are only gathered when compiled with METRICS defined. Otherwise the macros
+     * compile to nothing and the metrics stay empty.
+     */
+    class Metrics {
+        public:
+            enum Timer {
+                GET_MOVE,
+                GET_SUGGESTION,
+                GET_CARD,
+                NOTES_HOOK,
+                SEEN_PREDICTOR,
+                MULTIPLE_PREDICTOR,
+                NO_SHOW_PREDICTOR,
+                PROBABILITY_PREDICTOR,
+                THINK_AHEAD,
+                TIMER_COUNT
+            };
+
+            enum Counter {
+                /**
+                 * \brief Times runDeductors() was called
+                 */
+                DEDUCTOR_RUNS,
+
+                /**
+                 * \brief Passes over all the deductors that runDeductors() made to reach a fixpoint
+                 */
+                DEDUCTOR_ITERATIONS,
+
+                // facts produced by every deductor, in the same order as DeductionLog::Rule
+                LOCAL_EXCLUDE_FACTS,
+                NO_SHOW_FACTS,
+                SEEN_FACTS,
+                CARD_COUNT_EXCLUDE_FACTS,
+                CONSTRAINT_FACTS,
+
+                /**
+                 * \brief Calls to Position::path()
+                 */
+                PATH_CALLS,
+
+                /**
+                 * \brief Board searches, which every path() call not answered from the table of
+                 * the empty board and every Position::reach() does
+                 */
+                PATH_SEARCHES,
+
+                /**
+                 * \brief States taken from the queue by the board searches
+                 */
+                PATH_NODES,
+
+                /**
+                 * \brief Calls to Bot::getMove() and Bot::getSuggestion() answered with what
+                 * Bot::thinkAhead() worked out
+                 */
+                THOUGHT_ANSWERS,
+
+                /**
+                 * \brief Updates of the ProbabilityPredictor that gave up because they went over
+                 * the budget of edges
+                 */
+                PROBABILITY_FALLBACKS,
+                COUNTER_COUNT
+            };
+
+            /**
+             * \brief Amount of buckets in a latency histogram, bucket i counts the calls that
+             * took between 2^i and 2^(i + 1) nanoseconds
+             */
+            static const int BUCKETS = 40;
+
+            struct Histogram {
+                uint64_t calls = 0;
+                uint64_t totalNs = 0;
+                uint64_t maxNs = 0;
+                uint64_t buckets[BUCKETS] = {};
+
+                void add(uint64_t ns);
+                void merge(const Histogram& other);
+
+                /**
+                 * \returns the upper bound in nanoseconds of the bucket the fraction p of the
+                 * calls falls in (at most the longest call), 0 if there are no calls
+                 */
+                uint64_t percentile(double p) const;
+            };
+
+            Histogram timers[TIMER_COUNT];
+            uint64_t counters[COUNTER_COUNT] = {};
+
+            /**
+             * \brief Adds the metrics of other to these
+             */
+            void merge(const Metrics& other);
+
+            /**
+             * \returns true if nothing has been timed or counted
+             */
+            bool empty() const;
+
+            /**
+             * \brief Writes one line per timer and counter that isn't empty, as a name followed
+             * by key=value pairs (times are in microseconds), e.g.
+             * "getMove calls=12 mean_us=3.1 p50_us=4.1 p99_us=8.2 max_us=7.5"
+             */
+            void print(std::ostream& out) const;
+
+            static const char* name(Timer timer);
+            static const char* name(Counter counter);
+
+            /**
+             * \returns the metrics of the thread, nullptr if there are none
+             */
+            static Metrics* current()
+            {
+                return active;
+            }
+
+            /**
+             * \brief Adds to a counter of the current metrics, if there are any
+             */
+            static void count(Counter counter, uint64_t n = 1)
+            {
+                if (active)
+                    active->counters[counter] += n;
+            }
+
+            /**
+             * \brief Times the rest of the block it is declared in with a timer of the current
+             * metrics, or of the given metrics which are made the current ones until the end of
+             * the block
+             */
+            class Scope {
+                public:
+                    explicit Scope(Timer timer, Metrics* metrics = active) :
+                        metrics(metrics),
+                        previous(active),
+                        timer(timer),
+                        start(std::chrono::steady_clock::now())
+                    {
+                        active = metrics;
+                    }
+
+                    ~Scope()
+                    {
+                        if (metrics)
+                            metrics->timers[timer].add(std::chrono::duration_cast<
+                                    std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                        start).count());
+                        active = previous;
+                    }
+
+                    Scope(const Scope&) = delete;
+                    Scope& operator=(const Scope&) = delete;
+
+                private:
+                    Metrics* metrics;
+                    Metrics* previous;
+                    Timer timer;
+                    std::chrono::steady_clock::time_point start;
+            };
+
+        private:
+            static thread_local Metrics* active;
+    };
+}
+
+#ifdef METRICS
+    /**
+     * \brief Adds n to a counter of the current metrics, see AI::Metrics
+     */
+    #define METRIC_COUNT(counter, n) AI::Metrics::count(counter, n)
+
+    /**
+     * \brief Times the rest of the block with a timer of the current metrics
+     */
+    #define METRIC_TIMER(timer) AI::Metrics::Scope metricScope(timer)
+
+    /**
+     * \brief Makes metrics the current metrics for the rest of the block and times it
+     */
+    #define METRIC_SCOPE(timer, metrics) AI::Metrics::Scope metricScope(timer, &(metrics))
+#else
+    #define METRIC_COUNT(counter, n) do {} while (0)
+    #define METRIC_TIMER(timer) do {} while (0)
+    #define METRIC_SCOPE(timer, metrics) do {} while (0)
+#endif
+
+// vim: set expandtab textwidth=100:
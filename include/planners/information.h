@@ -0,0 +1,152 @@
+/**
+ * \file information.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "../bot.h"
+#include "../predictors/particle.h"
+#include <cstdint>
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Chooses the suggestion that is expected to tell us the most about the envelope
+     *
+     * The planner keeps a ParticlePredictor with a sample of the deals that agree with the notes
+     * and the log. For a suggestion, every deal determines who will show a card (or that nobody
+     * will) and which cards they can choose from, and we assume that they choose one at random.
+     * This gives the distribution of the answers we can get together with the envelope, from which
+     * the information gain is the entropy of the envelope minus the expected entropy once the
+     * answer is known.
+     *
+     * Since the room is fixed by where we are, only the 6x6 players and weapons are evaluated.
+     * Everything that doesn't depend on the suggestion (the envelope of every deal and how far
+     * after us every card is) is worked out once per update and shared between the candidates.
+     * The candidates are evaluated in order of how uncertain their cards are, until the time
+     * budget runs out.
+     */
+    class InformationPlanner {
+        public:
+            /**
+             * \param budget The most time to spend on evaluating candidates in microseconds, 0
+             * to always evaluate all of them
+             */
+            InformationPlanner(Bot::Player player, std::vector<Bot::Player> order, int budget,
+                    ParticleOptions options = ParticleOptions(), uint64_t seed = 0);
+
+            /**
+             * \brief Brings the sampled deals up to date with the notes and the log
+             * \returns false if there are no deals that agree with the notes and log
+             */
+            bool update(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log);
+
+            /**
+             * \brief Estimates how much the best suggestion in every room would tell us, for
+             * deciding where to move to
+             *
+             * Only the MOVE_CANDIDATES most uncertain player and weapon combinations are
+             * evaluated in every room, which is far less work than planning every room in full.
+             *
+             * \param gains The gain in every room, indexed by the Room enum
+             * \returns false if the notes and log contradict each other
+             */
+            bool roomGains(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log,
+                    double gains[Bot::MAX_ROOM + 1]);
+
+            /**
+             * \brief Amount of player and weapon combinations evaluated per room by roomGains()
+             */
+            static const int MOVE_CANDIDATES = 6;
+
+            /**
+             * \brief Chooses the player and weapon to suggest in the given room
+             * \param suggestion The suggestion to update, the room is set to the given room
+             * \returns false if the notes and log contradict each other, suggestion is left
+             * unchanged in that case
+             */
+            bool plan(Bot::Room room, const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log,
+                    Bot::Suggestion& suggestion);
+
+            /**
+             * \returns the expected reduction in the entropy of the envelope (in bits) if the
+             * suggestion is made, as of the last update
+             */
+            double gain(const Bot::Suggestion& suggestion);
+
+            /**
+             * \returns the entropy of the envelope in bits, as of the last update
+             */
+            double entropy() const;
+
+            /**
+             * \returns the amount of candidates that were evaluated by the last plan
+             */
+            int evaluated() const;
+
+        private:
+            static const int CARD_COUNT = Bot::NotesMatrix::CARD_COUNT;
+            static const int ENVELOPE_COUNT = (int(Bot::MAX_PLAYER) + 1) *
+                (int(Bot::MAX_WEAPON) + 1) * (int(Bot::MAX_ROOM) + 1);
+
+            static const int PAIR_COUNT = (int(Bot::MAX_PLAYER) + 1) * (int(Bot::MAX_WEAPON) + 1);
+
+            /**
+             * \brief The answers are nobody showing or a player showing one of the three cards
+             */
+            static const int ANSWER_COUNT = 1 + 3 * Bot::NotesMatrix::PLAYER_COUNT;
+
+            /**
+             * \brief Distance of a card that nobody can show
+             */
+            static const uint8_t NOBODY = 0xff;
+
+            std::vector<Bot::Player> order;
+            Bot::Player player;
+            int budget;
+            ParticlePredictor particles;
+
+            /**
+             * \brief The envelope of every deal
+             */
+            std::vector<int> envelopes;
+
+            /**
+             * \brief How many places after us the player with the card sits for every deal, or
+             * NOBODY if it is ours, on the table or in the envelope
+             */
+            std::vector<uint8_t> distances;
+
+            double envelopeEntropy;
+            int candidates;
+
+            /**
+             * \brief The player and weapon combinations (player * weapons + weapon), the ones
+             * we are least sure about first
+             */
+            int ranked[PAIR_COUNT];
+
+            /**
+             * \brief The amount of deals with every envelope
+             */
+            std::vector<int> envelopeCounts;
+
+            /**
+             * \brief The weight of a deal, which a player that can choose between two or three
+             * cards splits evenly between them
+             */
+            static const int WEIGHT = 6;
+
+            // the joint weights of the answers and envelopes, reused between candidates
+            std::vector<int> joint;
+            std::vector<int> touched;
+            int answers[ANSWER_COUNT];
+
+            /**
+             * \brief w * log2(w) for every weight w, so that the entropies need no logarithms
+             */
+            std::vector<double> xlogx;
+    };
+}
+
+// vim: set expandtab textwidth=100:
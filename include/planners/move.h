@@ -0,0 +1,57 @@
+/**
+ * \file move.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "../board.h"
+#include "../position.h"
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Chooses where to move to by what the suggestion in every room is worth
+     *
+     * Every room is given the value of the best suggestion that can be made in it (e.g. by
+     * InformationPlanner::roomGains()). The rooms that can be reached with the dice roll are worth
+     * their full value, while the rooms further away are discounted by the amount of turns they
+     * would still take on an average dice roll. The planner moves to the room with the highest
+     * value, or as far as it can towards it if it can't be reached this turn. Staying in the
+     * current room is also a choice.
+     *
+     * A single search gives the distances to all the rooms, and on the empty board it is copied
+     * from the table the paths are looked up in, so planning a move doesn't allocate any memory.
+     */
+    class MovePlanner {
+        public:
+            MovePlanner();
+
+            /**
+             * \brief Chooses the position to move to
+             * \param start The position we are in
+             * \param allowedMoves The dice roll
+             * \param values The value of the best suggestion in every room, indexed by board
+             * position. The middle room (position 0) is never chosen.
+             * \returns the position to move to, or start if no room is worth anything
+             */
+            int plan(int start, int allowedMoves, const double values[Board::ROOM_COUNT]);
+
+            /**
+             * \brief Factor a room's value is multiplied with for every turn it takes to reach it
+             */
+            static constexpr double DISCOUNT = 0.5;
+
+            /**
+             * \brief The average roll of two dice, used to estimate the turns to reach a room
+             */
+            static const int AVERAGE_ROLL = 7;
+
+        private:
+            /**
+             * \brief Always empty, the bot can move through other players
+             */
+            std::vector<bool> occupied;
+    };
+}
+
+// vim: set expandtab textwidth=100:
@@ -5,7 +5,9 @@
 
 #pragma once
 #include "macros.h"
+#include "board.h"
 #include <vector>
+#include <cstdint>
 
 namespace AI {
     /**
@@ -94,6 +96,81 @@ namespace AI {
                     std::vector<int> path;
             };
 
+            /**
+             * \brief The shortest paths from one position to every other position
+             *
+             * This holds the result of a single search from a starting position, so the distance
+             * and path to any destination can be asked for without searching again. This should be
+             * used whenever more than one destination is of interest, e.g. when looking for the
+             * closest room. On the empty board with one turn the paths are copied from the same
+             * table path() uses, so no search is done at all.
+             */
+            class Reach {
+                public:
+                    /**
+                     * \brief Searches from start to every position on the board
+                     * \param start the position to search from
+                     * \param occupied positions on the board occupied by other players
+                     * \param turns the amount of turns that can be used, see Position::path()
+                     * \throw std::invalid_argument if occupied isn't the correct size or if turns
+                     * is less than 1
+                     */
+                    Reach(int start, const std::vector<bool>& occupied, int turns);
+
+                    /**
+                     * \returns true if there is a path to pos
+                     */
+                    bool reachable(int pos) const;
+
+                    /**
+                     * \brief Returns the distance to pos
+                     * \throw std::runtime_error if pos can't be reached
+                     */
+                    int distance(int pos) const;
+
+                    /**
+                     * \brief Returns the first position on the path to pos, or pos itself if it
+                     * is the starting position
+                     * \throw std::runtime_error if pos can't be reached
+                     */
+                    int next(int pos) const;
+
+                    /**
+                     * \brief Returns the path to pos, this is the same path Position::path() finds
+                     * \throw std::runtime_error if pos can't be reached
+                     */
+                    Path path(int pos) const;
+
+                    /**
+                     * \brief Returns how far along the path to pos you can get in the moves given,
+                     * the same as path(pos).partial(moves) but without building the path
+                     * \throw std::runtime_error if pos can't be reached
+                     */
+                    int partial(int pos, int moves) const;
+
+                    /**
+                     * \brief Amount of search states, a state is a position and the amount of
+                     * turns left when it was reached
+                     */
+                    static const int STATES = Board::BOARD_SIZE * Board::ROOM_COUNT;
+
+                private:
+                    void check(int pos) const;
+
+                    int start;
+                    uint8_t dist[Board::BOARD_SIZE];
+
+                    /**
+                     * \brief The state every position was reached in, or -1
+                     */
+                    int16_t best[Board::BOARD_SIZE];
+
+                    /**
+                     * \brief The state every state was reached from, or -1 for the start
+                     */
+                    int16_t parent[STATES];
+            };
+
             /**
              * \param pos This is the integer position used in the board layout
              * \throw std::invalid_argument if position is not a valid board position
@@ -102,15 +179,16 @@ namespace AI {
 
             /**
              * \brief Returns the valid neighbours of the current position
-             * \returns position's valid neighbours
+             * \returns position's valid neighbours, a view into the board graph that doesn't copy
              */
-            std::vector<int> getNeighbours();
+            Board::Neighbours getNeighbours() const;
 
             /**
              * \brief Returns the shortest path to another position
              *
              * This returns the shortest path from this board position to another position. By
-             * making turns more than one, shortcuts through rooms can also be used
+             * making turns more than one, shortcuts through rooms can also be used. Every room that
+             * is passed through uses up a turn, so at most turns - 1 rooms can be passed through.
              *
              * \param other the other Position
              * \param occupied positions on the board occupied by other players
@@ -121,14 +199,28 @@ namespace AI {
              * \throw std::runtime_error if no path can be found to destination - this should only
              * happen when a tile is blocked because all the neighbours to the tile is occupied
              */
-            Path path(const Position other, std::vector<bool> occupied, int turns);
+            Path path(const Position other, const std::vector<bool>& occupied, int turns);
 
             /**
              * \brief Overload for path() with occupied all false and turns = 1
-             * \note This class is intended to ease unit testing.
+             *
+             * The shortest paths on the empty board never change, so they are worked out once for
+             * all positions the first time they are needed and looked up from then on. The paths
+             * are the same as the ones path() would find.
              */
             Path path(const Position other);
 
+            /**
+             * \brief Returns the distance to another position with occupied all false and turns = 1
+             *
+             * This is the same as int(path(other)), but doesn't build the path.
+             *
+             * \param other the other Position
+             * \returns the distance
+             * \throw std::runtime_error if no path can be found to destination
+             */
+            int distance(const Position other) const;
+
             /**
              * \brief Overload for path() with occupied all false
              * \note This class is intended to ease unit testing.
@@ -139,7 +231,20 @@ namespace AI {
              * \brief Overload for path() with turns = 1
              * \note This class is intended to ease unit testing.
              */
-            Path path(const Position other, std::vector<bool> occupied);
+            Path path(const Position other, const std::vector<bool>& occupied);
+
+            /**
+             * \brief Returns the shortest paths from this position to every other position
+             *
+             * This does a single search, where asking path() for every destination would search
+             * once per destination.
+             *
+             * \param occupied positions on the board occupied by other players
+             * \param turns the amount of turns that can be used, see path()
+             * \throw std::invalid_argument if occupied isn't the correct size or if turns is less
+             * than 1
+             */
+            Reach reach(const std::vector<bool>& occupied, int turns = 1) const;
 
             /**
              * \brief Allows casting the position to an int where the int is the position on the
@@ -148,24 +253,6 @@ namespace AI {
             operator int() const;
 
         private:
-            /**
-             * \brief Used to passed along info from one recursion to the next of the shortestPath()
-             * fuction
-             */
-            struct SPInfo {
-                int start;
-                int dest;
-                std::vector<bool> occupied;
-                std::vector<bool> visited;
-                /**
-                 * \brief Will be updated during execution to always have to shortest path to a node
-                 * from the starting point
-                 */
-                std::vector<Path> spMap;
-            };
-
-            void shortestPath(SPInfo& info, int turns);
-
             const int position;
     };
 }
@@ -7,6 +7,8 @@
 
 #include "bot.h"
 #include "deck.h"
+#include "deduction-log.h"
+#include "metrics.h"
 #include <map>
 
 namespace AI {
@@ -25,14 +27,33 @@ namespace AI {
             /**
              * \brief Attempt to make a prediction about high-probability envelope cards
              */
-            virtual void run(Deck& deck, std::map<Bot::Player,
-                    std::map<Bot::Card, Bot::Notes>> notes, Bot::SuggestionLog log) =0;
+            virtual void run(Deck& deck, const Bot::NotesMatrix& notes,
+                    const Bot::SuggestionLog& log) =0;
+
+            /**
+             * \brief Sets the log the predictions are recorded in, nullptr to stop recording them
+             */
+            void setDeductionLog(DeductionLog* log);
+
+            /**
+             * \brief Sets the sink the predictor logs to, nullptr to log to the LogicLog
+             */
+            void setLogSink(LogSink* sink);
 
         protected:
             bool contains(Deck& deck, Bot::Player player);
             bool contains(Deck& deck, Bot::Weapon weapon);
             bool contains(Deck& deck, Bot::Room room);
+
+            /**
+             * \brief Records a prediction in the deduction log, or logs it if there is no
+             * deduction log
+             */
+            void predicted(DeductionLog::Rule rule, DeductionLog::Fact fact, const Bot::Card& card);
+
             Bot::Player player;
+            DeductionLog* deductions = nullptr;
+            LogSink* logSink = nullptr;
     };
 }
 
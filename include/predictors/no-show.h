@@ -15,8 +15,8 @@ namespace AI {
         public:
             NoShowPredictor(Bot::Player player);
 
-            void run(Deck& deck, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes,
-                    Bot::SuggestionLog log) override;
+            void run(Deck& deck, const Bot::NotesMatrix& notes,
+                    const Bot::SuggestionLog& log) override;
     };
 }
 
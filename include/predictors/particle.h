@@ -0,0 +1,162 @@
+/**
+ * \file particle.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "../predictor.h"
+#include "../random.h"
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Options for the ParticlePredictor
+     */
+    struct ParticleOptions {
+        /**
+         * \brief What to do with the particles that no longer agree with the notes and log
+         */
+        enum Policy {
+            /**
+             * \brief Drop them, and only make new particles once fewer than minAlive are left
+             */
+            REJECT,
+
+            /**
+             * \brief Replace every one of them straight away with a copy of a particle that
+             * still agrees
+             */
+            RESAMPLE
+        };
+
+        /**
+         * \brief Amount of deals to keep
+         */
+        int particles = 1000;
+
+        Policy policy = RESAMPLE;
+
+        /**
+         * \brief Fraction of the particles that must be left before REJECT makes new ones
+         */
+        double minAlive = 0.5;
+
+        /**
+         * \brief Amount of swaps made to every new copy of a particle, so that the copies don't
+         * stay identical
+         */
+        int moves = 50;
+    };
+
+    /**
+     * \brief Estimates the probability of every card being in the envelope from a sample of deals
+     *
+     * The predictor keeps a pool of complete deals (particles) that agree with everything that is
+     * known: the cards players have and lack, the table cards, the hand sizes and the shows in
+     * the suggestion log. Every update only checks the particles against what changed since the
+     * previous update, so an event costs one check per particle instead of solving the whole
+     * problem again like the ProbabilityPredictor does. The particles that no longer agree are
+     * handled according to the ParticleOptions::Policy. A new copy of a particle is mixed by
+     * swapping random pairs of cards between hands, keeping only the swaps after which the deal
+     * still agrees with everything.
+     *
+     * The probability of a card being in a hand is the fraction of the particles that have it
+     * there, which takes a single pass over the particles.
+     */
+    class ParticlePredictor : public Predictor {
+        public:
+            ParticlePredictor(Bot::Player player, std::vector<Bot::Player> order,
+                    ParticleOptions options = ParticleOptions(), uint64_t seed = 0);
+
+            /**
+             * \brief Lowers the score of every card in the deck by its probability of being in
+             * the envelope, in the same way as the ProbabilityPredictor
+             */
+            void run(Deck& deck, const Bot::NotesMatrix& notes,
+                    const Bot::SuggestionLog& log) override;
+
+            /**
+             * \brief Brings the particles up to date with the notes and the log
+             *
+             * Only the log entries and notes that changed since the last call are checked.
+             *
+             * \returns false if there are no particles that agree with the notes and log
+             */
+            bool update(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log);
+
+            /**
+             * \returns the fraction of the particles that have the card in the envelope
+             */
+            double envelope(const Bot::Card& card) const;
+
+            /**
+             * \returns the fraction of the particles in which the player has the card
+             */
+            double has(Bot::Player player, const Bot::Card& card) const;
+
+            /**
+             * \returns the amount of particles that agree with the notes and log
+             */
+            int alive() const;
+
+            /**
+             * \returns the hands of a particle, the players in order and the envelope last
+             */
+            const Bot::NotesMatrix::CardMask* hands(int particle) const
+            {
+                return particles[particle].hands;
+            }
+
+        private:
+            static const int CARD_COUNT = Bot::NotesMatrix::CARD_COUNT;
+            static const int LOCATION_COUNT = Bot::NotesMatrix::PLAYER_COUNT + 1;
+
+            /**
+             * \brief A complete deal, the hand of every player in order and the envelope last
+             */
+            struct Particle {
+                Bot::NotesMatrix::CardMask hands[LOCATION_COUNT];
+            };
+
+            /**
+             * \brief A player that has at least one of the cards
+             */
+            struct Show {
+                int location;
+                Bot::NotesMatrix::CardMask cards;
+            };
+
+            void reset();
+            bool agrees(const Particle& p, const Bot::NotesMatrix::CardMask* has,
+                    const Bot::NotesMatrix::CardMask* lacks, size_t firstShow) const;
+            bool deal(Particle& p);
+            bool repair(Particle& p);
+            void mix(Particle& p, int moves);
+            int locationOf(const Particle& p, int card) const;
+            bool canSwap(int a, int la, int b, int lb) const;
+            int violations(const Particle& p, int location) const;
+            void refill();
+            void count();
+
+            std::vector<Bot::Player> order;
+            ParticleOptions options;
+            Random rng;
+
+            // everything that is known, the hands of players in order and the envelope last
+            Bot::NotesMatrix::CardMask hasCards[LOCATION_COUNT];
+            Bot::NotesMatrix::CardMask lacksCards[LOCATION_COUNT];
+            Bot::NotesMatrix::CardMask tableCards;
+            int sizes[LOCATION_COUNT];
+            std::vector<Show> shows;
+            std::vector<Bot::NotesMatrix::CardMask> showsOf[LOCATION_COUNT];
+            size_t logSize;
+            bool started;
+
+            std::vector<Particle> particles;
+            std::vector<Particle> next;
+
+            double probs[LOCATION_COUNT][CARD_COUNT];
+    };
+}
+
+// vim: set expandtab textwidth=100:
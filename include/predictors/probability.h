@@ -0,0 +1,174 @@
+/**
+ * \file probability.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "../predictor.h"
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Calculates the exact probability of every card being in the envelope
+     *
+     * Instead of looking for patterns in the log like the other predictors, this predictor counts
+     * all the ways the cards could have been dealt that agree with everything that is known: the
+     * cards players have and lack, the table cards, the amount of cards every player was dealt and
+     * the suggestion log (a player that showed a card has at least one of the suggested cards, and
+     * the players before them have none of them). Every one of these deals is equally likely, so
+     * the fraction of the deals that have a card in the envelope is the probability that the card
+     * is in the envelope.
+     *
+     * The deals aren't enumerated one by one. The unknown cards are handed out one at a time, and
+     * deals that have handed out the same amount of cards to every player are counted together,
+     * so the work depends on the amount of cards players still need and not on the amount of
+     * deals. A player that showed a card for a suggestion has one of the suggested cards, so for
+     * every such suggestion a flag is kept that is set once the player receives one of the cards,
+     * and deals that never set it are dropped. The cards are handed out in an order that keeps as
+     * few of these flags open at the same time as possible.
+     *
+     * The counts are computed forwards and backwards over the cards, which gives the probability
+     * of every card being in every player's hand in the same pass.
+     *
+     * Early in a game with many players the amount of states can get large. The work done by an
+     * update is bounded by a budget on the amount of edges between states, and an update that
+     * needs more gives up and leaves the ranking of the cards to the other predictors.
+     */
+    class ProbabilityPredictor : public Predictor {
+        public:
+            /**
+             * \param maxEdges the budget of an update, see MAX_EDGES
+             */
+            ProbabilityPredictor(Bot::Player player, std::vector<Bot::Player> order,
+                    size_t maxEdges = MAX_EDGES);
+
+            /**
+             * \brief Lowers the score of every card in the deck by its probability of being in
+             * the envelope, so that Deck::sort ranks the cards by probability
+             *
+             * The scores are scaled by SCORE_SCALE so that the probability outweighs the other
+             * predictors, which then only break ties.
+             */
+            void run(Deck& deck, const Bot::NotesMatrix& notes,
+                    const Bot::SuggestionLog& log) override;
+
+            /**
+             * \brief Counts the deals that agree with the notes and the log
+             *
+             * Nothing is recalculated if the notes and the log haven't changed since the last
+             * call.
+             *
+             * \returns false if no deal agrees with the notes and log, or if the problem is too
+             * large to count (see MAX_OPEN_SHOWS and MAX_EDGES). The probabilities are all zero
+             * in that case.
+             */
+            bool update(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log);
+
+            /**
+             * \returns true if the last update() gave up because it needed more edges than its
+             * budget
+             */
+            bool overBudget() const;
+
+            /**
+             * \returns the probability that the card is in the envelope, as of the last update()
+             */
+            double envelope(const Bot::Card& card) const;
+
+            /**
+             * \returns the probability that the player has the card, as of the last update()
+             */
+            double has(Bot::Player player, const Bot::Card& card) const;
+
+            /**
+             * \returns the amount of deals that agree with the notes and log, as of the last
+             * update()
+             */
+            double deals() const;
+
+            static const int SCORE_SCALE = 1000;
+
+            /**
+             * \brief The most shows that can be waiting for one of their cards to be handed out
+             * at the same time
+             */
+            static const int MAX_OPEN_SHOWS = 36;
+
+            /**
+             * \brief The default for the most edges between states an update may go through
+             *
+             * The time an update takes grows with the amount of edges, this keeps it to a few
+             * milliseconds.
+             */
+            static const size_t MAX_EDGES = 32768;
+
+        private:
+            static const int CARD_COUNT = Bot::NotesMatrix::CARD_COUNT;
+            static const int PLAYER_COUNT = Bot::NotesMatrix::PLAYER_COUNT;
+
+            /**
+             * \brief A player that has at least one of the cards
+             */
+            struct Show {
+                int location;
+                Bot::NotesMatrix::CardMask cards;
+                int first;
+                int last;
+                int slot;
+            };
+
+            struct Entry {
+                uint64_t key;
+                double count;
+            };
+
+            /**
+             * \brief Handing the card of a step to a location, from one state to the next
+             */
+            struct Edge {
+                uint64_t key;
+                uint32_t from;
+                uint32_t to;
+                int location;
+                bool operator<(const Edge& other) const { return key < other.key; }
+            };
+
+            bool count();
+            bool transition(uint64_t key, int step, int location, uint64_t& next) const;
+            bool feasible(uint64_t key, int step) const;
+
+            std::vector<Bot::Player> order;
+            size_t maxEdges;
+            bool exceeded;
+
+            // the inputs of the last update, used to skip recalculations
+            Bot::NotesMatrix::CardMask hasCards[PLAYER_COUNT];
+            Bot::NotesMatrix::CardMask lacksCards[PLAYER_COUNT];
+            Bot::NotesMatrix::CardMask tableCards;
+            Bot::NotesMatrix::CardMask envelopeCards;
+            size_t logSize;
+            bool valid;
+            bool consistent;
+
+            // the problem, built by update() and solved by count()
+            std::vector<int> quotas;
+            std::vector<Show> shows;
+            std::vector<int> cards;
+            std::vector<uint8_t> allowed;
+            std::vector<std::vector<uint64_t>> openBits;
+            std::vector<uint64_t> closeBits;
+            std::vector<std::vector<int>> remaining;
+            uint64_t envelopeNeeded;
+
+            std::vector<std::vector<Entry>> layers;
+            std::vector<double> backward;
+            std::vector<double> nextBackward;
+            std::vector<std::vector<Edge>> edges;
+
+            double total;
+            double envelopeProb[CARD_COUNT];
+            double hasProb[PLAYER_COUNT][CARD_COUNT];
+    };
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,129 @@
+/**
+ * \file protocol.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "bot.h"
+#include "string-view.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Plays the bots of many games for a server that talks to them through a file descriptor
+     *
+     * The driver reads lines from one file descriptor (stdin, a pipe or a socket), passes them on
+     * to the bots and writes the answers to another. Every line starts with the id of the game it
+     * is for, so one connection can play any amount of games at the same time. The games are
+     * played in the order their lines arrive, and a line can be sent before the answer to the one
+     * before it arrived.
+     *
+     * The lines the server sends, with cards, players and rooms named like in the comms protocol
+     * (see Bot::Card::parse()) and lists separated by commas:
+     *
+     * - `<game> new <player> <order> [seed]` starts a game with a bot for player, see Bot::Bot().
+     *   The order must hold at least 3 different players, one of which is the bot's player.
+     * - `<game> end` ends a game and deletes its bot
+     * - `<game> cards <cards>` and `<game> table <cards>`, see Bot::setCards()
+     * - `<game> board <player>:<position>,...`, see Bot::updateBoard()
+     * - `<game> move <player> <position>`, see Bot::movePlayer()
+     * - `<game> suggest <player> <player>,<weapon>,<room>`, see Bot::madeSuggestion(), and
+     *   `<game> accuse ...` for a wrong accusation
+     * - `<game> shown <player>` and `<game> noshown`, see Bot::otherShownCard() and
+     *   Bot::noOtherShownCard()
+     * - `<game> showcard <player> <card>` and `<game> noshowcard`, see Bot::showCard() and
+     *   Bot::noShowCard()
+     * - `<game> turn`, see Bot::newTurn()
+     * - `<game> getmove <roll>`, answered with `<game> move <position>`
+     * - `<game> getsuggestion`, answered with `<game> suggestion <player>,<weapon>,<room>`
+     * - `<game> getcard <player> <cards>`, answered with `<game> card <card>`
+     *
+     * Events aren't answered, unless they fail. A line that can't be handled is answered with
+     * `<game> error <message>`, or `error <message>` if it doesn't start with a game id, and the
+     * game carries on.
+     *
+     * Input is read and answers are written in blocks of up to BUFFER_SIZE bytes. The answers to
+     * all the lines of a block are written together once the block has been handled. The lines
+     * are parsed in place, so handling an event doesn't allocate beyond what the bot does.
+     */
+    class ProtocolDriver {
+        public:
+            /**
+             * \brief The size of the input and output buffers, and the longest line that can be
+             * read
+             */
+            static const size_t BUFFER_SIZE = 64 * 1024;
+
+            /**
+             * \param in the file descriptor the lines are read from
+             * \param out the file descriptor the answers are written to, can be the same as in
+             * \note The driver doesn't close the file descriptors
+             */
+            ProtocolDriver(int in, int out);
+
+            /**
+             * \brief Handles lines until in is closed, then writes the last answers
+             * \throw std::runtime_error if reading or writing fails
+             */
+            void run();
+
+            /**
+             * \brief Handles a single line, without its newline, and buffers its answer
+             *
+             * The answers are written once the buffer is full or by flush().
+             * \throw std::runtime_error if writing fails
+             */
+            void handle(StringView line);
+
+            /**
+             * \brief Writes the buffered answers
+             * \throw std::runtime_error if writing fails
+             */
+            void flush();
+
+            /**
+             * \returns the amount of games that haven't ended
+             */
+            int games() const;
+
+        private:
+            int in;
+            int out;
+
+            std::unique_ptr<char[]> input;
+            std::string output;
+
+            std::unordered_map<uint64_t, std::unique_ptr<Bot>> bots;
+
+            // kept between lines so that their memory is reused
+            std::vector<Bot::Card> cards;
+            std::vector<Bot::Player> players;
+            std::vector<std::pair<Bot::Player, Position>> board;
+
+            void command(uint64_t game, StringView line);
+
+            /**
+             * \throw std::invalid_argument if the game hasn't started
+             */
+            Bot& bot(uint64_t game);
+
+            // the start of an answer, the caller appends the rest of the line
+            void reply(uint64_t game, StringView kind);
+
+            /**
+             * \param game the game the line was for, null if the line had no game id
+             */
+            void error(const uint64_t* game, StringView message);
+
+            void append(StringView s);
+            void append(uint64_t number);
+    };
+}
+
+// vim: set expandtab textwidth=100:
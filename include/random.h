@@ -0,0 +1,104 @@
+/**
+ * \file random.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include <cstdint>
+
+namespace AI {
+    /**
+     * \brief Small and fast pseudo random number generator
+     *
+     * This is the xoshiro128** generator. Unlike rand() it doesn't share any state, so every bot
+     * (and every simulated game) can have its own generator. This means that a game can be played
+     * again exactly by using the same seeds, and that bots running on different threads don't
+     * contend for the lock libc keeps around rand()'s state.
+     *
+     * The class meets the requirements of a uniform random bit generator, so it can also be used
+     * with the standard library's distributions and algorithms.
+     */
+    class Random {
+        public:
+            typedef uint32_t result_type;
+
+            /**
+             * \param seed any value is fine, the state is derived from it with splitmix64
+             */
+            explicit Random(uint64_t seed = 0)
+            {
+                for (int i = 0; i < 4; i++) {
+                    seed += 0x9e3779b97f4a7c15;
+                    uint64_t z = seed;
+                    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                    state[i] = uint32_t((z ^ (z >> 31)) >> 32);
+                }
+            }
+
+            /**
+             * \returns the next random number
+             */
+            result_type operator()()
+            {
+                const uint32_t result = rotl(state[1] * 5, 7) * 9;
+                const uint32_t t = state[1] << 9;
+
+                state[2] ^= state[0];
+                state[3] ^= state[1];
+                state[1] ^= state[2];
+                state[0] ^= state[3];
+                state[2] ^= t;
+                state[3] = rotl(state[3], 11);
+
+                return result;
+            }
+
+            /**
+             * \returns a 64-bit random number, useful to seed another generator with
+             */
+            uint64_t seed()
+            {
+                uint64_t high = (*this)();
+                return (high << 32) | (*this)();
+            }
+
+            static constexpr result_type min() { return 0; }
+            static constexpr result_type max() { return UINT32_MAX; }
+
+            /**
+             * \brief Amount of words in the state of the generator
+             */
+            static const int STATE_SIZE = 4;
+
+            /**
+             * \brief Copies the state of the generator, so that it can be continued later with
+             * restore()
+             */
+            void save(uint32_t out[STATE_SIZE]) const
+            {
+                for (int i = 0; i < STATE_SIZE; i++)
+                    out[i] = state[i];
+            }
+
+            /**
+             * \brief Continues from a state copied with save()
+             * \note The state may not be all zeros, the generator would only return zeros then
+             */
+            void restore(const uint32_t in[STATE_SIZE])
+            {
+                for (int i = 0; i < STATE_SIZE; i++)
+                    state[i] = in[i];
+            }
+
+        private:
+            static uint32_t rotl(uint32_t x, int k)
+            {
+                return (x << k) | (x >> (32 - k));
+            }
+
+            uint32_t state[STATE_SIZE];
+    };
+}
+
+// vim: set expandtab textwidth=100:
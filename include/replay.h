@@ -0,0 +1,192 @@
+/**
+ * \file replay.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "bot.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief The events in a replay record, see ReplayRecorder for the format
+     */
+    enum ReplayEvent {
+        REPLAY_SET_CARDS,
+        REPLAY_SET_TABLE_CARDS,
+        REPLAY_UPDATE_BOARD,
+        REPLAY_MOVE_PLAYER,
+        REPLAY_MADE_SUGGESTION,
+        REPLAY_MADE_ACCUSATION,
+        REPLAY_OTHER_SHOWN_CARD,
+        REPLAY_NO_OTHER_SHOWN_CARD,
+        REPLAY_SHOW_CARD,
+        REPLAY_NO_SHOW_CARD,
+        REPLAY_NEW_TURN,
+        REPLAY_GET_MOVE,
+        REPLAY_GET_SUGGESTION,
+        REPLAY_GET_CARD,
+        REPLAY_EVENT_COUNT
+    };
+
+    /**
+     * \brief Records everything a single bot is told and chooses during a game
+     *
+     * A replay file starts with the magic bytes "CLRP" and a version byte (see
+     * writeReplayHeader()), after which any amount of records follow. Records are only ever
+     * appended, so games can be added to an existing file. Every record is a 4 byte length followed
+     * by that many bytes:
+     *
+     * - the bot's player, strategy, planning budget (4 bytes), seed (8 bytes), the amount of
+     *  players and the order of the players
+     * - the events, every one is a byte with the ReplayEvent in the low four bits and a player in
+     *  the high four bits (0 if the event has no player), followed by its arguments:
+     *  - set cards and set table cards: the cards as a 3 byte card mask (see
+     *   Bot::NotesMatrix::index())
+     *  - update board: the amount of players, then a player and a position for every one of them
+     *  - move player: the position
+     *  - made suggestion and made accusation: the suggestion in 2 bytes
+     *  - show card: the card index
+     *  - get move: the dice roll and the position the bot chose
+     *  - get suggestion: the suggestion the bot chose in 2 bytes
+     *  - get card: the cards to choose from as a 3 byte card mask and the card index the bot chose
+     *
+     * All multi-byte values are little-endian. Suggestions are stored as
+     * (player * weapons + weapon) * rooms + room.
+     *
+     * The choices the bot made are recorded too, so that a replay can tell when a bot chooses
+     * differently from the bot that was recorded.
+     */
+    class ReplayRecorder {
+        public:
+            ReplayRecorder(Bot::Player player, std::vector<Bot::Player> order, uint64_t seed,
+                    Bot::Strategy strategy = Bot::HEURISTIC, int budget = 0);
+
+            void setCards(const std::vector<Bot::Card>& cards, bool table = false);
+            void updateBoard(const std::vector<std::pair<Bot::Player, Position>>& players);
+            void movePlayer(Bot::Player player, int position);
+            void madeSuggestion(Bot::Player player, Bot::Suggestion suggestion,
+                    bool accuse = false);
+            void otherShownCard(Bot::Player showed);
+            void noOtherShownCard();
+            void showCard(Bot::Player player, Bot::Card card);
+            void noShowCard();
+            void newTurn();
+
+            /**
+             * \brief Records that the bot chose to move to position with the dice roll
+             */
+            void getMove(int allowedMoves, int position);
+
+            /**
+             * \brief Records the suggestion the bot chose
+             */
+            void getSuggestion(Bot::Suggestion suggestion);
+
+            /**
+             * \brief Records the card the bot chose to show
+             * \note The cards are stored as a mask, so they are replayed in card index order
+             */
+            void getCard(Bot::Player player, const std::vector<Bot::Card>& cards, Bot::Card card);
+
+            /**
+             * \brief Appends the record (with its length) to a replay file's data
+             */
+            void finish(std::vector<uint8_t>& out) const;
+
+        private:
+            void event(ReplayEvent e, int player = 0);
+            void cards(Bot::NotesMatrix::CardMask mask);
+            void suggestion(Bot::Suggestion suggestion);
+
+            std::vector<uint8_t> data;
+    };
+
+    /**
+     * \brief Starts a new replay file
+     */
+    void writeReplayHeader(std::vector<uint8_t>& out);
+
+    /**
+     * \brief Statistics gathered while replaying records
+     */
+    struct ReplayStats {
+        long games = 0;
+        long events = 0;
+
+        /**
+         * \brief Amount of choices (moves, suggestions and cards to show) that were compared
+         */
+        long decisions = 0;
+
+        /**
+         * \brief Amount of choices where the bot chose differently from the recording
+         */
+        long divergences = 0;
+
+        /**
+         * \brief Amount of records with at least one divergence
+         */
+        long divergentGames = 0;
+
+        /**
+         * \brief Amount of records that are damaged or where the bot threw an exception
+         */
+        long errors = 0;
+
+        /**
+         * \brief The message of the first error or divergence, if any
+         */
+        std::string error;
+
+        /**
+         * \brief Wall clock time the replay took
+         */
+        double seconds = 0;
+
+        void merge(const ReplayStats& other);
+    };
+
+    /**
+     * \brief Replays a single record (without its length) through a new Bot
+     *
+     * The bot is created with the recorded player, order, seed and strategy, and is given the
+     * events in the recorded order. The recorded choices are compared to the ones the bot makes,
+     * but the game continues with the recorded events either way.
+     *
+     * \throw std::invalid_argument if the record is damaged
+     */
+    void replayRecord(const uint8_t* data, size_t size, ReplayStats& stats);
+
+    /**
+     * \brief Replays all the records in the data of a replay file on a pool of threads
+     * \param threads Amount of threads to replay on, 0 to use all the hardware threads
+     * \throw std::invalid_argument if the data isn't a replay file
+     */
+    ReplayStats replayData(const uint8_t* data, size_t size, int threads = 0);
+
+    /**
+     * \brief Maps a replay file into memory and replays it with replayData()
+     * \throw std::runtime_error if the file can't be read
+     * \throw std::invalid_argument if the file isn't a replay file
+     */
+    ReplayStats replayFile(const std::string& path, int threads = 0);
+
+    /**
+     * \brief Appends the data of a replay file to a file, starting it if it doesn't exist yet
+     * \throw std::runtime_error if the file can't be written
+     * \throw std::invalid_argument if the file exists but isn't a replay file
+     */
+    void appendReplayFile(const std::string& path, const std::vector<uint8_t>& records);
+
+    /**
+     * \brief Prints the amount of games and events, the speed and the divergences of a replay
+     */
+    void printReplayStats(std::ostream& out, const ReplayStats& stats);
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,174 @@
+/**
+ * \file simulator.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include "metrics.h"
+#include "random.h"
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace AI {
+    /**
+     * \brief Options for a single simulated game
+     */
+    struct GameOptions {
+        /**
+         * \brief Amount of players in the game, 0 to choose between 4 and 6 players at random
+         */
+        int players = 0;
+
+        /**
+         * \brief Amount of players that are played by the AI, the rest are played by the reference
+         * bot (DumbBot)
+         */
+        int smart = 1;
+
+        /**
+         * \brief Let the AI players choose their suggestions with the Bot::INFORMATION strategy
+         */
+        bool planner = false;
+
+        /**
+         * \brief Replace every AI player with a new bot restored from a snapshot of it after every
+         * event, which should play exactly the same game as keeping the same bots
+         */
+        bool migrate = false;
+
+        /**
+         * \brief Let every AI player think ahead (see Bot::thinkAhead()) as far as it can after
+         * every event, which should play exactly the same game as not thinking ahead
+         */
+        bool thinkAhead = false;
+
+        /**
+         * \brief If set, a replay record of every AI player's game is appended to it once the game
+         * is finished, see ReplayRecorder
+         */
+        std::vector<uint8_t>* record = nullptr;
+
+        /**
+         * \brief If set, the metrics of every AI player are added to it once the game is finished,
+         * see Metrics
+         */
+        Metrics* metrics = nullptr;
+    };
+
+    /**
+     * \brief The outcome of a single simulated game
+     */
+    struct GameResult {
+        /**
+         * \brief True if one of the AI players won the game
+         */
+        bool won;
+
+        /**
+         * \brief The amount of turns the winner needed to finish the game
+         */
+        int turns;
+    };
+
+    /**
+     * \brief Plays a single game from start to finish
+     *
+     * All the choices the simulator makes (the players, the cards that are dealt, the dice rolls
+     * and the reference bots' choices) are drawn from rng, and the AI players are seeded from it
+     * too. This means that a game can be played again exactly by using the same seed for rng.
+     *
+     * \throw std::invalid_argument if the options are invalid
+     * \throw std::logic_error if a player makes an invalid move, suggestion or accusation
+     */
+    GameResult playGame(const GameOptions& options, Random& rng);
+
+    /**
+     * \brief Options for a tournament of many games
+     */
+    struct TournamentOptions {
+        GameOptions game;
+
+        /**
+         * \brief Amount of games to play
+         */
+        int games = 1000;
+
+        /**
+         * \brief Seed for the games, game i is always played exactly the same way for the same
+         * seed, regardless of the thread it is played on
+         */
+        unsigned int seed = 0;
+
+        /**
+         * \brief Amount of threads to play on, 0 to use all the hardware threads
+         */
+        int threads = 0;
+
+        /**
+         * \brief Replay file to append a record of every AI player's game to, empty to not record
+         * the games
+         */
+        std::string record;
+    };
+
+    /**
+     * \brief Statistics gathered over a number of games
+     */
+    struct TournamentStats {
+        int games = 0;
+        int won = 0;
+
+        /**
+         * \brief Amount of games that were aborted because a player misbehaved
+         */
+        int errors = 0;
+
+        /**
+         * \brief The message of the first error, if any
+         */
+        std::string error;
+
+        /**
+         * \brief The amount of games that were won by an AI player for every amount of turns needed
+         */
+        std::map<int, int> turns;
+
+        /**
+         * \brief Wall clock time the games took
+         */
+        double seconds = 0;
+
+        /**
+         * \brief The metrics of all the AI players, which are only gathered when compiled with
+         * METRICS defined
+         */
+        Metrics metrics;
+
+        void add(const GameResult& result);
+        void merge(const TournamentStats& other);
+    };
+
+    /**
+     * \brief Plays games on a pool of threads
+     *
+     * Every thread starts with an equal share of the games, and once it runs out it steals games
+     * that haven't been started yet from the other threads. Every thread keeps its own statistics,
+     * which are only merged once all the threads are done, so the threads never wait on each other.
+     *
+     * \throw std::invalid_argument if the options are invalid or the record file isn't a replay
+     * file
+     * \throw std::runtime_error if the record file can't be written
+     */
+    TournamentStats runTournament(const TournamentOptions& options);
+
+    /**
+     * \brief Prints the win rate, speed and turn distribution of a tournament, and its metrics if
+     * there are any
+     */
+    void printStats(std::ostream& out, const TournamentStats& stats);
+}
+
+// vim: set expandtab textwidth=100:
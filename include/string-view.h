@@ -0,0 +1,130 @@
+/**
+ * \file string-view.h
+ * \author Kobus van Schoor
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace AI {
+    /**
+     * \brief A view of characters that belong to someone else, like C++17's std::string_view
+     *
+     * The comms protocol is parsed through views, so that a message can be split up and its card
+     * names looked up without copying any of it into strings of its own. A view doesn't keep the
+     * characters alive, so it may not outlive the string it was made from.
+     */
+    class StringView {
+        public:
+            /**
+             * \brief Is returned by find() if the character isn't found
+             *
+             * An enum, so that it doesn't need a definition outside of the header
+             */
+            enum : size_t { npos = size_t(-1) };
+
+            constexpr StringView() :
+                ptr(""),
+                len(0)
+            {}
+
+            constexpr StringView(const char* s, size_t size) :
+                ptr(s),
+                len(size)
+            {}
+
+            StringView(const char* s) :
+                ptr(s),
+                len(std::strlen(s))
+            {}
+
+            StringView(const std::string& s) :
+                ptr(s.data()),
+                len(s.size())
+            {}
+
+            constexpr const char* data() const
+            {
+                return ptr;
+            }
+
+            constexpr size_t size() const
+            {
+                return len;
+            }
+
+            constexpr bool empty() const
+            {
+                return len == 0;
+            }
+
+            constexpr char operator[](size_t i) const
+            {
+                return ptr[i];
+            }
+
+            const char* begin() const
+            {
+                return ptr;
+            }
+
+            const char* end() const
+            {
+                return ptr + len;
+            }
+
+            /**
+             * \returns the count characters from pos, or less if the view ends before that
+             */
+            StringView substr(size_t pos, size_t count = npos) const
+            {
+                pos = std::min(pos, len);
+                return StringView(ptr + pos, std::min(count, len - pos));
+            }
+
+            /**
+             * \returns the index of the first c from pos, npos if there is none
+             */
+            size_t find(char c, size_t pos = 0) const
+            {
+                for (size_t i = pos; i < len; i++)
+                    if (ptr[i] == c)
+                        return i;
+
+                return npos;
+            }
+
+            /**
+             * \brief Copies the characters into a string
+             */
+            std::string str() const
+            {
+                return std::string(ptr, len);
+            }
+
+        private:
+            const char* ptr;
+            size_t len;
+    };
+
+    inline bool operator==(StringView a, StringView b)
+    {
+        return (a.size() == b.size()) && std::equal(a.begin(), a.end(), b.begin());
+    }
+
+    inline bool operator!=(StringView a, StringView b)
+    {
+        return !(a == b);
+    }
+
+    inline std::ostream& operator<<(std::ostream& out, StringView s)
+    {
+        return out.write(s.data(), s.size());
+    }
+}
+
+// vim: set expandtab textwidth=100:
@@ -4,10 +4,137 @@
  */
 
 #pragma once
+#include "bot.h"
+#include "random.h"
+#include <algorithm>
+#include <vector>
 
 template <typename T>
 T randEnum(T max_enum) {
     return T(rand() % (int(max_enum) + 1));
 }
 
+/**
+ * \brief A random deal of the cards, so that suggestions can be answered the way the players
+ * holding the cards would
+ *
+ * One card of every type goes into the envelope and the rest are dealt in turn, every player
+ * getting the same amount of cards. The cards that are left over are put face up on the table.
+ * Everything is drawn from the generator passed in, so a test with a fixed seed always plays the
+ * same game.
+ */
+struct Deal {
+    enum { ENVELOPE = -1, TABLE = -2 };
+
+    /**
+     * \param order the players at the table, in the order they play in
+     */
+    Deal(const std::vector<AI::Bot::Player>& order, AI::Random& rng) :
+        order(order), location(AI::Bot::NotesMatrix::CARD_COUNT, TABLE)
+    {
+        typedef AI::Bot::NotesMatrix NM;
+        const int n = order.size();
+
+        std::vector<int> cards;
+        for (int c = 0; c < NM::CARD_COUNT; c++)
+            cards.push_back(c);
+        std::shuffle(cards.begin(), cards.end(), rng);
+
+        bool envelope[3] = {};
+        int dealt = 0;
+        for (int c : cards) {
+            int type = NM::card(c).type;
+            if (!envelope[type]) {
+                envelope[type] = true;
+                location[c] = ENVELOPE;
+            } else if (dealt < 18 - 18 % n)
+                location[c] = dealt++ % n;
+        }
+    }
+
+    /**
+     * \returns the cards at a location, the index of a player in order, ENVELOPE or TABLE
+     */
+    AI::Bot::NotesMatrix::CardMask mask(int at) const
+    {
+        AI::Bot::NotesMatrix::CardMask m = 0;
+        for (int c = 0; c < AI::Bot::NotesMatrix::CARD_COUNT; c++)
+            if (location[c] == at)
+                m |= AI::Bot::NotesMatrix::CardMask(1) << c;
+        return m;
+    }
+
+    /**
+     * \returns the cards at a location as a vector, see mask()
+     */
+    std::vector<AI::Bot::Card> cards(int at) const
+    {
+        std::vector<AI::Bot::Card> v;
+        for (int c = 0; c < AI::Bot::NotesMatrix::CARD_COUNT; c++)
+            if (location[c] == at)
+                v.push_back(AI::Bot::NotesMatrix::card(c));
+        return v;
+    }
+
+    /**
+     * \brief Notes the hand of the player at index at, and that it lacks every other card
+     */
+    void note(int at, AI::Bot::NotesMatrix& notes) const
+    {
+        typedef AI::Bot::NotesMatrix NM;
+        for (int c = 0; c < NM::CARD_COUNT; c++)
+            notes.set(order[at], NM::card(c), location[c] == at ? NM::HAS : NM::LACKS);
+    }
+
+    /**
+     * \returns the index of the player that has to show a card for the suggestion of the player
+     * at index from, -1 if no one can
+     */
+    int answer(int from, const AI::Bot::Suggestion& sug) const
+    {
+        const int n = order.size();
+        for (int pos = (from + 1) % n; pos != from; pos = (pos + 1) % n)
+            if (mask(pos) & AI::Bot::NotesMatrix::mask(sug))
+                return pos;
+        return -1;
+    }
+
+    /**
+     * \returns a random suggestion
+     */
+    static AI::Bot::Suggestion suggestion(AI::Random& rng)
+    {
+        AI::Bot::Player p = AI::Bot::Player(rng() % (AI::Bot::MAX_PLAYER + 1));
+        AI::Bot::Weapon w = AI::Bot::Weapon(rng() % (AI::Bot::MAX_WEAPON + 1));
+        AI::Bot::Room r = AI::Bot::Room(rng() % (AI::Bot::MAX_ROOM + 1));
+        return AI::Bot::Suggestion(p, w, r);
+    }
+
+    /**
+     * \brief Adds a random suggestion of the player at index from to the log, answered according
+     * to the deal
+     * \returns the index of the player that showed a card, -1 if no one did
+     */
+    int suggest(int from, AI::Random& rng, AI::Bot::SuggestionLog& log) const
+    {
+        AI::Bot::Suggestion sug = suggestion(rng);
+        int show = answer(from, sug);
+
+        log.addSuggestion(order[from], sug);
+        if (show < 0)
+            log.addNoShow();
+        else
+            log.addShow(order[show]);
+
+        return show;
+    }
+
+    std::vector<AI::Bot::Player> order;
+
+    /**
+     * \brief Where every card is, indexed by NotesMatrix::index(), see mask()
+     */
+    std::vector<int> location;
+};
+
 // vim: set expandtab textwidth=100:
@@ -0,0 +1,77 @@
+/**
+ * \file replay.cpp
+ * \author Kobus van Schoor
+ *
+ * Replays the games in a replay file (recorded with tournament --record) through new bots, and
+ * reports how fast the events were replayed and where the bots chose differently from the
+ * recording. Run with --help for the options.
+ */
+
+#include "include/replay.h"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    void usage(const char* name)
+    {
+        std::cout << "usage: " << name << " [options] file\n"
+            "  --threads N  threads to replay on (default all hardware threads)\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+            usage(argv[0]);
+            return 0;
+        }
+
+        std::string arg = argv[i];
+
+        if (arg != "--threads") {
+            if (!path.empty()) {
+                usage(argv[0]);
+                return 1;
+            }
+            path = arg;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        try {
+            threads = std::stoi(argv[++i]);
+        } catch (std::exception&) {
+            std::cerr << "invalid value for " << arg << ": " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    if (path.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    AI::ReplayStats stats;
+
+    try {
+        stats = AI::replayFile(path, threads);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    AI::printReplayStats(std::cout, stats);
+
+    return (stats.errors || stats.divergences) ? 1 : 0;
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,108 @@
+/**
+ * \file serve.cpp
+ * \author Kobus van Schoor
+ *
+ * Plays the AI for a server that talks the line protocol of ProtocolDriver, either over stdin and
+ * stdout or over a local socket. Run with --help for the options.
+ */
+
+#include "include/protocol.h"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    void usage(const char* name)
+    {
+        std::cout << "usage: " << name << " [options]\n"
+            "  --socket F   listen on the local socket F and play every connection on a thread of\n"
+            "               its own (default play over stdin and stdout)\n";
+    }
+
+    void serve(int fd)
+    {
+        try {
+            AI::ProtocolDriver driver(fd, fd);
+            driver.run();
+        } catch (std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+
+        close(fd);
+    }
+
+    int listen(const std::string& path)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "socket path is too long: " << path << std::endl;
+            return 1;
+        }
+        std::strcpy(address.sun_path, path.c_str());
+
+        int server = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());
+        if ((server < 0) || bind(server, (sockaddr*)&address, sizeof(address)) ||
+                ::listen(server, SOMAXCONN)) {
+            std::cerr << "couldn't listen on " << path << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+
+        while (true) {
+            int client = accept(server, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "couldn't accept a connection: " << std::strerror(errno) << std::endl;
+                return 1;
+            }
+
+            std::thread(serve, client).detach();
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+            usage(argv[0]);
+            return 0;
+        }
+
+        if (strcmp(argv[i], "--socket") || (i + 1 >= argc)) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        path = argv[++i];
+    }
+
+    // a server that goes away shows up as a write error instead of killing us
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!path.empty())
+        return listen(path);
+
+    try {
+        AI::ProtocolDriver driver(STDIN_FILENO, STDOUT_FILENO);
+        driver.run();
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// vim: set expandtab textwidth=100:
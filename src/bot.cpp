@@ -4,16 +4,16 @@
  */
 
 #include <algorithm>
+#include <random>
 
 #include "../include/bot.h"
 #include "../include/board.h"
+#include "../include/deduction-log.h"
 
 // deductors
 #include "../include/deductor.h"
-#include "../include/deductors/local-exclude.h"
-#include "../include/deductors/no-show.h"
-#include "../include/deductors/seen.h"
-#include "../include/deductors/card-count-exclude.h"
+#include "../include/deductors/incremental.h"
+#include "../include/deductors/constraint.h"
 
 // predictors
 #include "../include/deck.h"
@@ -21,6 +21,11 @@
 #include "../include/predictors/seen.h"
 #include "../include/predictors/multiple.h"
 #include "../include/predictors/no-show.h"
+#include "../include/predictors/probability.h"
+
+// planners
+#include "../include/planners/information.h"
+#include "../include/planners/move.h"
 
 using namespace AI;
 
@@ -31,121 +36,172 @@ bool contains(std::vector<T>& vec, T obj)
     return std::find(vec.begin(), vec.end(), obj) != vec.end();
 }
 
-void toLower(std::string& s)
-{
-    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char a) { return
-            std::tolower(a); });
+namespace {
+    // every name the comms protocol has for a card, in lower case
+    struct CardName {
+        const char* name;
+        Bot::Card::Type type;
+        int card;
+    };
+
+    const CardName CARD_NAMES[] = {
+        { "green", Bot::Card::PLAYER, Bot::GREEN },
+        { "mustard", Bot::Card::PLAYER, Bot::MUSTARD },
+        { "peacock", Bot::Card::PLAYER, Bot::PEACOCK },
+        { "plum", Bot::Card::PLAYER, Bot::PLUM },
+        { "scarlet", Bot::Card::PLAYER, Bot::SCARLET },
+        { "white", Bot::Card::PLAYER, Bot::WHITE },
+        { "candlestick", Bot::Card::WEAPON, Bot::CANDLESTICK },
+        { "dagger", Bot::Card::WEAPON, Bot::KNIFE },
+        { "knife", Bot::Card::WEAPON, Bot::KNIFE },
+        { "lead pipe", Bot::Card::WEAPON, Bot::LEAD_PIPE },
+        { "pistol", Bot::Card::WEAPON, Bot::REVOLVER },
+        { "revolver", Bot::Card::WEAPON, Bot::REVOLVER },
+        { "rope", Bot::Card::WEAPON, Bot::ROPE },
+        { "wrench", Bot::Card::WEAPON, Bot::SPANNER },
+        { "spanner", Bot::Card::WEAPON, Bot::SPANNER },
+        { "courtyard", Bot::Card::ROOM, Bot::COURTYARD },
+        { "garage", Bot::Card::ROOM, Bot::GARAGE },
+        { "game room", Bot::Card::ROOM, Bot::GAMES_ROOM },
+        { "games room", Bot::Card::ROOM, Bot::GAMES_ROOM },
+        { "billiard room", Bot::Card::ROOM, Bot::GAMES_ROOM },
+        { "bedroom", Bot::Card::ROOM, Bot::BEDROOM },
+        { "bathroom", Bot::Card::ROOM, Bot::BATHROOM },
+        { "study", Bot::Card::ROOM, Bot::STUDY },
+        { "kitchen", Bot::Card::ROOM, Bot::KITCHEN },
+        { "dining room", Bot::Card::ROOM, Bot::DINING_ROOM },
+        { "living room", Bot::Card::ROOM, Bot::LIVING_ROOM }
+    };
+
+    const int NAME_COUNT = sizeof(CARD_NAMES) / sizeof(CARD_NAMES[0]);
+    const unsigned NAME_SLOTS = 64;
+
+    unsigned char foldCase(char c)
+    {
+        return ((c >= 'A') && (c <= 'Z')) ? c - 'A' + 'a' : c;
+    }
+
+    /*
+     * A perfect hash of the names above, the multipliers were found by trying small ones until
+     * none of the names shared a slot. It only looks at the first and last characters and the
+     * length, so the string still has to be compared with the name in its slot.
+     */
+    unsigned nameHash(StringView s)
+    {
+        return (foldCase(s[0]) + 11u * foldCase(s[s.size() - 1]) + 6u * s.size()) % NAME_SLOTS;
+    }
+
+    // the index in CARD_NAMES of the name in every slot, -1 for empty slots
+    struct NameTable {
+        signed char slots[NAME_SLOTS];
+
+        NameTable()
+        {
+            std::fill(slots, slots + NAME_SLOTS, -1);
+            for (int i = 0; i < NAME_COUNT; i++)
+                slots[nameHash(CARD_NAMES[i].name)] = i;
+        }
+    };
+
+    const NameTable& nameTable()
+    {
+        static const NameTable table;
+        return table;
+    }
+
+    // a view of a string literal that doesn't have to count its characters
+    template <size_t N>
+    constexpr StringView literal(const char (&s)[N])
+    {
+        return StringView(s, N - 1);
+    }
 }
 
-Bot::Player Bot::strToPlayer(std::string s)
+Bot::Player Bot::strToPlayer(StringView s)
 {
-    toLower(s);
-
-    if (s == "green")
-        return GREEN;
-    if (s == "mustard")
-        return MUSTARD;
-    if (s == "peacock")
-        return PEACOCK;
-    if (s == "plum")
-        return PLUM;
-    if (s == "scarlet")
-        return SCARLET;
-    if (s == "white")
-        return WHITE;
+    Card card(GREEN);
+    if (Card::parse(s, card) && (card.type == Card::PLAYER))
+        return Player(card.card);
 
-    throw std::invalid_argument("\"" + s + "\" is not a valid player");
+    throw std::invalid_argument("\"" + s.str() + "\" is not a valid player");
 }
 
-Bot::Weapon Bot::strToWeapon(std::string s)
+Bot::Weapon Bot::strToWeapon(StringView s)
 {
-    toLower(s);
+    Card card(CANDLESTICK);
+    if (Card::parse(s, card) && (card.type == Card::WEAPON))
+        return Weapon(card.card);
 
-    if (s == "candlestick")
-        return CANDLESTICK;
-    if ((s == "dagger") || (s == "knife"))
-        return KNIFE;
-    if (s == "lead pipe")
-        return LEAD_PIPE;
-    if ((s == "pistol") || (s == "revolver"))
-        return REVOLVER;
-    if (s == "rope")
-        return ROPE;
-    if ((s == "wrench") || (s == "spanner"))
-        return SPANNER;
+    throw std::invalid_argument("\"" + s.str() + "\" is not a valid weapon");
+}
+
+Bot::Room Bot::strToRoom(StringView s)
+{
+    Card card(BEDROOM);
+    if (Card::parse(s, card) && (card.type == Card::ROOM))
+        return Room(card.card);
 
-    throw std::invalid_argument("\"" + s + "\" is not a valid weapon");
+    throw std::invalid_argument("\"" + s.str() + "\" is not a valid room");
 }
 
-Bot::Room Bot::strToRoom(std::string s)
+std::string Bot::playerToStr(Player p)
 {
-    toLower(s);
+    return playerName(p).str();
+}
 
-    if (s == "courtyard")
-        return COURTYARD;
-    if (s == "garage")
-        return GARAGE;
-    if ((s == "game room") || (s == "games room") || (s == "billiard room"))
-        return GAMES_ROOM;
-    if (s == "bedroom")
-        return BEDROOM;
-    if (s == "bathroom")
-        return BATHROOM;
-    if (s == "study")
-        return STUDY;
-    if (s == "kitchen")
-        return KITCHEN;
-    if (s == "dining room")
-        return DINING_ROOM;
-    if (s == "living room")
-        return LIVING_ROOM;
+std::string Bot::weaponToStr(Weapon w)
+{
+    return weaponName(w).str();
+}
 
-    throw std::invalid_argument("\"" + s + "\" is not a valid room");
+std::string Bot::roomToStr(Room r)
+{
+    return roomName(r).str();
 }
 
-std::string Bot::playerToStr(Player p)
+StringView Bot::playerName(Player p)
 {
     switch (p) {
-        case GREEN: return "Green";
-        case MUSTARD: return "Mustard";
-        case PEACOCK: return "Peacock";
-        case PLUM: return "Plum";
-        case SCARLET: return "Scarlet";
-        case WHITE: return "White";
+        case GREEN: return literal("Green");
+        case MUSTARD: return literal("Mustard");
+        case PEACOCK: return literal("Peacock");
+        case PLUM: return literal("Plum");
+        case SCARLET: return literal("Scarlet");
+        case WHITE: return literal("White");
     }
 
-    return "";
+    return StringView();
 }
 
-std::string Bot::weaponToStr(Weapon w)
+StringView Bot::weaponName(Weapon w)
 {
     switch (w) {
-        case CANDLESTICK: return "Candlestick";
-        case KNIFE: return "Dagger";
-        case LEAD_PIPE: return "Lead Pipe";
-        case REVOLVER: return "Pistol";
-        case ROPE: return "Rope";
-        case SPANNER: return "Wrench";
+        case CANDLESTICK: return literal("Candlestick");
+        case KNIFE: return literal("Dagger");
+        case LEAD_PIPE: return literal("Lead Pipe");
+        case REVOLVER: return literal("Pistol");
+        case ROPE: return literal("Rope");
+        case SPANNER: return literal("Wrench");
     }
 
-    return "";
+    return StringView();
 }
 
-std::string Bot::roomToStr(Room r)
+StringView Bot::roomName(Room r)
 {
     switch (r) {
-        case COURTYARD: return "Courtyard";
-        case GARAGE: return "Garage";
-        case GAMES_ROOM: return "Game Room";
-        case BEDROOM: return "Bedroom";
-        case BATHROOM: return "Bathroom";
-        case STUDY: return "Study";
-        case KITCHEN: return "Kitchen";
-        case DINING_ROOM: return "Dining Room";
-        case LIVING_ROOM: return "Living Room";
+        case COURTYARD: return literal("Courtyard");
+        case GARAGE: return literal("Garage");
+        case GAMES_ROOM: return literal("Game Room");
+        case BEDROOM: return literal("Bedroom");
+        case BATHROOM: return literal("Bathroom");
+        case STUDY: return literal("Study");
+        case KITCHEN: return literal("Kitchen");
+        case DINING_ROOM: return literal("Dining Room");
+        case LIVING_ROOM: return literal("Living Room");
     }
 
-    return "";
+    return StringView();
 }
 
 std::string Bot::enumToStr(Player p)
@@ -178,23 +234,31 @@ Bot::Card::Card(Bot::Room r):
     type(Card::Type::ROOM)
 {}
 
-Bot::Card::Card(std::string s)
+Bot::Card::Card(StringView s)
 {
-    try {
-        Bot::Player p = strToPlayer(s);
-        type = PLAYER;
-        card = int(p);
-    } catch (std::invalid_argument&) {
-        try {
-            Bot::Weapon w = strToWeapon(s);
-            type = WEAPON;
-            card = int(w);
-        } catch (std::invalid_argument&) {
-            Bot::Room r = strToRoom(s);
-            type = ROOM;
-            card = int(r);
-        }
-    }
+    if (!parse(s, *this))
+        throw std::invalid_argument("\"" + s.str() + "\" is not a valid card");
+}
+
+bool Bot::Card::parse(StringView s, Card& card)
+{
+    if (s.empty())
+        return false;
+
+    int i = nameTable().slots[nameHash(s)];
+    if (i < 0)
+        return false;
+
+    const char* name = CARD_NAMES[i].name;
+    for (size_t c = 0; c < s.size(); c++)
+        if (!name[c] || (foldCase(s[c]) != (unsigned char)name[c]))
+            return false;
+    if (name[s.size()])
+        return false;
+
+    card.type = CARD_NAMES[i].type;
+    card.card = CARD_NAMES[i].card;
+    return true;
 }
 
 bool Bot::Card::operator<(const Card& other) const
@@ -208,14 +272,19 @@ bool Bot::Card::operator==(const Card& other) const
 }
 
 std::string Bot::Card::str() const
+{
+    return name().str();
+}
+
+StringView Bot::Card::name() const
 {
     switch (type) {
-        case PLAYER: return playerToStr(Bot::Player(card));
-        case WEAPON: return weaponToStr(Bot::Weapon(card));
-        case ROOM: return roomToStr(Bot::Room(card));
+        case PLAYER: return playerName(Bot::Player(card));
+        case WEAPON: return weaponName(Bot::Weapon(card));
+        case ROOM: return roomName(Bot::Room(card));
     }
 
-    return "";
+    return StringView();
 }
 
 Bot::Card::operator std::string() const
@@ -240,16 +309,79 @@ Bot::Suggestion::operator std::string()
         Bot::roomToStr(room);
 }
 
-bool Bot::Notes::concluded()
+bool Bot::Notes::concluded() const
 {
     return has || lacks;
 }
 
-bool Bot::Notes::knows()
+bool Bot::Notes::knows() const
 {
     return has || seen;
 }
 
+const int Bot::NotesMatrix::PLAYER_COUNT;
+const int Bot::NotesMatrix::CARD_COUNT;
+const Bot::NotesMatrix::CardMask Bot::NotesMatrix::PLAYER_CARDS;
+const Bot::NotesMatrix::CardMask Bot::NotesMatrix::WEAPON_CARDS;
+const Bot::NotesMatrix::CardMask Bot::NotesMatrix::ROOM_CARDS;
+const Bot::NotesMatrix::CardMask Bot::NotesMatrix::ALL_CARDS;
+
+Bot::Card Bot::NotesMatrix::card(int index)
+{
+    if (index <= int(MAX_PLAYER))
+        return Player(index);
+    index -= int(MAX_PLAYER) + 1;
+    if (index <= int(MAX_WEAPON))
+        return Weapon(index);
+    return Room(index - int(MAX_WEAPON) - 1);
+}
+
+Bot::NotesMatrix::CardMask Bot::NotesMatrix::typeMask(Card::Type type)
+{
+    switch (type) {
+        case Card::PLAYER: return PLAYER_CARDS;
+        case Card::WEAPON: return WEAPON_CARDS;
+        case Card::ROOM: return ROOM_CARDS;
+    }
+
+    return 0;
+}
+
+void Bot::NotesMatrix::set(Player p, CardMask cards, Attribute a)
+{
+    rows[a][p] |= cards;
+    for (int i = 0; i < CARD_COUNT; i++)
+        if (cards & (CardMask(1) << i))
+            cols[a][i] |= playerBit(p);
+}
+
+Bot::Notes Bot::NotesMatrix::notes(Player p, const Card& c) const
+{
+    Notes n;
+    n.has = get(p, c, HAS);
+    n.seen = get(p, c, SEEN);
+    n.lacks = get(p, c, LACKS);
+    n.deduced = get(p, c, DEDUCED);
+    n.table = get(p, c, TABLE);
+    n.envelope = get(p, c, ENVELOPE);
+    return n;
+}
+
+bool Bot::NotesMatrix::operator==(const NotesMatrix& other) const
+{
+    // the columns mirror the rows, so only the rows need to be compared
+    for (int a = 0; a < ATTRIBUTE_COUNT; a++)
+        for (int p = 0; p < PLAYER_COUNT; p++)
+            if (rows[a][p] != other.rows[a][p])
+                return false;
+    return true;
+}
+
+bool Bot::NotesMatrix::operator!=(const NotesMatrix& other) const
+{
+    return !(*this == other);
+}
+
 void Bot::SuggestionLog::addSuggestion(Player from, Suggestion sug)
 {
     if (waiting())
@@ -285,7 +417,7 @@ void Bot::SuggestionLog::addNoShow()
     waitingForShow = false;
 }
 
-bool Bot::SuggestionLog::waiting()
+bool Bot::SuggestionLog::waiting() const
 {
     return waitingForShow;
 }
@@ -298,11 +430,84 @@ void Bot::SuggestionLog::clear()
     waitingForShow = false;
 }
 
-std::vector<Bot::SuggestionLogItem> Bot::SuggestionLog::log()
+void Bot::SuggestionLog::reset()
+{
+    _log.clear();
+    waitingForShow = false;
+}
+
+const std::vector<Bot::SuggestionLogItem>& Bot::SuggestionLog::log() const
 {
     return _log;
 }
 
+const Bot::SuggestionLogItem& Bot::SuggestionLog::staged() const
+{
+    return staging;
+}
+
+Bot::Event Bot::Event::setCards(std::vector<Card> cards, bool tableCards)
+{
+    Event e(SET_CARDS);
+    e.cards = std::move(cards);
+    e.flag = tableCards;
+    return e;
+}
+
+Bot::Event Bot::Event::updateBoard(std::vector<std::pair<Player, Position>> players)
+{
+    Event e(UPDATE_BOARD);
+    e.board = std::move(players);
+    return e;
+}
+
+Bot::Event Bot::Event::movePlayer(Player player, Position position)
+{
+    Event e(MOVE_PLAYER);
+    e.player = player;
+    e.position = position;
+    return e;
+}
+
+Bot::Event Bot::Event::madeSuggestion(Player player, Suggestion suggestion, bool accuse)
+{
+    Event e(MADE_SUGGESTION);
+    e.player = player;
+    e.suggestion = suggestion;
+    e.flag = accuse;
+    return e;
+}
+
+Bot::Event Bot::Event::otherShownCard(Player showed)
+{
+    Event e(OTHER_SHOWN_CARD);
+    e.player = showed;
+    return e;
+}
+
+Bot::Event Bot::Event::noOtherShownCard()
+{
+    return Event(NO_OTHER_SHOWN_CARD);
+}
+
+Bot::Event Bot::Event::showCard(Player player, Card card)
+{
+    Event e(SHOW_CARD);
+    e.player = player;
+    e.card = card;
+    return e;
+}
+
+Bot::Event Bot::Event::noShowCard()
+{
+    return Event(NO_SHOW_CARD);
+}
+
+Bot::Event Bot::Event::newTurn()
+{
+    return Event(NEW_TURN);
+}
+
 bool Bot::Envelope::operator!=(const Envelope& other)
 {
     return (havePlayer != other.havePlayer) || (haveWeapon != other.haveWeapon) ||
@@ -310,9 +515,16 @@ bool Bot::Envelope::operator!=(const Envelope& other)
 }
 
 Bot::Bot(const Player player, std::vector<Player> order) :
+    Bot(player, order, (uint64_t(std::random_device()()) << 32) | std::random_device()())
+{
+}
+
+Bot::Bot(const Player player, std::vector<Player> order, uint64_t seed) :
     player(player),
     order(order),
-    curSuggestion(Player(0), Weapon(0), Room(0))
+    logSink(new LogSink()),
+    curSuggestion(Player(0), Weapon(0), Room(0)),
+    rng(seed)
 {
     std::lock_guard<std::mutex> l(lock);
 
@@ -326,26 +538,10 @@ Bot::Bot(const Player player, std::vector<Player> order) :
 
     LOG_INFO("bot created, order: " + os());
 
-    // creates a notes entry for every player
-    for (auto o : order)
-        notes[o];
-
     // sets all cards as lacking for this player
-    for (int i = 0; i <= int(MAX_PLAYER); i++)
-        notes[player][Player(i)].lacks = true;
-    for (int i = 0; i <= int(MAX_WEAPON); i++)
-        notes[player][Weapon(i)].lacks = true;
-    for (int i = 0; i <= int(MAX_ROOM); i++)
-        notes[player][Room(i)].lacks = true;
-
-    deductors.push_back(new LocalExcludeDeductor(player));
-    deductors.push_back(new NoShowDeductor(player, order));
-    deductors.push_back(new SeenDeductor(player));
-    deductors.push_back(new CardCountExcludeDeductor(player, order));
+    notes.set(player, NotesMatrix::ALL_CARDS, NotesMatrix::LACKS);
 
-    predictors.push_back(new SeenPredictor(player));
-    predictors.push_back(new MultiplePredictor(player));
-    predictors.push_back(new NoShowPredictor(player));
+    createModules();
 }
 
 Bot::~Bot()
@@ -355,11 +551,17 @@ Bot::~Bot()
         delete d;
     for (auto p : predictors)
         delete p;
+    delete planner;
+    delete movePlanner;
+    delete deductions;
+    delete logSink;
+    delete thoughts.deck;
 }
 
 void Bot::setCards(const std::vector<Card> cards, bool tableCards)
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
 
     auto cs = [&](){
         std::string s = "[";
@@ -374,6 +576,12 @@ void Bot::setCards(const std::vector<Card> cards, bool tableCards)
     else
         LOG_INFO("setting private cards: " + cs());
 
+    // the deductors mark the cards they find as deduced, so during a batch they have to catch up
+    // before we are told about a card they might have found
+    for (auto c : cards)
+        if (!notes[player][c].has)
+            settle();
+
     for (auto c : cards) {
         notes[player][c].has = true;
         notes[player][c].lacks = false;
@@ -391,6 +599,7 @@ void Bot::setCards(const std::vector<Card> cards, bool tableCards)
 void Bot::updateBoard(const std::vector<std::pair<Player, Position>> players)
 {
     std::lock_guard<std::mutex> l(lock);
+    boardVersion++;
 
     auto bs = [&]() {
         std::string s = "[";
@@ -410,6 +619,7 @@ void Bot::updateBoard(const std::vector<std::pair<Player, Position>> players)
 void Bot::movePlayer(const Player player, Position position)
 {
     std::lock_guard<std::mutex> l(lock);
+    boardVersion++;
 
     LOG_INFO("moving player " + playerToStr(player) + " -> " + std::to_string(position));
 
@@ -419,6 +629,8 @@ void Bot::movePlayer(const Player player, Position position)
 void Bot::madeSuggestion(Player player, Suggestion suggestion, bool accuse)
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
+    boardVersion++;
 
     LOG_INFO("adding suggestion to log: " + std::string(suggestion));
 
@@ -432,6 +644,7 @@ void Bot::madeSuggestion(Player player, Suggestion suggestion, bool accuse)
 void Bot::otherShownCard(Player showed)
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
 
     LOG_INFO("adding to log that " + playerToStr(showed) + " showed a card");
 
@@ -443,6 +656,7 @@ void Bot::otherShownCard(Player showed)
 void Bot::noOtherShownCard()
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
 
     LOG_INFO("adding to log that nobody was able to show a card");
 
@@ -454,13 +668,41 @@ void Bot::noOtherShownCard()
 int Bot::getMove(int allowedMoves)
 {
     std::lock_guard<std::mutex> l(lock);
+    METRIC_SCOPE(Metrics::GET_MOVE, metrics);
+    settle();
 
     LOG_INFO("asked for move");
 
-    Deck deck = getWantedDeck();
-    runPredictors(deck);
-    deck.sort();
+    // thinkAhead() might have worked this move out already
+    if (thoughts.haveMoves && (thoughts.notes == notesVersion) &&
+            (thoughts.board == boardVersion) && (allowedMoves >= MIN_ROLL) &&
+            (allowedMoves <= MAX_ROLL)) {
+        METRIC_COUNT(Metrics::THOUGHT_ANSWERS, 1);
+        LOG_LOGIC("move was worked out ahead");
+        return thoughts.moves[allowedMoves];
+    }
+
+    // weigh up the best suggestion in every room against how far away the room is
+    if ((strategy == INFORMATION) &&
+            !(envelope.havePlayer && envelope.haveWeapon && envelope.haveRoom)) {
+        double gains[MAX_ROOM + 1];
+        double values[Board::ROOM_COUNT] = {};
+        if (planner->roomGains(notes, log, gains)) {
+            for (int r = 0; r <= int(MAX_ROOM); r++)
+                values[getRoomPos(Room(r))] = gains[r];
+
+            if (*std::max_element(values, values + Board::ROOM_COUNT) > 0) {
+                LOG_LOGIC("moving to the room with the most information");
+                return movePlanner->plan(board[this->player], allowedMoves, values);
+            }
+        }
+    }
+
+    return chooseMove(allowedMoves, getSortedDeck());
+}
 
+int Bot::chooseMove(int allowedMoves, const Deck& deck)
+{
     bool lookRoom = false;
     bool lookWP = false;
 
@@ -498,7 +740,7 @@ int Bot::getMove(int allowedMoves)
         } else { // we're not currently in a safe room
             // we're in the envelope room, so technically safe but we should move away from here if
             // we can get directly to another safe room to subvert suspicion
-            if ((board[this->player] < Board::ROOM_COUNT) &&
+            if ((board[this->player] < Board::ROOM_COUNT) && envelope.haveRoom &&
                     (envelope.room == getPosRoom(board[this->player]))) {
                 if ((pos < Board::ROOM_COUNT) && contains(safeRooms, getPosRoom(pos))) {
                     dest = pos;
@@ -523,7 +765,7 @@ int Bot::getMove(int allowedMoves)
         bool blocked = false;
 
         try {
-            path = Position(pos).path(0, occupied, 1);
+            path = OCCUPIED_BLOCKED ? Position(pos).path(0, occupied, 1) : Position(pos).path(0);
         } catch (std::runtime_error&) { // we're blocked
             blocked = true;
         }
@@ -560,6 +802,8 @@ int Bot::getMove(int allowedMoves)
 Bot::Suggestion Bot::getSuggestion()
 {
     std::lock_guard<std::mutex> l(lock);
+    METRIC_SCOPE(Metrics::GET_SUGGESTION, metrics);
+    settle();
 
     LOG_INFO("asked for suggestion");
 
@@ -572,10 +816,39 @@ Bot::Suggestion Bot::getSuggestion()
     if ((pos == 0) && !(envelope.havePlayer && envelope.haveWeapon && envelope.haveRoom))
         LOG_ERR("Being forced to make accusation before ready");
 
-    Deck deck = getWantedDeck();
-    runPredictors(deck);
-    deck.sort();
+    // thinkAhead() might have worked this suggestion out already
+    if (thoughts.notes == notesVersion) {
+        for (auto& t : thoughts.suggestions) {
+            if (t.pos == pos) {
+                METRIC_COUNT(Metrics::THOUGHT_ANSWERS, 1);
+                LOG_LOGIC("suggestion was worked out ahead");
+                curSuggestion = t.suggestion;
+                rng = t.rng;
+                notesVersion++;
+                weMadeSuggestion = true;
+                return curSuggestion;
+            }
+        }
+    }
 
+    chooseSuggestion(pos, getSortedDeck());
+
+    // the planner only chooses the player and weapon while we are still looking for the envelope
+    if ((strategy == INFORMATION) && (pos != 0) &&
+            !(envelope.havePlayer && envelope.haveWeapon && envelope.haveRoom)) {
+        if (planner->plan(getPosRoom(pos), notes, log, curSuggestion)) {
+            LOG_LOGIC("planned " + std::string(curSuggestion) + " for the most information");
+        }
+    }
+
+    // rng has moved on, so the suggestions worked out ahead no longer hold
+    notesVersion++;
+    weMadeSuggestion = true;
+    return curSuggestion;
+}
+
+void Bot::chooseSuggestion(int pos, const Deck& deck)
+{
     auto safePlayers = getSafePlayers();
     auto safeWeapons = getSafeWeapons();
     auto safeRooms = getSafeRooms();
@@ -587,7 +860,7 @@ Bot::Suggestion Bot::getSuggestion()
         if (envelope.havePlayer && envelope.haveWeapon) { // we know both, annoy a player
             LOG_LOGIC("we know both the envelope weapon and player, playing offensively");
             curSuggestion.player = choosePlayerOffensive(order, room);
-            curSuggestion.weapon = Weapon(rand() % (int(MAX_WEAPON) + 1));
+            curSuggestion.weapon = Weapon(rng() % (int(MAX_WEAPON) + 1));
         } else if (envelope.havePlayer) { // we know the player, choose a good weapon
             LOG_LOGIC("we know the envelope player, optimizing weapon choice");
             curSuggestion.player = choosePlayerOffensive(safePlayers, room);
@@ -595,7 +868,7 @@ Bot::Suggestion Bot::getSuggestion()
         } else if (envelope.haveWeapon) { // we know the weapon, choose a good player
             LOG_LOGIC("we know the envelope weapon, optimizing player choice");
             curSuggestion.player = deck.players[0];
-            curSuggestion.weapon = safeWeapons[rand() % safeWeapons.size()];
+            curSuggestion.weapon = safeWeapons[rng() % safeWeapons.size()];
         } else { // we don't know anything, choose good player and weapon
             curSuggestion.player = deck.players[0];
             curSuggestion.weapon = deck.weapons[0];
@@ -612,7 +885,7 @@ Bot::Suggestion Bot::getSuggestion()
             LOG_LOGIC("not yet in middle room, not making accusation yet - now annoying other players");
             curSuggestion.room = getPosRoom(pos);
             curSuggestion.player = choosePlayerOffensive(order, curSuggestion.room);
-            curSuggestion.weapon = Weapon(rand() % (MAX_WEAPON + 1));
+            curSuggestion.weapon = Weapon(rng() % (MAX_WEAPON + 1));
         }
     } else if (contains(safeRooms, room)) {
         LOG_LOGIC("in safe room, trying to find weapon or player");
@@ -630,23 +903,25 @@ Bot::Suggestion Bot::getSuggestion()
             if (safeWeapons.empty())
                 curSuggestion.weapon = deck.weapons[0];
             else
-                curSuggestion.weapon = safeWeapons[rand() % safeWeapons.size()];
+                curSuggestion.weapon = safeWeapons[rng() % safeWeapons.size()];
         } else {
             LOG_LOGIC("in a room we already know about, trying to optimize weapon and player choice");
             chooseWP();
         }
     }
-
-    weMadeSuggestion = true;
-    return curSuggestion;
 }
 
 void Bot::showCard(Player player, Card card)
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
 
     LOG_INFO("showed card " + std::string(card) + " from " + playerToStr(player));
 
+    // see setCards()
+    if (!notes[player][card].has)
+        settle();
+
     notes[this->player][card].seen = true;
     notes[player][card].has = true;
     if (weMadeSuggestion) {
@@ -662,6 +937,7 @@ void Bot::showCard(Player player, Card card)
 void Bot::noShowCard()
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
 
     LOG_INFO("nobody was able to show us a card");
 
@@ -678,6 +954,9 @@ void Bot::noShowCard()
 Bot::Card Bot::getCard(Player player, std::vector<Card> cards)
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
+    METRIC_SCOPE(Metrics::GET_CARD, metrics);
+    settle();
 
     std::vector<Bot::Card> ncs;
 
@@ -709,9 +988,10 @@ Bot::Card Bot::getCard(Player player, std::vector<Card> cards)
     // this way we minimize the risk of giving them the info needed to find an envelope card
     std::vector<int> types(3, 0);
 
-    for (auto c : notes[player])
-        if (c.second.seen)
-            types[int(c.first.type)]++;
+    NotesMatrix::CardMask seen = notes.cards(player, NotesMatrix::SEEN);
+    types[Card::PLAYER] = __builtin_popcount(seen & NotesMatrix::PLAYER_CARDS);
+    types[Card::WEAPON] = __builtin_popcount(seen & NotesMatrix::WEAPON_CARDS);
+    types[Card::ROOM] = __builtin_popcount(seen & NotesMatrix::ROOM_CARDS);
 
     int min = 0;
     for (size_t i = 1; i < cards.size(); i++)
@@ -727,21 +1007,584 @@ Bot::Card Bot::getCard(Player player, std::vector<Card> cards)
 void Bot::newTurn()
 {
     std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
 
     LOG_INFO("notified that new turn is starting");
 
     log.clear();
 }
 
-std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> Bot::getNotes()
+void Bot::ingest(const std::vector<Event>& events)
+{
+    beginBatch();
+
+    try {
+        for (auto& e : events) {
+            switch (e.type) {
+                case Event::SET_CARDS:
+                    setCards(e.cards, e.flag);
+                    break;
+                case Event::UPDATE_BOARD:
+                    updateBoard(e.board);
+                    break;
+                case Event::MOVE_PLAYER:
+                    movePlayer(e.player, e.position);
+                    break;
+                case Event::MADE_SUGGESTION:
+                    madeSuggestion(e.player, e.suggestion, e.flag);
+                    break;
+                case Event::OTHER_SHOWN_CARD:
+                    otherShownCard(e.player);
+                    break;
+                case Event::NO_OTHER_SHOWN_CARD:
+                    noOtherShownCard();
+                    break;
+                case Event::SHOW_CARD:
+                    showCard(e.player, e.card);
+                    break;
+                case Event::NO_SHOW_CARD:
+                    noShowCard();
+                    break;
+                case Event::NEW_TURN:
+                    newTurn();
+                    break;
+            }
+        }
+    } catch (...) {
+        endBatch();
+        throw;
+    }
+
+    endBatch();
+}
+
+void Bot::beginBatch()
 {
     std::lock_guard<std::mutex> l(lock);
 
+    LOG_INFO("starting a batch of events");
+
+    batches++;
+}
+
+void Bot::endBatch()
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    if (!batches)
+        throw std::runtime_error("no batch was started");
+
+    LOG_INFO("ending a batch of events");
+
+    if (!--batches)
+        settle();
+}
+
+Bot::NotesMatrix Bot::getNotes()
+{
+    std::lock_guard<std::mutex> l(lock);
+    settle();
+
     return notes;
 }
 
+void Bot::setStrategy(Strategy strategy, int budget)
+{
+    std::lock_guard<std::mutex> l(lock);
+    notesVersion++;
+
+    this->strategy = strategy;
+    this->budget = budget;
+    createModules();
+}
+
+void Bot::recordDeductions(int capacity)
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    delete deductions;
+    deductions = (capacity > 0) ? new DeductionLog(capacity) : nullptr;
+
+    for (auto d : deductors)
+        d->setDeductionLog(deductions);
+    for (auto p : predictors)
+        p->setDeductionLog(deductions);
+}
+
+DeductionLog Bot::getDeductions()
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    return deductions ? *deductions : DeductionLog(0);
+}
+
+LogSink& Bot::getLogSink()
+{
+    // the sink has its own lock and is never replaced
+    return *logSink;
+}
+
+Metrics Bot::getMetrics()
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    return metrics;
+}
+
+bool Bot::thinkAhead()
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    if (strategy == INFORMATION)
+        return false;
+
+    METRIC_SCOPE(Metrics::THINK_AHEAD, metrics);
+    settle();
+
+    if (thoughts.notes != notesVersion) {
+        thoughts.notes = notesVersion;
+        thoughts.haveMoves = false;
+        thoughts.rooms.clear();
+        thoughts.suggestions.clear();
+        delete thoughts.deck;
+        thoughts.deck = nullptr;
+    }
+
+    if (!thoughts.deck)
+        thoughts.deck = new Deck(getSortedDeck());
+
+    if (!thoughts.haveMoves || (thoughts.board != boardVersion)) {
+        thoughts.board = boardVersion;
+        thoughts.haveMoves = true;
+        for (int roll = MIN_ROLL; roll <= MAX_ROLL; roll++)
+            thoughts.moves[roll] = chooseMove(roll, *thoughts.deck);
+
+        // the bot makes its suggestion in the room it moves to, or the one it stays in
+        auto thought = [&](int pos) {
+            if (contains(thoughts.rooms, pos))
+                return true;
+            for (auto& t : thoughts.suggestions)
+                if (t.pos == pos)
+                    return true;
+            return false;
+        };
+
+        thoughts.rooms.clear();
+        for (int roll = MIN_ROLL - 1; roll <= MAX_ROLL; roll++) {
+            int pos = (roll < MIN_ROLL) ? board[this->player] : thoughts.moves[roll];
+            if ((pos < Board::ROOM_COUNT) && !thought(pos))
+                thoughts.rooms.push_back(pos);
+        }
+
+        return !thoughts.rooms.empty();
+    }
+
+    if (thoughts.rooms.empty())
+        return false;
+
+    // the suggestion is chosen with the generator as it is now, and it is put back afterwards so
+    // that the bot carries on as if nothing was worked out
+    int pos = thoughts.rooms.back();
+    thoughts.rooms.pop_back();
+
+    Random saved = rng;
+    Suggestion before = curSuggestion;
+    chooseSuggestion(pos, *thoughts.deck);
+    thoughts.suggestions.push_back({ pos, curSuggestion, rng });
+    curSuggestion = before;
+    rng = saved;
+
+    return !thoughts.rooms.empty();
+}
+
+namespace {
+    /**
+     * \brief Writes a snapshot, only the bytes that fit in the buffer are stored but all of them
+     * are counted
+     */
+    struct SnapshotWriter {
+        SnapshotWriter(uint8_t* data, size_t size) : data(data), size(size) {}
+
+        void byte(uint8_t b)
+        {
+            if (pos < size)
+                data[pos] = b;
+            pos++;
+        }
+
+        void varint(uint64_t v)
+        {
+            while (v >= 0x80) {
+                byte(uint8_t(v) | 0x80);
+                v >>= 7;
+            }
+            byte(uint8_t(v));
+        }
+
+        /**
+         * \brief Appends the lowest count bits of v, starting with the least significant one
+         */
+        void bits(uint32_t v, int count)
+        {
+            buffer |= uint64_t(v) << buffered;
+            buffered += count;
+            while (buffered >= 8) {
+                byte(uint8_t(buffer));
+                buffer >>= 8;
+                buffered -= 8;
+            }
+        }
+
+        /**
+         * \brief Pads the bits written so far to a whole byte
+         */
+        void align()
+        {
+            if (buffered > 0)
+                byte(uint8_t(buffer));
+            buffer = 0;
+            buffered = 0;
+        }
+
+        uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+        uint64_t buffer = 0;
+        int buffered = 0;
+    };
+
+    /**
+     * \brief Reads a snapshot written by a SnapshotWriter
+     * \throw std::invalid_argument when reading past the end of the data
+     */
+    struct SnapshotReader {
+        SnapshotReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+        uint8_t byte()
+        {
+            if (pos >= size)
+                throw std::invalid_argument("snapshot is truncated");
+            return data[pos++];
+        }
+
+        uint64_t varint()
+        {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t b = byte();
+                v |= uint64_t(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return v;
+            }
+            throw std::invalid_argument("snapshot has an invalid varint");
+        }
+
+        /**
+         * \brief Reads a varint that has to be less than limit
+         */
+        uint64_t varint(uint64_t limit)
+        {
+            uint64_t v = varint();
+            if (v >= limit)
+                throw std::invalid_argument("snapshot has a value out of range");
+            return v;
+        }
+
+        uint32_t bits(int count)
+        {
+            while (buffered < count) {
+                buffer |= uint64_t(byte()) << buffered;
+                buffered += 8;
+            }
+            uint32_t v = uint32_t(buffer & ((uint64_t(1) << count) - 1));
+            buffer >>= count;
+            buffered -= count;
+            return v;
+        }
+
+        /**
+         * \brief Reads count bits that have to be less than limit
+         */
+        uint32_t bits(int count, uint32_t limit)
+        {
+            uint32_t v = bits(count);
+            if (v >= limit)
+                throw std::invalid_argument("snapshot has a value out of range");
+            return v;
+        }
+
+        void align()
+        {
+            buffer = 0;
+            buffered = 0;
+        }
+
+        const uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+        uint64_t buffer = 0;
+        int buffered = 0;
+    };
+
+    const uint8_t SNAPSHOT_MAGIC[2] = { 'C', 'B' };
+
+    const int PLAYER_BITS = 3;
+    const int ROW_COUNT = Bot::NotesMatrix::ATTRIBUTE_COUNT * Bot::NotesMatrix::PLAYER_COUNT;
+
+    const int WEAPON_COUNT = int(Bot::MAX_WEAPON) + 1;
+    const int ROOM_COUNT = int(Bot::MAX_ROOM) + 1;
+    const int SUGGESTION_COUNT = Bot::NotesMatrix::PLAYER_COUNT * WEAPON_COUNT * ROOM_COUNT;
+
+    /**
+     * \brief Who showed a card (plus one) or 0 if nobody did
+     */
+    const int SHOW_COUNT = Bot::NotesMatrix::PLAYER_COUNT + 1;
+    const int LOG_ITEM_COUNT = SUGGESTION_COUNT * Bot::NotesMatrix::PLAYER_COUNT * SHOW_COUNT;
+
+    uint64_t encode(const Bot::Suggestion& s)
+    {
+        return (uint64_t(s.player) * WEAPON_COUNT + s.weapon) * ROOM_COUNT + s.room;
+    }
+
+    Bot::Suggestion decodeSuggestion(uint64_t v)
+    {
+        return Bot::Suggestion(Bot::Player(v / ROOM_COUNT / WEAPON_COUNT),
+                Bot::Weapon(v / ROOM_COUNT % WEAPON_COUNT), Bot::Room(v % ROOM_COUNT));
+    }
+
+    uint64_t encode(const Bot::Suggestion& s, Bot::Player from, bool showed, Bot::Player show)
+    {
+        return (encode(s) * Bot::NotesMatrix::PLAYER_COUNT + from) * SHOW_COUNT +
+            (showed ? int(show) + 1 : 0);
+    }
+}
+
+size_t Bot::serialize(uint8_t* buffer, size_t size)
+{
+    std::lock_guard<std::mutex> l(lock);
+    settle();
+
+    SnapshotWriter w(buffer, size);
+
+    w.byte(SNAPSHOT_MAGIC[0]);
+    w.byte(SNAPSHOT_MAGIC[1]);
+    w.byte(SNAPSHOT_VERSION);
+
+    // everything that is only a few bits long is packed together
+    w.bits(player, PLAYER_BITS);
+    w.bits(order.size(), PLAYER_BITS);
+    for (auto p : order)
+        w.bits(p, PLAYER_BITS);
+    w.bits(strategy, 1);
+    w.bits(weMadeSuggestion, 1);
+    w.bits(log.waiting(), 1);
+    w.bits(envelope.havePlayer, 1);
+    w.bits(envelope.haveWeapon, 1);
+    w.bits(envelope.haveRoom, 1);
+
+    // most of the rows are empty, so a bit says which rows follow
+    for (int r = 0; r < ROW_COUNT; r++)
+        w.bits(notes.cards(Player(r % NotesMatrix::PLAYER_COUNT),
+                    NotesMatrix::Attribute(r / NotesMatrix::PLAYER_COUNT)) != 0, 1);
+    for (int r = 0; r < ROW_COUNT; r++) {
+        NotesMatrix::CardMask row = notes.cards(Player(r % NotesMatrix::PLAYER_COUNT),
+                NotesMatrix::Attribute(r / NotesMatrix::PLAYER_COUNT));
+        if (row)
+            w.bits(row, NotesMatrix::CARD_COUNT);
+    }
+    w.align();
+
+    if (strategy == INFORMATION)
+        w.varint(budget);
+
+    w.varint(encode(Suggestion(envelope.havePlayer ? envelope.player : Player(0),
+                    envelope.haveWeapon ? envelope.weapon : Weapon(0),
+                    envelope.haveRoom ? envelope.room : Room(0))));
+    w.varint(encode(curSuggestion));
+
+    uint32_t state[Random::STATE_SIZE];
+    rng.save(state);
+    for (int i = 0; i < Random::STATE_SIZE; i++)
+        for (int b = 0; b < 4; b++)
+            w.byte(uint8_t(state[i] >> (8 * b)));
+
+    w.varint(board.size());
+    for (auto& p : board)
+        w.varint(uint64_t(p.second) * NotesMatrix::PLAYER_COUNT + p.first);
+
+    auto& items = log.log();
+    w.varint(items.size());
+    for (auto& item : items)
+        w.varint(encode(item.suggestion, item.from, item.showed, item.show));
+    if (log.waiting()) {
+        auto& staging = log.staged();
+        w.varint(encode(staging.suggestion, staging.from, false, Player(0)));
+    }
+
+    return w.pos;
+}
+
+std::vector<uint8_t> Bot::serialize()
+{
+    std::vector<uint8_t> data(256);
+    size_t size = serialize(data.data(), data.size());
+    if (size > data.size()) {
+        data.resize(size);
+        size = serialize(data.data(), data.size());
+    }
+    data.resize(size);
+    return data;
+}
+
+void Bot::deserialize(const uint8_t* data, size_t size)
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    // everything is read and checked before the bot is changed
+    SnapshotReader r(data, size);
+
+    if ((r.byte() != SNAPSHOT_MAGIC[0]) || (r.byte() != SNAPSHOT_MAGIC[1]))
+        throw std::invalid_argument("data is not a bot snapshot");
+    if (r.byte() != SNAPSHOT_VERSION)
+        throw std::invalid_argument("snapshot was made by another version");
+
+    const int n = NotesMatrix::PLAYER_COUNT;
+
+    Player newPlayer = Player(r.bits(PLAYER_BITS, n));
+    int orderSize = r.bits(PLAYER_BITS, n + 1);
+    Player newOrder[NotesMatrix::PLAYER_COUNT];
+    for (int i = 0; i < orderSize; i++)
+        newOrder[i] = Player(r.bits(PLAYER_BITS, n));
+    Strategy newStrategy = Strategy(r.bits(1));
+    bool newWeMadeSuggestion = r.bits(1);
+    bool waiting = r.bits(1);
+
+    Envelope newEnvelope;
+    newEnvelope.havePlayer = r.bits(1);
+    newEnvelope.haveWeapon = r.bits(1);
+    newEnvelope.haveRoom = r.bits(1);
+
+    NotesMatrix newNotes;
+    uint64_t rows = 0;
+    for (int i = 0; i < ROW_COUNT; i++)
+        rows |= uint64_t(r.bits(1)) << i;
+    for (int i = 0; i < ROW_COUNT; i++) {
+        if (rows & (uint64_t(1) << i))
+            newNotes.set(Player(i % n), NotesMatrix::CardMask(r.bits(NotesMatrix::CARD_COUNT)),
+                    NotesMatrix::Attribute(i / n));
+    }
+    r.align();
+
+    int newBudget = budget;
+    if (newStrategy == INFORMATION)
+        newBudget = r.varint(uint64_t(INT32_MAX) + 1);
+
+    Suggestion found = decodeSuggestion(r.varint(SUGGESTION_COUNT));
+    newEnvelope.player = found.player;
+    newEnvelope.weapon = found.weapon;
+    newEnvelope.room = found.room;
+    Suggestion newSuggestion = decodeSuggestion(r.varint(SUGGESTION_COUNT));
+
+    uint32_t state[Random::STATE_SIZE] = {};
+    uint32_t stateBits = 0;
+    for (int i = 0; i < Random::STATE_SIZE; i++) {
+        for (int b = 0; b < 4; b++)
+            state[i] |= uint32_t(r.byte()) << (8 * b);
+        stateBits |= state[i];
+    }
+    if (!stateBits)
+        throw std::invalid_argument("snapshot has an invalid random state");
+
+    int positions[NotesMatrix::PLAYER_COUNT];
+    std::fill(positions, positions + n, -1);
+    int boardSize = r.varint(n + 1);
+    for (int i = 0; i < boardSize; i++) {
+        uint64_t v = r.varint(uint64_t(Board::BOARD_SIZE) * n);
+        positions[v % n] = v / n;
+    }
+
+    // the log is only checked now and read again once the bot is changed
+    size_t logSize = r.varint(size);
+    SnapshotReader items = r;
+    for (size_t i = 0; i < logSize + waiting; i++)
+        r.varint(LOG_ITEM_COUNT);
+
+    if (r.pos != size)
+        throw std::invalid_argument("snapshot has trailing data");
+
+    player = newPlayer;
+    order.assign(newOrder, newOrder + orderSize);
+    notes = newNotes;
+    strategy = newStrategy;
+    budget = newBudget;
+    weMadeSuggestion = newWeMadeSuggestion;
+    envelope = newEnvelope;
+    curSuggestion = newSuggestion;
+
+    board.clear();
+    for (int p = 0; p < n; p++)
+        if (positions[p] >= 0)
+            board[Player(p)] = positions[p];
+
+    log.reset();
+    for (size_t i = 0; i < logSize + waiting; i++) {
+        uint64_t v = items.varint();
+        int show = v % SHOW_COUNT;
+        v /= SHOW_COUNT;
+        log.addSuggestion(Player(v % n), decodeSuggestion(v / n));
+
+        if (i == logSize)
+            break;
+        if (show)
+            log.addShow(Player(show - 1));
+        else
+            log.addNoShow();
+    }
+
+    // the planners draw their seed from the generator, so it is restored last
+    createModules();
+    rng.restore(state);
+
+    // a snapshot is only made once its deductions have been made
+    deductionsDue = false;
+    lackingDue = false;
+
+    notesVersion++;
+    boardVersion++;
+}
+
+void Bot::deserialize(const std::vector<uint8_t>& data)
+{
+    deserialize(data.data(), data.size());
+}
+
 void Bot::notesHook(bool nolacking)
 {
+    // the deductors end up with the same notes however many events they are run after (apart
+    // from the cards they mark as deduced, see setCards()), so a batch only runs them once
+    if (batches) {
+        deductionsDue = true;
+        lackingDue = lackingDue || !nolacking;
+        return;
+    }
+
+    deduce(nolacking);
+}
+
+void Bot::settle()
+{
+    if (!deductionsDue)
+        return;
+
+    deductionsDue = false;
+    deduce(!lackingDue);
+    lackingDue = false;
+}
+
+void Bot::deduce(bool nolacking)
+{
+    METRIC_SCOPE(Metrics::NOTES_HOOK, metrics);
+
     if (!nolacking)
         notesMarkLacking();
     runDeductors();
@@ -752,7 +1595,9 @@ void Bot::runDeductors()
 {
     bool made;
     int count = 0;
+    METRIC_COUNT(Metrics::DEDUCTOR_RUNS, 1);
     do {
+        METRIC_COUNT(Metrics::DEDUCTOR_ITERATIONS, 1);
         made = false;
         for (auto d : deductors)
             if (d->run(log, notes))
@@ -774,15 +1619,13 @@ void Bot::runPredictors(Deck& deck)
 void Bot::notesMarkLacking()
 {
     for (auto player : order) {
-        for (auto card : notes[player]) {
-            if (card.second.has) {
-                for (auto otherp : order) {
-                    if (otherp == player)
-                        continue;
-                    notes[otherp][card.first].lacks = true;
-                }
-            }
-        }
+        // everything the other players have, this player lacks
+        NotesMatrix::CardMask others = 0;
+        for (auto otherp : order)
+            if (otherp != player)
+                others |= notes.cards(otherp, NotesMatrix::HAS);
+
+        notes.set(player, others, NotesMatrix::LACKS);
     }
 }
 
@@ -792,214 +1635,97 @@ bool Bot::findEnvelope()
 
     // for all the cards, first check if there is a card that everyone lacks. if it cannot find such
     // a card, check if we know that everyone has all the cards except for one
+    NotesMatrix::CardMask allLack = NotesMatrix::ALL_CARDS;
+    NotesMatrix::CardMask anyHas = 0;
+    for (auto player : order) {
+        allLack &= notes.cards(player, NotesMatrix::LACKS);
+        anyHas |= notes.cards(player, NotesMatrix::HAS);
+    }
 
-    if (!envelope.havePlayer) {
-        for (int i = 0; i <= int(MAX_PLAYER); i++) {
-            bool found = false;
-            for (auto player : order) {
-                if (!notes[player][Player(i)].lacks) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) {
-                envelope.player = Player(i);
-                notes[this->player][envelope.player].envelope = true;
-                envelope.havePlayer = true;
-                LOG_LOGIC("SOLVED: " + playerToStr(envelope.player) + " is the envelope player (all-lacks)");
-                break;
-            }
+    // returns the index of the envelope card of the given type or -1 if it isn't known yet
+    auto solve = [&](Card::Type type, DeductionLog::Rule& how) {
+        NotesMatrix::CardMask mask = NotesMatrix::typeMask(type);
+        if (allLack & mask) {
+            how = DeductionLog::ALL_LACKS;
+            return __builtin_ctz(allLack & mask);
         }
 
-        if (!envelope.havePlayer) {
-            bool noHas = false;
-            Player noHasPlayer;
-
-            for (int i = 0; i <= int(MAX_PLAYER); i++) {
-                bool found = false;
-                for (auto player : order) {
-                    if (notes[player][Player(i)].has) {
-                        found = true;
-                        break;
-                    }
-                }
-
-                if (!found) {
-                    // multiple cards hasn't been found
-                    if (noHas) {
-                        noHas = false;
-                        break;
-                    }
-                    noHas = true;
-                    noHasPlayer = Player(i);
-                }
-            }
-
-            if (noHas) {
-                envelope.player = noHasPlayer;
-                notes[this->player][envelope.player].envelope = true;
-                envelope.havePlayer = true;
-                LOG_LOGIC("SOLVED: " + playerToStr(envelope.player) + " is the envelope player (no-has)");
-            }
+        // only a single card that nobody has
+        NotesMatrix::CardMask noHas = mask & ~anyHas;
+        if (__builtin_popcount(noHas) == 1) {
+            how = DeductionLog::NO_HAS;
+            return __builtin_ctz(noHas);
         }
-    }
 
-    if (!envelope.haveWeapon) {
-        for (int i = 0; i <= int(MAX_WEAPON); i++) {
-            bool found = false;
-            for (auto player : order) {
-                if (!notes[player][Weapon(i)].lacks) {
-                    found = true;
-                    break;
-                }
-            }
+        return -1;
+    };
 
-            if (!found) {
-                envelope.weapon = Weapon(i);
-                notes[this->player][envelope.weapon].envelope = true;
-                envelope.haveWeapon = true;
-                LOG_LOGIC("SOLVED: " + weaponToStr(envelope.weapon) + " is the envelope weapon (all-lacks)");
-                break;
-            }
-        }
+    auto solved = [&](DeductionLog::Rule how, const Card& card) {
+        if (deductions)
+            deductions->add(how, DeductionLog::ENVELOPE, player, card);
+        else
+            LOG_LOGIC(DeductionLog::format(DeductionLog::record(how, DeductionLog::ENVELOPE,
+                            player, card)));
+    };
 
-        if (!envelope.haveWeapon) {
-            bool noHas = false;
-            Weapon noHasWeapon;
-
-            for (int i = 0; i <= int(MAX_WEAPON); i++) {
-                bool found = false;
-                for (auto player : order) {
-                    if (notes[player][Weapon(i)].has) {
-                        found = true;
-                        break;
-                    }
-                }
-
-                if (!found) {
-                    // multiple cards hasn't been found
-                    if (noHas) {
-                        noHas = false;
-                        break;
-                    }
-                    noHas = true;
-                    noHasWeapon = Weapon(i);
-                }
-            }
+    DeductionLog::Rule how;
+    int i;
 
-            if (noHas) {
-                envelope.weapon = noHasWeapon;
-                notes[this->player][envelope.weapon].envelope = true;
-                envelope.haveWeapon = true;
-                LOG_LOGIC("SOLVED: " + weaponToStr(envelope.weapon) + " is the envelope weapon (no-has)");
-            }
-        }
+    if (!envelope.havePlayer && ((i = solve(Card::PLAYER, how)) >= 0)) {
+        envelope.player = Player(NotesMatrix::card(i).card);
+        notes[this->player][envelope.player].envelope = true;
+        envelope.havePlayer = true;
+        solved(how, envelope.player);
     }
 
-    if (!envelope.haveRoom) {
-        for (int i = 0; i <= int(MAX_ROOM); i++) {
-            bool found = false;
-            for (auto player : order) {
-                if (!notes[player][Room(i)].lacks) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found) {
-                envelope.room = Room(i);
-                notes[this->player][envelope.room].envelope = true;
-                envelope.haveRoom = true;
-                LOG_LOGIC("SOLVED: " + roomToStr(envelope.room) + " is the envelope room (all-lacks)");
-                break;
-            }
-        }
-
-        if (!envelope.haveRoom) {
-            bool noHas = false;
-            Room noHasRoom;
-
-            for (int i = 0; i <= int(MAX_ROOM); i++) {
-                bool found = false;
-                for (auto player : order) {
-                    if (notes[player][Room(i)].has) {
-                        found = true;
-                        break;
-                    }
-                }
-
-                if (!found) {
-                    // multiple cards hasn't been found
-                    if (noHas) {
-                        noHas = false;
-                        break;
-                    }
-                    noHas = true;
-                    noHasRoom = Room(i);
-                }
-            }
+    if (!envelope.haveWeapon && ((i = solve(Card::WEAPON, how)) >= 0)) {
+        envelope.weapon = Weapon(NotesMatrix::card(i).card);
+        notes[this->player][envelope.weapon].envelope = true;
+        envelope.haveWeapon = true;
+        solved(how, envelope.weapon);
+    }
 
-            if (noHas) {
-                envelope.room = noHasRoom;
-                notes[this->player][envelope.room].envelope = true;
-                envelope.haveRoom = true;
-                LOG_LOGIC("SOLVED: " + roomToStr(envelope.room) + " is the envelope room (no-has)");
-            }
-        }
+    if (!envelope.haveRoom && ((i = solve(Card::ROOM, how)) >= 0)) {
+        envelope.room = Room(NotesMatrix::card(i).card);
+        notes[this->player][envelope.room].envelope = true;
+        envelope.haveRoom = true;
+        solved(how, envelope.room);
     }
 
     return env != envelope;
 }
 
+Deck Bot::getSortedDeck()
+{
+    Deck deck = getWantedDeck();
+    runPredictors(deck);
+    deck.sort();
+
+    return deck;
+}
+
 Deck Bot::getWantedDeck()
 {
     Deck deck;
 
-    if (!envelope.havePlayer) {
-        for (int i = 0; i <= int(MAX_PLAYER); i++) {
-            bool found = false;
-            for (auto p : order) {
-                if (notes[p][Player(i)].has) {
-                    found = true;
-                    break;
-                }
-            }
+    NotesMatrix::CardMask anyHas = 0;
+    for (auto p : order)
+        anyHas |= notes.cards(p, NotesMatrix::HAS);
 
-            if (!found)
+    if (!envelope.havePlayer)
+        for (int i = 0; i <= int(MAX_PLAYER); i++)
+            if (!(anyHas & NotesMatrix::mask(Card(Player(i)))))
                 deck.players.push_back(Player(i));
-        }
-    }
 
-    if (!envelope.haveWeapon) {
-        for (int i = 0; i <= int(MAX_WEAPON); i++) {
-            bool found = false;
-            for (auto p : order) {
-                if (notes[p][Weapon(i)].has) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found)
+    if (!envelope.haveWeapon)
+        for (int i = 0; i <= int(MAX_WEAPON); i++)
+            if (!(anyHas & NotesMatrix::mask(Card(Weapon(i)))))
                 deck.weapons.push_back(Weapon(i));
-        }
-    }
 
-    if (!envelope.haveRoom) {
-        for (int i = 0; i <= int(MAX_ROOM); i++) {
-            bool found = false;
-            for (auto p : order) {
-                if (notes[p][Room(i)].has) {
-                    found = true;
-                    break;
-                }
-            }
-
-            if (!found)
+    if (!envelope.haveRoom)
+        for (int i = 0; i <= int(MAX_ROOM); i++)
+            if (!(anyHas & NotesMatrix::mask(Card(Room(i)))))
                 deck.rooms.push_back(Room(i));
-        }
-    }
 
     return deck;
 }
@@ -1102,7 +1828,7 @@ int Bot::findNextMove(int allowedMoves, std::vector<Room> wanted, bool allowOccu
                 getPosRoom(board[this->player])))
         wanted.erase(std::find(wanted.begin(), wanted.end(), getPosRoom(board[this->player])));
 
-    std::vector<std::pair<Room, Position::Path>> dists;
+    std::vector<std::pair<Room, int>> dists;
     Position start(board[this->player]);
 
     std::vector<bool> occupied(Board::BOARD_SIZE, false);
@@ -1110,27 +1836,19 @@ int Bot::findNextMove(int allowedMoves, std::vector<Room> wanted, bool allowOccu
         for (auto p : board)
             occupied[p.second] = true;
 
+    // a single search gives the paths to all the rooms
+    Position::Reach reach = start.reach(occupied);
+
     // find the distances for all the wanted rooms
-    for (auto w : wanted) {
-        try {
-            Position::Path path = start.path(getRoomPos(w), occupied, 1);
-            dists.push_back({ w, path });
-        } catch (std::runtime_error&) {}; // blocked
-    }
+    for (auto w : wanted)
+        if (reach.reachable(getRoomPos(w))) // not blocked
+            dists.push_back({ w, reach.distance(getRoomPos(w)) });
 
     // check for all rooms that we can enter
     std::vector<int> unwantedRooms;
-    for (int i = 1; i < Board::ROOM_COUNT; i++) {
-        int dist;
-        try {
-            dist = start.path(i, occupied, 1);
-        } catch (std::runtime_error&) {
-            continue;
-        }
-
-        if (dist <= allowedMoves)
+    for (int i = 1; i < Board::ROOM_COUNT; i++)
+        if (reach.reachable(i) && (reach.distance(i) <= allowedMoves))
             unwantedRooms.push_back(i);
-    }
 
     // will find the unwanted room that is closest to a wanted room (either by shortcut or by tiles)
     auto findBestUnwanted = [&]() {
@@ -1141,7 +1859,7 @@ int Bot::findNextMove(int allowedMoves, std::vector<Room> wanted, bool allowOccu
 
             for (auto w : wanted) {
                 int p = getRoomPos(w);
-                wantedDistance[p] = Position(r).path(p, 1);
+                wantedDistance[p] = Position(r).distance(p);
             }
 
             int min = wantedDistance.begin()->first;
@@ -1162,24 +1880,16 @@ int Bot::findNextMove(int allowedMoves, std::vector<Room> wanted, bool allowOccu
 
     // will follow the partial path up to the closest room
     auto findClosestRoom = [&]() {
-        std::vector<Position::Path> paths;
-
-        for (int i = 1; i < Board::ROOM_COUNT; i++) {
-            try {
-                Position::Path p = Position(board[this->player]).path(i, occupied, 1);
-                paths.push_back(p);
-            } catch (std::runtime_error&) { // blocked
-                continue;
-            }
-        }
+        int min = -1;
 
-        Position::Path min = *paths.begin();
+        for (int i = 1; i < Board::ROOM_COUNT; i++)
+            if (reach.reachable(i) && ((min == -1) || (reach.distance(i) < reach.distance(min))))
+                min = i;
 
-        for (auto p : paths)
-            if (p < min)
-                min = p;
+        if (min == -1) // every room is blocked off
+            return board[this->player];
 
-        return min.partial(allowedMoves);
+        return reach.path(min).partial(allowedMoves);
     };
 
     if (dists.empty()) { // everything was blocked in some way
@@ -1243,7 +1953,7 @@ Bot::Player Bot::choosePlayerOffensive(std::vector<Player> choices, Bot::Room ro
     // if there is not a player that is currently playing and one of our choices, we cannot make an
     // offensive move and hence we can just return a random choice
     if (!found)
-        return choices[rand() % choices.size()];
+        return choices[rng() % choices.size()];
 
     for (auto p : order)
         if (notes[p][room].seen && contains(choices, p))
@@ -1253,12 +1963,9 @@ Bot::Player Bot::choosePlayerOffensive(std::vector<Player> choices, Bot::Room ro
     std::map<Player, int> seenCount;
 
     for (auto p : seen.empty() ? order : seen) {
-        if (!seen.empty() || contains(choices, p)) {
-            seenCount[p] = 0;
-            for (int i = 0; i <= int(MAX_ROOM); i++)
-                if (notes[p][Room(i)].seen)
-                    seenCount[p]++;
-        }
+        if (!seen.empty() || contains(choices, p))
+            seenCount[p] = __builtin_popcount(notes.cards(p, NotesMatrix::SEEN) &
+                    NotesMatrix::ROOM_CARDS);
     }
 
     // if nobody has seen the room, return the player that has seen the least amount of rooms since
@@ -1276,6 +1983,43 @@ Bot::Player Bot::choosePlayerOffensive(std::vector<Player> choices, Bot::Room ro
                 return a.second < b.second; })->first;
 }
 
+void Bot::createModules()
+{
+    for (auto d : deductors)
+        delete d;
+    for (auto p : predictors)
+        delete p;
+    deductors.clear();
+    predictors.clear();
+
+    // runs the local-exclude, no-show, seen and card-count-exclude deductions incrementally
+    deductors.push_back(new IncrementalDeductor(player, order));
+    deductors.push_back(new ConstraintDeductor(player, order));
+
+    predictors.push_back(new SeenPredictor(player));
+    predictors.push_back(new MultiplePredictor(player));
+    predictors.push_back(new NoShowPredictor(player));
+    predictors.push_back(new ProbabilityPredictor(player, order));
+
+    for (auto d : deductors) {
+        d->setDeductionLog(deductions);
+        d->setLogSink(logSink);
+    }
+    for (auto p : predictors) {
+        p->setDeductionLog(deductions);
+        p->setLogSink(logSink);
+    }
+
+    delete planner;
+    delete movePlanner;
+    planner = nullptr;
+    movePlanner = nullptr;
+    if (strategy == INFORMATION) {
+        planner = new InformationPlanner(player, order, budget, ParticleOptions(), rng());
+        movePlanner = new MovePlanner();
+    }
+}
+
 Bot::Card::Type Bot::findLeastKnown()
 {
     int playerCount = 0;
@@ -1283,17 +2027,10 @@ Bot::Card::Type Bot::findLeastKnown()
     int roomCount = 0;
 
     for (auto player : order) {
-        for (int i = 0; i <= int(MAX_PLAYER); i++)
-            if (notes[player][Player(i)].has)
-                playerCount++;
-
-        for (int i = 0; i <= int(MAX_WEAPON); i++)
-            if (notes[player][Weapon(i)].has)
-                weaponCount++;
-
-        for (int i = 0; i <= int(MAX_ROOM); i++)
-            if (notes[player][Room(i)].has)
-                roomCount++;
+        NotesMatrix::CardMask has = notes.cards(player, NotesMatrix::HAS);
+        playerCount += __builtin_popcount(has & NotesMatrix::PLAYER_CARDS);
+        weaponCount += __builtin_popcount(has & NotesMatrix::WEAPON_CARDS);
+        roomCount += __builtin_popcount(has & NotesMatrix::ROOM_CARDS);
     }
 
     playerCount = int(MAX_PLAYER) - playerCount;
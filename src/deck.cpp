@@ -18,7 +18,7 @@ void Deck::sort()
             { return scores[a] < scores[b]; });
 }
 
-bool Deck::contains(Bot::Card c)
+bool Deck::contains(Bot::Card c) const
 {
     switch(c.type) {
         case Bot::Card::PLAYER: return std::find(players.begin(), players.end(), Bot::Player(c.card)) != players.end();
@@ -0,0 +1,84 @@
+/**
+ * \file deduction-log.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../include/deduction-log.h"
+#include <stdexcept>
+
+using namespace AI;
+
+DeductionLog::DeductionLog(int capacity) :
+    records(capacity > 0 ? capacity : 0)
+{}
+
+size_t DeductionLog::size() const
+{
+    return added < records.size() ? size_t(added) : records.size();
+}
+
+uint64_t DeductionLog::total() const
+{
+    return added;
+}
+
+const DeductionLog::Record& DeductionLog::operator[](size_t i) const
+{
+    if (added > records.size())
+        return records[(added + i) % records.size()];
+    return records[i];
+}
+
+void DeductionLog::clear()
+{
+    added = 0;
+}
+
+std::string DeductionLog::format(const Record& record)
+{
+    static const char* rules[RULE_COUNT] = { "local-exclude", "no-show", "seen",
+        "card-count-exclude", "constraint", "seen", "multiple", "no-show", "all-lacks", "no-has" };
+
+    if ((record.rule >= RULE_COUNT) || (record.fact >= FACT_COUNT) ||
+            (record.player > Bot::MAX_PLAYER) ||
+            (record.card >= Bot::NotesMatrix::CARD_COUNT))
+        throw std::invalid_argument("invalid deduction record");
+
+    Bot::Card card = Bot::NotesMatrix::card(record.card);
+    std::string player = Bot::playerToStr(Bot::Player(record.player));
+    std::string rule = std::string(" (") + rules[record.rule] + ")";
+
+    switch (record.fact) {
+        case HAS:
+            return "Deduced that " + player + " has " + card.str() + rule;
+        case LACKS:
+            return "Deduced that " + player + " lacks " + card.str() + rule;
+        case SAW:
+            return "Deduced that " + player + " saw " + card.str() + rule;
+        case LOW_PROBABILITY:
+            return "Identified " + card.str() + " as a low probability card";
+        case HIGH_PROBABILITY:
+            return "Identified " + card.str() + " as a high probability card";
+        case VERY_HIGH_PROBABILITY:
+            return "Identified " + card.str() + " as a very high probability card";
+        case ENVELOPE: {
+            static const char* types[] = { "player", "weapon", "room" };
+            return "SOLVED: " + card.str() + " is the envelope " + types[card.type] + rule;
+        }
+        default:
+            break;
+    }
+
+    return "";
+}
+
+std::vector<std::string> DeductionLog::messages() const
+{
+    std::vector<std::string> out;
+    out.reserve(size());
+    for (size_t i = 0; i < size(); i++)
+        out.push_back(format((*this)[i]));
+    return out;
+}
+
+// vim: set expandtab textwidth=100:
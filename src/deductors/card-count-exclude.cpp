@@ -24,32 +24,40 @@ CardCountExcludeDeductor::CardCountExcludeDeductor(Bot::Player player, std::vect
     }
 }
 
-bool CardCountExcludeDeductor::run(Bot::SuggestionLog log, std::map<Bot::Player, std::map<Bot::Card,
-        Bot::Notes>>& notes)
+bool CardCountExcludeDeductor::run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes)
 {
-    const int totalCards = 18; // 21 total - 3 in envelope
-    const int cardsPerPlayer = (totalCards - (totalCards % order.size())) / order.size();
     bool found = false;
 
-    for (auto player : order) {
-        int cc = 0;
-        for (auto c : notes[player])
-            if (c.second.has && !c.second.table)
-                cc++;
-
-        if (cc >= cardsPerPlayer) {
-            for (auto c : allCards) {
-                if (!notes[player][c].has && !notes[player][c].lacks) {
-                    LOG_LOGIC("Deduced that " + Bot::playerToStr(player) + " lacks " +
-                            std::string(c) + " (card-count-exclude)");
-                    notes[player][c].lacks = true;
-                    found = true;
-                }
-            }
-        }
-    }
+    for (auto player : order)
+        if (deduce(player, notes))
+            found = true;
 
     return found;
 }
 
+bool CardCountExcludeDeductor::deduce(Bot::Player player, Bot::NotesMatrix& notes)
+{
+    const int totalCards = 18; // 21 total - 3 in envelope
+    const int cardsPerPlayer = (totalCards - (totalCards % order.size())) / order.size();
+
+    Bot::NotesMatrix::CardMask has = notes.cards(player, Bot::NotesMatrix::HAS);
+    int cc = __builtin_popcount(has & ~notes.cards(player, Bot::NotesMatrix::TABLE));
+
+    if (cc < cardsPerPlayer)
+        return false;
+
+    Bot::NotesMatrix::CardMask unknown = Bot::NotesMatrix::ALL_CARDS &
+        ~(has | notes.cards(player, Bot::NotesMatrix::LACKS));
+
+    if (!unknown)
+        return false;
+
+    for (auto c : allCards)
+        if (unknown & Bot::NotesMatrix::mask(c))
+            deduced(DeductionLog::CARD_COUNT_EXCLUDE, DeductionLog::LACKS, player, c);
+    notes.set(player, unknown, Bot::NotesMatrix::LACKS);
+
+    return true;
+}
+
 // vim: set expandtab textwidth=100:
@@ -0,0 +1,363 @@
+/**
+ * \file constraint.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../../include/deductors/constraint.h"
+#include <algorithm>
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+}
+
+const int ConstraintDeductor::MAX_PROBES;
+
+ConstraintDeductor::ConstraintDeductor(Bot::Player player, std::vector<Bot::Player> order) :
+    order(order),
+    head(0),
+    logSize(0)
+{
+    this->player = player;
+
+    for (auto& k : known)
+        for (auto& p : k)
+            p = 0;
+}
+
+bool ConstraintDeductor::run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes)
+{
+    const int n = order.size();
+
+    auto unchanged = [&]() {
+        if (log.log().size() != logSize)
+            return false;
+        for (auto p : order)
+            if ((notes.cards(p, NM::HAS) != known[0][p]) ||
+                    (notes.cards(p, NM::LACKS) != known[1][p]))
+                return false;
+        return true;
+    };
+
+    auto remember = [&]() {
+        logSize = log.log().size();
+        for (auto p : order) {
+            known[0][p] = notes.cards(p, NM::HAS);
+            known[1][p] = notes.cards(p, NM::LACKS);
+        }
+    };
+
+    if (unchanged())
+        return false;
+
+    // the notes contradict each other, which one of the other deductors will have to sort out
+    if (!build(log, notes) || !propagate() || !probe()) {
+        remember();
+        return false;
+    }
+
+    NM::CardMask table = 0;
+    for (auto p : order)
+        table |= notes.cards(p, NM::TABLE);
+
+    // the table cards are left as they are, the bot has them and everyone else lacks them
+    bool found = false;
+    for (int i = 0; i < n; i++) {
+        Bot::Player p = order[i];
+        for (int c = 0; c < CARD_COUNT; c++) {
+            if (table & (NM::CardMask(1) << c))
+                continue;
+
+            Bot::Card card = NM::card(c);
+            if ((value[var(i, c)] > 0) && !notes.get(p, card, NM::HAS)) {
+                deduced(DeductionLog::CONSTRAINT, DeductionLog::HAS, p, card);
+                notes.set(p, card, NM::HAS);
+                notes.set(p, card, NM::DEDUCED);
+                found = true;
+            } else if ((value[var(i, c)] < 0) && !notes.get(p, card, NM::LACKS)) {
+                deduced(DeductionLog::CONSTRAINT, DeductionLog::LACKS, p, card);
+                notes.set(p, card, NM::LACKS);
+                found = true;
+            }
+        }
+    }
+
+    remember();
+    return found;
+}
+
+bool ConstraintDeductor::build(const Bot::SuggestionLog& log, const Bot::NotesMatrix& notes)
+{
+    const int n = order.size();
+    const int totalCards = 18; // 21 total - 3 in envelope
+    const int cardsPerPlayer = (totalCards - (totalCards % n)) / n;
+
+    std::fill(value, value + VAR_COUNT, 0);
+    for (auto& c : constraintsOf)
+        c.clear();
+    for (auto& w : watches)
+        w.clear();
+    cardinalities.clear();
+    clauses.clear();
+    trail.clear();
+    head = 0;
+
+    NM::CardMask table = 0;
+    for (auto p : order)
+        table |= notes.cards(p, NM::TABLE);
+
+    // the table cards aren't known yet, so the cards can't be divided between the hands
+    if (CARD_COUNT - __builtin_popcount(table) != n * cardsPerPlayer + 3)
+        return false;
+
+    auto add = [&](std::vector<int> vars, int count) {
+        for (int v : vars)
+            constraintsOf[v].push_back(cardinalities.size());
+        cardinalities.push_back({ vars, count, 0, 0 });
+    };
+
+    // every card is in exactly one place, the envelope is the last location
+    for (int c = 0; c < CARD_COUNT; c++) {
+        if (table & (NM::CardMask(1) << c))
+            continue;
+        std::vector<int> vars;
+        for (int i = 0; i <= n; i++)
+            vars.push_back(var(i, c));
+        add(vars, 1);
+    }
+
+    // every hand has a fixed size
+    for (int i = 0; i < n; i++) {
+        std::vector<int> vars;
+        for (int c = 0; c < CARD_COUNT; c++)
+            if (!(table & (NM::CardMask(1) << c)))
+                vars.push_back(var(i, c));
+        add(vars, cardsPerPlayer);
+    }
+
+    // the envelope has one card of every type
+    for (auto type : { Bot::Card::PLAYER, Bot::Card::WEAPON, Bot::Card::ROOM }) {
+        std::vector<int> vars;
+        for (int c = 0; c < CARD_COUNT; c++)
+            if (NM::typeMask(type) & (NM::CardMask(1) << c))
+                vars.push_back(var(n, c));
+        add(vars, 1);
+    }
+
+    // table cards are nowhere
+    for (int c = 0; c < CARD_COUNT; c++)
+        if (table & (NM::CardMask(1) << c))
+            for (int i = 0; i <= n; i++)
+                if (!assign(var(i, c), false))
+                    return false;
+
+    for (int i = 0; i < n; i++) {
+        NM::CardMask has = notes.cards(order[i], NM::HAS) & ~table;
+        NM::CardMask lacks = notes.cards(order[i], NM::LACKS) & ~table;
+        for (int c = 0; c < CARD_COUNT; c++) {
+            if ((has & (NM::CardMask(1) << c)) && !assign(var(i, c), true))
+                return false;
+            if ((lacks & (NM::CardMask(1) << c)) && !assign(var(i, c), false))
+                return false;
+        }
+    }
+
+    NM::CardMask envelope = notes.cards(player, NM::ENVELOPE);
+    for (int c = 0; c < CARD_COUNT; c++)
+        if ((envelope & (NM::CardMask(1) << c)) && !assign(var(n, c), true))
+            return false;
+
+    auto location = [&](Bot::Player p) {
+        return int(std::find(order.begin(), order.end(), p) - order.begin());
+    };
+
+    for (const auto& l : log.log()) {
+        int start = location(l.from);
+        if (start >= n)
+            continue;
+
+        NM::CardMask sug = NM::mask(l.suggestion) & ~table;
+
+        // everyone before the player that showed lacks the suggested cards
+        for (int pos = (start + 1) % n; pos != start; pos = (pos + 1) % n) {
+            if (l.showed && (order[pos] == l.show))
+                break;
+            for (int c = 0; c < CARD_COUNT; c++)
+                if ((sug & (NM::CardMask(1) << c)) && !assign(var(pos, c), false))
+                    return false;
+        }
+
+        int show = location(l.show);
+        if (!l.showed || (show >= n))
+            continue;
+
+        Clause clause;
+        clause.size = 0;
+        for (int c = 0; c < CARD_COUNT; c++)
+            if (sug & (NM::CardMask(1) << c))
+                clause.vars[clause.size++] = var(show, c);
+
+        if (!clause.size)
+            return false;
+        if (clause.size == 1) {
+            if (!assign(clause.vars[0], true))
+                return false;
+            continue;
+        }
+
+        watches[clause.vars[0]].push_back(clauses.size());
+        watches[clause.vars[1]].push_back(clauses.size());
+        clauses.push_back(clause);
+
+        // the watches only react to variables that are cleared from now on, so check the
+        // variables that have already been cleared here
+        int open = 0;
+        int last = -1;
+        bool satisfied = false;
+        for (int k = 0; k < clause.size; k++) {
+            if (value[clause.vars[k]] > 0)
+                satisfied = true;
+            else if (!value[clause.vars[k]]) {
+                open++;
+                last = clause.vars[k];
+            }
+        }
+        if (!satisfied && !open)
+            return false;
+        if (!satisfied && (open == 1) && !assign(last, true))
+            return false;
+    }
+
+    return true;
+}
+
+bool ConstraintDeductor::assign(int v, bool set)
+{
+    int val = set ? 1 : -1;
+    if (value[v])
+        return value[v] == val;
+
+    value[v] = val;
+    for (int c : constraintsOf[v]) {
+        if (set)
+            cardinalities[c].set++;
+        else
+            cardinalities[c].cleared++;
+    }
+    trail.push_back(v);
+
+    return true;
+}
+
+bool ConstraintDeductor::propagate()
+{
+    while (head < trail.size()) {
+        int v = trail[head++];
+
+        for (int ci : constraintsOf[v]) {
+            Cardinality& c = cardinalities[ci];
+            int unknown = c.vars.size() - c.set - c.cleared;
+
+            if ((c.set > c.count) || (c.set + unknown < c.count))
+                return false;
+            if (!unknown)
+                continue;
+
+            // either the constraint is full and the rest are cleared, or all the rest are needed
+            if ((c.set == c.count) || (c.set + unknown == c.count)) {
+                bool set = c.set != c.count;
+                for (int u : c.vars)
+                    if (!value[u] && !assign(u, set))
+                        return false;
+            }
+        }
+
+        if (value[v] > 0)
+            continue;
+
+        // v was cleared, so every clause watching it needs another variable to watch
+        auto& w = watches[v];
+        for (size_t k = 0; k < w.size();) {
+            Clause& clause = clauses[w[k]];
+            if (clause.vars[0] == v)
+                std::swap(clause.vars[0], clause.vars[1]);
+            int other = clause.vars[0];
+
+            if (value[other] > 0) {
+                k++;
+                continue;
+            }
+
+            bool moved = false;
+            for (int j = 2; j < clause.size; j++) {
+                if (value[clause.vars[j]] >= 0) {
+                    std::swap(clause.vars[1], clause.vars[j]);
+                    watches[clause.vars[1]].push_back(w[k]);
+                    w[k] = w.back();
+                    w.pop_back();
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved)
+                continue;
+
+            if (!assign(other, true))
+                return false;
+            k++;
+        }
+    }
+
+    return true;
+}
+
+void ConstraintDeductor::undo(size_t mark)
+{
+    while (trail.size() > mark) {
+        int v = trail.back();
+        trail.pop_back();
+        for (int c : constraintsOf[v]) {
+            if (value[v] > 0)
+                cardinalities[c].set--;
+            else
+                cardinalities[c].cleared--;
+        }
+        value[v] = 0;
+    }
+    head = mark;
+}
+
+bool ConstraintDeductor::probe()
+{
+    const int vars = (order.size() + 1) * CARD_COUNT;
+
+    int probes = 0;
+    bool changed = true;
+    while (changed && (probes < MAX_PROBES)) {
+        changed = false;
+
+        for (int v = 0; (v < vars) && (probes < MAX_PROBES); v++) {
+            for (bool set : { true, false }) {
+                if (value[v])
+                    break;
+
+                probes++;
+                size_t mark = trail.size();
+                bool consistent = assign(v, set) && propagate();
+                undo(mark);
+
+                // if the variable can't have this value it must have the other one
+                if (!consistent) {
+                    if (!assign(v, !set) || !propagate())
+                        return false;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// vim: set expandtab textwidth=100:
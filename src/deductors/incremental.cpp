@@ -0,0 +1,156 @@
+/**
+ * \file incremental.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../../include/deductors/incremental.h"
+
+using namespace AI;
+
+namespace {
+    // the attributes that can trigger new deductions, in the same order as the known masks
+    const Bot::NotesMatrix::Attribute tracked[] = { Bot::NotesMatrix::HAS,
+        Bot::NotesMatrix::LACKS, Bot::NotesMatrix::SEEN };
+}
+
+IncrementalDeductor::IncrementalDeductor(Bot::Player player, std::vector<Bot::Player> order) :
+    order(order),
+    localExclude(player),
+    noShow(player, order),
+    seen(player),
+    cardCount(player, order)
+{
+    this->player = player;
+
+    players = 0;
+    for (auto o : order)
+        players |= Bot::NotesMatrix::playerBit(o);
+
+    reset();
+}
+
+void IncrementalDeductor::reset()
+{
+    for (auto& i : index)
+        i.clear();
+    indexed = 0;
+
+    for (auto& k : known)
+        for (auto& p : k)
+            p = 0;
+
+    worklist.clear();
+}
+
+void IncrementalDeductor::setDeductionLog(DeductionLog* log)
+{
+    deductions = log;
+    localExclude.setDeductionLog(log);
+    noShow.setDeductionLog(log);
+    seen.setDeductionLog(log);
+    cardCount.setDeductionLog(log);
+}
+
+void IncrementalDeductor::setLogSink(LogSink* sink)
+{
+    logSink = sink;
+    localExclude.setLogSink(sink);
+    noShow.setLogSink(sink);
+    seen.setLogSink(sink);
+    cardCount.setLogSink(sink);
+}
+
+bool IncrementalDeductor::run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes)
+{
+    const auto& entries = log.log();
+
+    if (entries.size() < indexed)
+        reset();
+
+    // anything that changed since the last run was done by someone else, so we only made a
+    // deduction if more facts get queued after this
+    collect(notes);
+    size_t external = worklist.size();
+
+    // new log entries haven't been looked at at all yet
+    for (; indexed < entries.size(); indexed++) {
+        const auto& l = entries[indexed];
+
+        index[Bot::NotesMatrix::index(l.suggestion.player)].push_back(indexed);
+        index[Bot::NotesMatrix::index(l.suggestion.weapon)].push_back(indexed);
+        index[Bot::NotesMatrix::index(l.suggestion.room)].push_back(indexed);
+
+        noShow.deduce(l, notes);
+        examine(l, notes);
+    }
+
+    collect(notes);
+
+    for (size_t head = 0; head < worklist.size(); head++) {
+        Fact f = worklist[head];
+
+        switch (f.attribute) {
+            case Bot::NotesMatrix::HAS:
+                if (players & Bot::NotesMatrix::playerBit(f.player)) {
+                    markLacking(f.player, f.card, notes);
+                    cardCount.deduce(f.player, notes);
+                }
+                break;
+            case Bot::NotesMatrix::LACKS:
+                // lacking a card can complete a local-exclude or seen deduction where the player
+                // showed a card
+                for (auto e : index[f.card])
+                    if (entries[e].showed && (entries[e].show == f.player))
+                        examine(entries[e], notes);
+                break;
+            case Bot::NotesMatrix::SEEN:
+                for (auto e : index[f.card])
+                    if (entries[e].showed && (entries[e].from == f.player))
+                        seen.deduce(entries[e], notes);
+                break;
+            default:
+                break;
+        }
+
+        collect(notes);
+    }
+
+    bool found = worklist.size() > external;
+    worklist.clear();
+
+    return found;
+}
+
+void IncrementalDeductor::collect(const Bot::NotesMatrix& notes)
+{
+    for (int a = 0; a < 3; a++) {
+        for (int p = 0; p < Bot::NotesMatrix::PLAYER_COUNT; p++) {
+            Bot::NotesMatrix::CardMask cur = notes.cards(Bot::Player(p), tracked[a]);
+            Bot::NotesMatrix::CardMask added = cur & ~known[a][p];
+            known[a][p] = cur;
+
+            while (added) {
+                int c = __builtin_ctz(added);
+                added &= added - 1;
+                worklist.push_back({ Bot::Player(p), c, tracked[a] });
+            }
+        }
+    }
+}
+
+void IncrementalDeductor::examine(const Bot::SuggestionLogItem& item, Bot::NotesMatrix& notes)
+{
+    localExclude.deduce(item, notes);
+    seen.deduce(item, notes);
+}
+
+void IncrementalDeductor::markLacking(Bot::Player player, int card, Bot::NotesMatrix& notes)
+{
+    Bot::Card c = Bot::NotesMatrix::card(card);
+
+    for (auto o : order)
+        if ((o != player) && !notes.get(o, c, Bot::NotesMatrix::LACKS))
+            notes.set(o, c, Bot::NotesMatrix::LACKS);
+}
+
+// vim: set expandtab textwidth=100:
@@ -12,43 +12,40 @@ LocalExcludeDeductor::LocalExcludeDeductor(Bot::Player player)
     this->player = player;
 }
 
-bool LocalExcludeDeductor::run(Bot::SuggestionLog log, std::map<Bot::Player,
-        std::map<Bot::Card, Bot::Notes>>& notes)
+bool LocalExcludeDeductor::run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes)
 {
-    auto logi = log.log();
     bool found = false;
 
-    for (auto l : logi) {
-        if (!l.showed)
-            continue;
+    for (const auto& l : log.log())
+        if (deduce(l, notes))
+            found = true;
 
-        Bot::Suggestion sug = l.suggestion;
+    return found;
+}
 
-        if ((notes[l.show][sug.player].lacks && notes[l.show][sug.weapon].lacks) &&
-                !notes[l.show][sug.room].concluded()) {
-            found = true;
-            LOG_LOGIC("Deduced that " + Bot::playerToStr(l.show) + " has " +
-                    Bot::roomToStr(sug.room) + " (local-exclude)");
-            notes[l.show][sug.room].has = true;
-            notes[l.show][sug.room].deduced = true;
-        } else if ((notes[l.show][sug.player].lacks && notes[l.show][sug.room].lacks) &&
-                !notes[l.show][sug.weapon].concluded()) {
-            found = true;
-            LOG_LOGIC("Deduced that " + Bot::playerToStr(l.show) + " has " +
-                    Bot::weaponToStr(sug.weapon) + " (local-exclude)");
-            notes[l.show][sug.weapon].has = true;
-            notes[l.show][sug.weapon].deduced = true;
-        } else if ((notes[l.show][sug.weapon].lacks && notes[l.show][sug.room].lacks) &&
-                !notes[l.show][sug.player].concluded()) {
-            found = true;
-            LOG_LOGIC("Deduced that " + Bot::playerToStr(l.show) + " has " +
-                    Bot::playerToStr(sug.player) + " (local-exclude)");
-            notes[l.show][sug.player].has = true;
-            notes[l.show][sug.player].deduced = true;
+bool LocalExcludeDeductor::deduce(const Bot::SuggestionLogItem& l, Bot::NotesMatrix& notes)
+{
+    if (!l.showed)
+        return false;
+
+    Bot::Suggestion sug = l.suggestion;
+    Bot::NotesMatrix::CardMask sugMask = Bot::NotesMatrix::mask(sug);
+    Bot::NotesMatrix::CardMask lacks = notes.cards(l.show, Bot::NotesMatrix::LACKS);
+    Bot::NotesMatrix::CardMask concluded = lacks | notes.cards(l.show, Bot::NotesMatrix::HAS);
+
+    // if the player lacks the other two cards and we're unsure of the third, they have it
+    for (auto c : { Bot::Card(sug.room), Bot::Card(sug.weapon), Bot::Card(sug.player) }) {
+        Bot::NotesMatrix::CardMask others = sugMask & ~Bot::NotesMatrix::mask(c);
+
+        if (((lacks & others) == others) && !(concluded & Bot::NotesMatrix::mask(c))) {
+            deduced(DeductionLog::LOCAL_EXCLUDE, DeductionLog::HAS, l.show, c);
+            notes.set(l.show, c, Bot::NotesMatrix::HAS);
+            notes.set(l.show, c, Bot::NotesMatrix::DEDUCED);
+            return true;
         }
     }
 
-    return found;
+    return false;
 }
 
 // vim: set expandtab textwidth=100:
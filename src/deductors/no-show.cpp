@@ -13,59 +13,70 @@ NoShowDeductor::NoShowDeductor(Bot::Player player, std::vector<Bot::Player> orde
     this->player = player;
 }
 
-bool NoShowDeductor::run(Bot::SuggestionLog log, std::map<Bot::Player,
-        std::map<Bot::Card, Bot::Notes>>& notes)
+bool NoShowDeductor::run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes)
 {
     bool found = false;
 
-    for (auto l : log.log()) {
-        size_t start = 0;
-        while ((order[start] != l.from) && (start < order.size()))
-            start++;
+    for (const auto& l : log.log())
+        if (deduce(l, notes))
+            found = true;
 
-        // not doing anything about this error since it is unlikely to occur and non-fatal. If it
-        // does occur it will alert the user but not much else.
-        if (start >= order.size()) {
-            LOG_ERR("ran out of players in order - order array is probably wrong");
-            continue;
-        }
+    return found;
+}
+
+bool NoShowDeductor::deduce(const Bot::SuggestionLogItem& l, Bot::NotesMatrix& notes)
+{
+    bool found = false;
+
+    size_t start = 0;
+    while ((order[start] != l.from) && (start < order.size()))
+        start++;
 
-        size_t end = start + 1;
-
-        if (l.showed) {
-            while (end != start) {
-                if (end >= order.size())
-                    end = 0;
-                if (order[end] == l.show)
-                    break;
-                end++;
-            }
-        } else
-            end = start;
-
-        // not doing anything about this error since it is unlikely to occur and non-fatal. If it
-        // does occur it will alert the user but not much else.
-        if ((end == start) && l.showed) {
-            LOG_ERR("player not found in order - order array is probably wrong");
-            continue;
+    // not doing anything about this error since it is unlikely to occur and non-fatal. If it
+    // does occur it will alert the user but not much else.
+    if (start >= order.size()) {
+        LOG_ERR("ran out of players in order - order array is probably wrong");
+        return false;
+    }
+
+    size_t end = start + 1;
+
+    if (l.showed) {
+        while (end != start) {
+            if (end >= order.size())
+                end = 0;
+            if (order[end] == l.show)
+                break;
+            end++;
         }
+    } else
+        end = start;
 
-        size_t pos = ((start + 1) == order.size()) ? 0 : start + 1;
-        while (pos != end) {
+    // not doing anything about this error since it is unlikely to occur and non-fatal. If it
+    // does occur it will alert the user but not much else.
+    if ((end == start) && l.showed) {
+        LOG_ERR("player not found in order - order array is probably wrong");
+        return false;
+    }
+
+    size_t pos = ((start + 1) == order.size()) ? 0 : start + 1;
+    while (pos != end) {
+        Bot::NotesMatrix::CardMask concluded = notes.cards(order[pos], Bot::NotesMatrix::HAS) |
+            notes.cards(order[pos], Bot::NotesMatrix::LACKS);
+        Bot::NotesMatrix::CardMask lacking = Bot::NotesMatrix::mask(l.suggestion) & ~concluded;
+
+        if (lacking) {
+            found = true;
             for (auto c : { Bot::Card(l.suggestion.player), Bot::Card(l.suggestion.weapon),
-                    Bot::Card(l.suggestion.room) }) {
-                if (!notes[order[pos]][c].concluded()) {
-                    found = true;
-                    LOG_LOGIC("Deduced that " + Bot::playerToStr(order[pos]) + " lacks " +
-                            std::string(c) + " (no-show)");
-                    notes[order[pos]][c].lacks = true;
-                }
-            }
-
-            pos++;
-            if (pos >= order.size())
-                pos = 0;
+                    Bot::Card(l.suggestion.room) })
+                if (lacking & Bot::NotesMatrix::mask(c))
+                    deduced(DeductionLog::NO_SHOW, DeductionLog::LACKS, order[pos], c);
+            notes.set(order[pos], lacking, Bot::NotesMatrix::LACKS);
         }
+
+        pos++;
+        if (pos >= order.size())
+            pos = 0;
     }
 
     return found;
@@ -12,39 +12,39 @@ SeenDeductor::SeenDeductor(Bot::Player player)
     this->player = player;
 }
 
-bool SeenDeductor::run(Bot::SuggestionLog log, std::map<Bot::Player, std::map<Bot::Card,
-        Bot::Notes>>& notes)
+bool SeenDeductor::run(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes)
 {
     bool found = false;
 
-    for (auto l : log.log()) {
-        if (!l.showed)
-            continue;
+    for (const auto& l : log.log())
+        if (deduce(l, notes))
+            found = true;
 
-        Bot::Suggestion sug = l.suggestion;
+    return found;
+}
 
-        if (notes[l.show][sug.player].lacks && notes[l.show][sug.weapon].lacks &&
-                !notes[l.from][sug.room].seen) {
-            found = true;
-            LOG_LOGIC("Deduced that " + Bot::playerToStr(l.from) + " saw " +
-                    Bot::roomToStr(sug.room) + " (seen)");
-            notes[l.from][sug.room].seen = true;
-        } else if (notes[l.show][sug.player].lacks && notes[l.show][sug.room].lacks &&
-                !notes[l.from][sug.weapon].seen) {
-            found = true;
-            LOG_LOGIC("Deduced that " + Bot::playerToStr(l.from) + " saw " +
-                    Bot::weaponToStr(sug.weapon) + " (seen)");
-            notes[l.from][sug.weapon].seen = true;
-        } else if (notes[l.show][sug.weapon].lacks && notes[l.show][sug.room].lacks &&
-                !notes[l.from][sug.player].seen) {
-            found = true;
-            LOG_LOGIC("Deduced that " + Bot::playerToStr(l.from) + " saw " +
-                    Bot::playerToStr(sug.player) + " (seen)");
-            notes[l.from][sug.player].seen = true;
+bool SeenDeductor::deduce(const Bot::SuggestionLogItem& l, Bot::NotesMatrix& notes)
+{
+    if (!l.showed)
+        return false;
+
+    Bot::Suggestion sug = l.suggestion;
+    Bot::NotesMatrix::CardMask sugMask = Bot::NotesMatrix::mask(sug);
+    Bot::NotesMatrix::CardMask lacks = notes.cards(l.show, Bot::NotesMatrix::LACKS);
+    Bot::NotesMatrix::CardMask seen = notes.cards(l.from, Bot::NotesMatrix::SEEN);
+
+    // if the showing player lacks the other two cards, they must have shown the third
+    for (auto c : { Bot::Card(sug.room), Bot::Card(sug.weapon), Bot::Card(sug.player) }) {
+        Bot::NotesMatrix::CardMask others = sugMask & ~Bot::NotesMatrix::mask(c);
+
+        if (((lacks & others) == others) && !(seen & Bot::NotesMatrix::mask(c))) {
+            deduced(DeductionLog::SEEN, DeductionLog::SAW, l.from, c);
+            notes.set(l.from, c, Bot::NotesMatrix::SEEN);
+            return true;
         }
     }
 
-    return found;
+    return false;
 }
 
 // vim: set expandtab textwidth=100:
@@ -1,18 +1,42 @@
 #! /usr/bin/env python3
 
-# This will generate C++ code that can build a graph for the map using the
-# contents of map.txt
+# This will generate the C++ arrays that hold the graph for the map in board.h
+# using the contents of map.txt
+#
+# The graph is stored in compressed sparse row form: the neighbours of every
+# position are stored one after the other in NEIGHBOURS, and the neighbours of
+# position i are NEIGHBOURS[NEIGHBOUR_OFFSETS[i]] up to (but not including)
+# NEIGHBOURS[NEIGHBOUR_OFFSETS[i + 1]]. The neighbours of a position are kept in
+# the order their connections appear in map.txt.
+
+BOARD_SIZE = 83
+INDENT = ' ' * 8
+
+graph = [[] for _ in range(BOARD_SIZE)]
 
 with open('map.txt', 'r') as f:
     for line in f.readlines():
         line = line.strip()
-        if not line:
-            print("")
-        elif line.startswith('#'):
-            nl = line.strip('#')
-            nl = '//' * (len(line) - len(nl)) + ' ' + nl.strip()
-            print(nl)
-        else:
-            left, right = line.split()
-            print("graph[{}].push_back({});".format(left, right))
-            print("graph[{}].push_back({});".format(right, left))
+        if not line or line.startswith('#'):
+            continue
+        left, right = map(int, line.split())
+        graph[left].append(right)
+        graph[right].append(left)
+
+offsets = [0]
+for ngh in graph:
+    offsets.append(offsets[-1] + len(ngh))
+
+print(INDENT + 'const int EDGE_COUNT = {};'.format(offsets[-1]))
+print('')
+print(INDENT + 'constexpr uint16_t NEIGHBOUR_OFFSETS[BOARD_SIZE + 1] = {')
+for i in range(0, len(offsets), 10):
+    row = ', '.join('{:3}'.format(o) for o in offsets[i:i + 10])
+    print(INDENT + '    ' + row + ',')
+print(INDENT + '};')
+print('')
+print(INDENT + 'constexpr uint8_t NEIGHBOURS[EDGE_COUNT] = {')
+for pos, ngh in enumerate(graph):
+    row = ' '.join('{},'.format(n) for n in ngh)
+    print(INDENT + '    ' + row + ' // ' + str(pos))
+print(INDENT + '};')
@@ -0,0 +1,448 @@
+/**
+ * \file host.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../include/host.h"
+#include "../include/macros.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace AI;
+
+const int BotHost::BATCH;
+
+namespace {
+    // the host and worker the current thread belongs to, if it is a worker thread
+    thread_local BotHost* localHost = nullptr;
+    thread_local int localWorker = -1;
+}
+
+BotHost::Hosted::Hosted() :
+    head(&stub),
+    tail(&stub),
+    pending(0)
+{
+    stub.next = nullptr;
+}
+
+BotHost::Hosted::~Hosted()
+{
+    while (Task* task = tail->next.load(std::memory_order_acquire)) {
+        if (tail != &stub)
+            delete tail;
+        tail = task;
+    }
+
+    if (tail != &stub)
+        delete tail;
+}
+
+void BotHost::Hosted::push(Task* task)
+{
+    task->next.store(nullptr, std::memory_order_relaxed);
+    Task* prev = head.exchange(task, std::memory_order_acq_rel);
+    prev->next.store(task, std::memory_order_release);
+}
+
+BotHost::Task* BotHost::Hosted::pop()
+{
+    // the task was counted in pending, but the thread that pushed it might not have linked it to
+    // the previous task yet
+    Task* next;
+    while (!(next = tail->next.load(std::memory_order_acquire)))
+        std::this_thread::yield();
+
+    // the task that was popped last stays in the list until the next pop, so that head always
+    // points to a task
+    if (tail != &stub)
+        delete tail;
+    tail = next;
+
+    return next;
+}
+
+BotHost::BotHost(int threads) :
+    nextWorker(0),
+    scheduled(0),
+    sleeping(0),
+    stopping(false),
+    thinkAhead(false),
+    thinkerCount(0),
+    tasks(0)
+{
+    if (threads < 0)
+        throw std::invalid_argument("amount of threads can't be negative");
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    errorHandler = [](Handle, std::exception_ptr e) {
+        try {
+            std::rethrow_exception(e);
+        } catch (std::exception& ex) {
+            LOG_ERR("hosted bot failed: " << ex.what());
+        } catch (...) {
+            LOG_ERR("hosted bot failed");
+        }
+    };
+
+    for (int w = 0; w < threads; w++)
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    for (int w = 0; w < threads; w++)
+        pool.push_back(std::thread(&BotHost::work, this, w));
+}
+
+BotHost::~BotHost()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> l(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& t : pool)
+        t.join();
+
+    for (auto h : hosted)
+        delete h;
+}
+
+BotHost::Handle BotHost::add(Bot::Player player, std::vector<Bot::Player> order, uint64_t seed)
+{
+    std::unique_ptr<Hosted> h(new Hosted());
+    h->bot.reset(new Bot(player, order, seed));
+
+    std::lock_guard<std::mutex> l(hostedLock);
+    hosted.insert(h.get());
+
+    return h.release();
+}
+
+void BotHost::remove(Handle bot)
+{
+    Task* task = new Task();
+    task->remove = true;
+    queue(bot, task);
+}
+
+void BotHost::post(Handle bot, std::function<void(Bot&)> task)
+{
+    Task* t = new Task();
+    t->run = std::move(task);
+    queue(bot, t);
+}
+
+void BotHost::queue(Hosted* bot, Task* task)
+{
+    tasks.fetch_add(1, std::memory_order_relaxed);
+
+    bot->push(task);
+    if (bot->pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+        schedule(bot);
+}
+
+void BotHost::schedule(Hosted* bot)
+{
+    // workers keep the bots they schedule themselves, which are usually the bots they just ran
+    int w = (localHost == this) ? localWorker :
+        nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+    // counted before it is queued, so that scheduled never drops below 0 when it is taken at once
+    scheduled.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> l(workers[w]->lock);
+        workers[w]->queue.push_back(bot);
+    }
+
+    if (sleeping.load()) {
+        std::lock_guard<std::mutex> l(sleepLock);
+        wake.notify_one();
+    }
+}
+
+BotHost::Hosted* BotHost::take(int worker)
+{
+    const int n = workers.size();
+
+    // our own bots first, then the ones of the other workers
+    for (int i = 0; i < n; i++) {
+        Worker& w = *workers[(worker + i) % n];
+
+        std::lock_guard<std::mutex> l(w.lock);
+        if (!w.queue.empty()) {
+            Hosted* bot = w.queue.front();
+            w.queue.pop_front();
+            scheduled.fetch_sub(1);
+            return bot;
+        }
+    }
+
+    return nullptr;
+}
+
+void BotHost::run(Hosted* bot)
+{
+    // only the tasks that were counted when we started are run, which bounds the batch
+    int ran = std::min(bot->pending.load(std::memory_order_acquire), BATCH);
+
+    for (int i = 0; i < ran; i++) {
+        Task* task = bot->pop();
+
+        if (task->remove) {
+            removeThinker(bot);
+            bot->bot.reset();
+            continue;
+        }
+
+        try {
+            if (!bot->bot)
+                throw std::logic_error("the bot was removed");
+            task->run(*bot->bot);
+        } catch (...) {
+            errorHandler(bot, std::current_exception());
+        }
+
+        // the task stays in the queue until the next one is popped, but what it holds on to (like
+        // a promise) can go now
+        task->run = nullptr;
+    }
+
+    // handed to the idle workers while we still own it, so that it can't be removed meanwhile
+    bool done = thinkAhead && bot->bot && (bot->pending.load(std::memory_order_acquire) == ran);
+
+    if (release(bot, ran, done)) {
+        schedule(bot);
+    } else if (!bot->bot) {
+        {
+            std::lock_guard<std::mutex> l(hostedLock);
+            hosted.erase(bot);
+        }
+        delete bot;
+    }
+
+    if (tasks.fetch_sub(ran, std::memory_order_acq_rel) == ran) {
+        std::lock_guard<std::mutex> l(idleLock);
+        idle.notify_all();
+    }
+}
+
+int BotHost::release(Hosted* bot, int ran, bool think)
+{
+    if (!think)
+        return bot->pending.fetch_sub(ran, std::memory_order_acq_rel) - ran;
+
+    int left;
+    {
+        std::lock_guard<std::mutex> l(thinkLock);
+        if (!bot->thinking && thinkAhead) {
+            bot->place = thinkers.insert(thinkers.end(), bot);
+            bot->thinking = true;
+            thinkerCount.fetch_add(1);
+        }
+
+        // released under the lock, so that a worker that takes the bot from thinkers never finds
+        // it still held by us
+        left = bot->pending.fetch_sub(ran, std::memory_order_acq_rel) - ran;
+    }
+
+    if (sleeping.load()) {
+        std::lock_guard<std::mutex> l(sleepLock);
+        wake.notify_one();
+    }
+
+    return left;
+}
+
+void BotHost::removeThinker(Hosted* bot)
+{
+    // a worker only thinks for the bot while it holds it, so it can't be thinking now
+    std::lock_guard<std::mutex> l(thinkLock);
+    if (bot->thinking) {
+        thinkers.erase(bot->place);
+        bot->thinking = false;
+        thinkerCount.fetch_sub(1);
+    }
+}
+
+bool BotHost::think()
+{
+    Hosted* bot;
+    {
+        std::lock_guard<std::mutex> l(thinkLock);
+        if (thinkers.empty())
+            return false;
+
+        bot = thinkers.front();
+        thinkers.pop_front();
+        bot->thinking = false;
+        thinkerCount.fetch_sub(1);
+
+        // the bot is held the same way as a bot with tasks, so that the tasks that are queued
+        // meanwhile wait for the step instead of running on another worker. A bot that has tasks
+        // already is handed back by the worker that runs them.
+        int none = 0;
+        if (!bot->pending.compare_exchange_strong(none, 1, std::memory_order_acq_rel))
+            return true;
+    }
+
+    bool more = false;
+    try {
+        more = bot->bot->thinkAhead();
+    } catch (...) {
+        errorHandler(bot, std::current_exception());
+    }
+
+    if (release(bot, 1, more))
+        schedule(bot);
+
+    return true;
+}
+
+void BotHost::work(int worker)
+{
+    localHost = this;
+    localWorker = worker;
+
+    while (true) {
+        Hosted* bot = take(worker);
+        if (bot) {
+            run(bot);
+            continue;
+        }
+
+        // one step at a time, so that bots with tasks are taken as soon as possible
+        if (!stopping && think())
+            continue;
+
+        // sleeping is raised before checking for bots, so that a thread that schedules a bot
+        // after the check always sees that there is a worker to wake up
+        std::unique_lock<std::mutex> l(sleepLock);
+        sleeping.fetch_add(1);
+        while (!scheduled.load() && !thinkerCount.load() && !stopping)
+            wake.wait(l);
+        sleeping.fetch_sub(1);
+
+        if (stopping && !scheduled.load())
+            return;
+    }
+}
+
+void BotHost::setCards(Handle bot, std::vector<Bot::Card> cards, bool tableCards)
+{
+    post(bot, [cards, tableCards](Bot& b) { b.setCards(cards, tableCards); });
+}
+
+void BotHost::updateBoard(Handle bot, std::vector<std::pair<Bot::Player, Position>> players)
+{
+    post(bot, [players](Bot& b) { b.updateBoard(players); });
+}
+
+void BotHost::movePlayer(Handle bot, Bot::Player player, Position position)
+{
+    post(bot, [player, position](Bot& b) { b.movePlayer(player, position); });
+}
+
+void BotHost::madeSuggestion(Handle bot, Bot::Player player, Bot::Suggestion suggestion,
+        bool accuse)
+{
+    post(bot, [player, suggestion, accuse](Bot& b) {
+        b.madeSuggestion(player, suggestion, accuse);
+    });
+}
+
+void BotHost::otherShownCard(Handle bot, Bot::Player showed)
+{
+    post(bot, [showed](Bot& b) { b.otherShownCard(showed); });
+}
+
+void BotHost::noOtherShownCard(Handle bot)
+{
+    post(bot, [](Bot& b) { b.noOtherShownCard(); });
+}
+
+void BotHost::showCard(Handle bot, Bot::Player player, Bot::Card card)
+{
+    post(bot, [player, card](Bot& b) { b.showCard(player, card); });
+}
+
+void BotHost::noShowCard(Handle bot)
+{
+    post(bot, [](Bot& b) { b.noShowCard(); });
+}
+
+void BotHost::newTurn(Handle bot)
+{
+    post(bot, [](Bot& b) { b.newTurn(); });
+}
+
+std::future<int> BotHost::getMove(Handle bot, int allowedMoves)
+{
+    return call<int>(bot, [allowedMoves](Bot& b) { return b.getMove(allowedMoves); });
+}
+
+void BotHost::getMove(Handle bot, int allowedMoves, std::function<void(int)> done)
+{
+    call<int>(bot, [allowedMoves](Bot& b) { return b.getMove(allowedMoves); }, done);
+}
+
+std::future<Bot::Suggestion> BotHost::getSuggestion(Handle bot)
+{
+    return call<Bot::Suggestion>(bot, [](Bot& b) { return b.getSuggestion(); });
+}
+
+void BotHost::getSuggestion(Handle bot, std::function<void(Bot::Suggestion)> done)
+{
+    call<Bot::Suggestion>(bot, [](Bot& b) { return b.getSuggestion(); }, done);
+}
+
+std::future<Bot::Card> BotHost::getCard(Handle bot, Bot::Player player,
+        std::vector<Bot::Card> cards)
+{
+    return call<Bot::Card>(bot, [player, cards](Bot& b) { return b.getCard(player, cards); });
+}
+
+void BotHost::getCard(Handle bot, Bot::Player player, std::vector<Bot::Card> cards,
+        std::function<void(Bot::Card)> done)
+{
+    call<Bot::Card>(bot, [player, cards](Bot& b) { return b.getCard(player, cards); }, done);
+}
+
+void BotHost::setErrorHandler(ErrorHandler handler)
+{
+    errorHandler = handler;
+}
+
+void BotHost::setThinkAhead(bool enabled)
+{
+    thinkAhead = enabled;
+
+    if (!enabled) {
+        std::lock_guard<std::mutex> l(thinkLock);
+        for (auto h : thinkers)
+            h->thinking = false;
+        thinkers.clear();
+        thinkerCount = 0;
+    }
+}
+
+void BotHost::wait()
+{
+    std::unique_lock<std::mutex> l(idleLock);
+    while (tasks.load(std::memory_order_acquire))
+        idle.wait(l);
+}
+
+int BotHost::threads() const
+{
+    return pool.size();
+}
+
+int BotHost::size()
+{
+    std::lock_guard<std::mutex> l(hostedLock);
+    return hosted.size();
+}
+
+// vim: set expandtab textwidth=100:
@@ -4,36 +4,265 @@
  */
 
 #include "../include/macros.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <mutex>
 
 using namespace AI;
 
 LogicLog logicLog;
-std::vector<std::string> LogicLog::log;
-int LogicLog::lastPos = 0;
-std::mutex lock;
 
-void LogicLog::addLog(std::string msg)
+const int LogicLog::CAPACITY;
+const int LogicLog::LINE_LENGTH;
+const int LogSink::CAPACITY;
+
+namespace {
+    const int WORDS = LogicLog::LINE_LENGTH / 8;
+
+    /**
+     * \brief A single line in a ring buffer
+     *
+     * The slot is protected by a sequence lock: the version is odd while the owning thread is
+     * writing the line, and a reader only keeps what it copied if the version was even and didn't
+     * change while it was copying. Everything is stored in atomics so that a reader racing with
+     * the writer only ever sees a torn line, which it then throws away.
+     */
+    struct Slot {
+        std::atomic<uint64_t> version;
+        std::atomic<uint64_t> number;
+        std::atomic<uint32_t> length;
+        std::atomic<uint64_t> text[WORDS];
+    };
+
+    struct Ring {
+        Slot slots[LogicLog::CAPACITY];
+
+        /**
+         * \brief Amount of lines written, only used by the thread that owns the ring
+         */
+        uint64_t written;
+
+        /**
+         * \brief True while a thread is writing to the ring
+         */
+        std::atomic<bool> owned;
+    };
+
+    /**
+     * \brief The number of the next line, shared by all the threads
+     */
+    std::atomic<uint64_t> nextNumber(1);
+
+    /**
+     * \brief Guards the list of ring buffers and the position of readFromLast()
+     *
+     * This is only taken by readers and by threads that log for the first time.
+     */
+    std::mutex lock;
+    std::vector<Ring*> rings;
+    uint64_t lastRead = 0;
+
+    /**
+     * \brief Gives the thread's ring buffer back once the thread exits
+     */
+    struct Owner {
+        Ring* ring = nullptr;
+
+        ~Owner()
+        {
+            if (ring)
+                ring->owned.store(false, std::memory_order_release);
+        }
+    };
+
+    thread_local Owner owner;
+
+    /**
+     * \brief Takes over the ring buffer of a thread that has exited, or makes a new one
+     */
+    Ring* acquireRing()
+    {
+        std::lock_guard<std::mutex> l(lock);
+
+        for (auto r : rings) {
+            bool owned = false;
+            if (r->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+                return r;
+        }
+
+        // value-initialised, so every slot starts out empty
+        Ring* r = new Ring();
+        r->owned.store(true, std::memory_order_relaxed);
+        rings.push_back(r);
+        return r;
+    }
+}
+
+void LogicLog::addLog(const std::string& msg)
 {
-    std::lock_guard<std::mutex> l(lock);
+    if (!owner.ring)
+        owner.ring = acquireRing();
 
-    log.push_back(msg);
+    Ring& r = *owner.ring;
+    Slot& s = r.slots[r.written % CAPACITY];
+    r.written++;
+
+    uint64_t version = s.version.load(std::memory_order_relaxed);
+    s.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint32_t length = std::min(msg.size(), size_t(LINE_LENGTH));
+    s.number.store(nextNumber.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    s.length.store(length, std::memory_order_relaxed);
+    for (uint32_t w = 0; w * 8 < length; w++) {
+        uint64_t word = 0;
+        memcpy(&word, msg.data() + w * 8, std::min(length - w * 8, 8u));
+        s.text[w].store(word, std::memory_order_relaxed);
+    }
+
+    s.version.store(version + 2, std::memory_order_release);
+}
+
+std::vector<std::string> LogicLog::read(uint64_t from, uint64_t& last)
+{
+    std::vector<std::pair<uint64_t, std::string>> lines;
+    char text[LINE_LENGTH];
+
+    // every line with a lower number was at least started, so a slot it is written to is seen
+    // either with an odd version or with the finished line
+    uint64_t end = nextNumber.load(std::memory_order_acquire);
+    last = end - 1;
+
+    for (auto r : rings) {
+        // the highest number in the ring, and whether a line is still being written to it
+        uint64_t newest = 0;
+        bool writing = false;
+
+        for (auto& s : r->slots) {
+            uint64_t version = s.version.load(std::memory_order_acquire);
+            if (version == 0)
+                continue;
+            if (version & 1) {
+                writing = true;
+                continue;
+            }
+
+            uint64_t number = s.number.load(std::memory_order_relaxed);
+            uint32_t length = std::min(s.length.load(std::memory_order_relaxed),
+                    uint32_t(LINE_LENGTH));
+            for (uint32_t w = 0; w * 8 < length; w++) {
+                uint64_t word = s.text[w].load(std::memory_order_relaxed);
+                memcpy(text + w * 8, &word, 8);
+            }
+
+            // the line was overwritten while it was being copied
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.version.load(std::memory_order_relaxed) != version) {
+                writing = true;
+                continue;
+            }
+
+            if (number >= end)
+                continue;
+            newest = std::max(newest, number);
+            if (number > from)
+                lines.push_back({ number, std::string(text, length) });
+        }
+
+        // the line that is being written comes after the ones that are done, and the lines after
+        // it are left for the next read so that it isn't skipped
+        if (writing)
+            last = std::min(last, std::max(newest, from));
+    }
+
+    std::sort(lines.begin(), lines.end(), [](const std::pair<uint64_t, std::string>& a,
+                const std::pair<uint64_t, std::string>& b) { return a.first < b.first; });
+
+    std::vector<std::string> ret;
+    ret.reserve(lines.size());
+    for (auto& l : lines) {
+        if (l.first > last)
+            break;
+        ret.push_back(std::move(l.second));
+    }
+
+    return ret;
 }
 
 std::vector<std::string> LogicLog::readFromLast()
 {
     std::lock_guard<std::mutex> l(lock);
 
-    auto ret = std::vector<std::string>(log.begin() + lastPos, log.end());
-    lastPos = log.size();
-    return ret;
+    return read(lastRead, lastRead);
 }
 
 std::vector<std::string> LogicLog::readFull()
 {
     std::lock_guard<std::mutex> l(lock);
 
-    return log;
+    uint64_t last;
+    return read(0, last);
+}
+
+LogSink::LogSink(Level level, int capacity) :
+    lines(capacity > 0 ? capacity : 1),
+    level(level)
+{}
+
+void LogSink::setLevel(Level level)
+{
+    this->level.store(level, std::memory_order_relaxed);
+}
+
+LogSink::Level LogSink::getLevel() const
+{
+    return Level(level.load(std::memory_order_relaxed));
+}
+
+void LogSink::add(Level level, const std::string& msg)
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    // assigning reuses the memory of the line that is overwritten
+    lines[added % lines.size()] = msg;
+    added++;
+}
+
+std::vector<std::string> LogSink::readFromLast()
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    std::vector<std::string> out = read(lastRead);
+    lastRead = added;
+    return out;
+}
+
+std::vector<std::string> LogSink::readFull()
+{
+    std::lock_guard<std::mutex> l(lock);
+
+    return read(0);
+}
+
+std::vector<std::string> LogSink::read(uint64_t from)
+{
+    if (added > lines.size())
+        from = std::max<uint64_t>(from, added - lines.size());
+
+    std::vector<std::string> out;
+    out.reserve(added - from);
+    for (uint64_t i = from; i < added; i++)
+        out.push_back(lines[i % lines.size()]);
+    return out;
+}
+
+void LogSink::write(LogSink* sink, Level level, const std::string& msg)
+{
+    if (sink)
+        sink->add(level, msg);
+    else
+        LogicLog::addLog(msg);
 }
 
 // vim: set expandtab textwidth=100:
@@ -0,0 +1,128 @@
+/**
+ * \file metrics.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../include/metrics.h"
+#include <algorithm>
+
+using namespace AI;
+
+const int Metrics::BUCKETS;
+
+thread_local Metrics* Metrics::active = nullptr;
+
+void Metrics::Histogram::add(uint64_t ns)
+{
+    calls++;
+    totalNs += ns;
+    maxNs = std::max(maxNs, ns);
+
+    int bucket = ns ? 63 - __builtin_clzll(ns) : 0;
+    buckets[std::min(bucket, BUCKETS - 1)]++;
+}
+
+void Metrics::Histogram::merge(const Histogram& other)
+{
+    calls += other.calls;
+    totalNs += other.totalNs;
+    maxNs = std::max(maxNs, other.maxNs);
+    for (int i = 0; i < BUCKETS; i++)
+        buckets[i] += other.buckets[i];
+}
+
+uint64_t Metrics::Histogram::percentile(double p) const
+{
+    if (!calls)
+        return 0;
+
+    uint64_t target = std::max<uint64_t>(1, uint64_t(p * calls + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target)
+            return std::min(uint64_t(1) << (i + 1), maxNs);
+    }
+
+    return maxNs;
+}
+
+void Metrics::merge(const Metrics& other)
+{
+    for (int t = 0; t < TIMER_COUNT; t++)
+        timers[t].merge(other.timers[t]);
+
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        counters[c] += other.counters[c];
+}
+
+bool Metrics::empty() const
+{
+    for (auto& t : timers)
+        if (t.calls)
+            return false;
+    for (auto c : counters)
+        if (c)
+            return false;
+    return true;
+}
+
+void Metrics::print(std::ostream& out) const
+{
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+
+    for (int t = 0; t < TIMER_COUNT; t++) {
+        const Histogram& h = timers[t];
+        if (!h.calls)
+            continue;
+
+        out << name(Timer(t)) << " calls=" << h.calls << " mean_us=" << us(h.totalNs / h.calls) <<
+            " p50_us=" << us(h.percentile(0.5)) << " p99_us=" << us(h.percentile(0.99)) <<
+            " max_us=" << us(h.maxNs) << "\n";
+    }
+
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        if (counters[c])
+            out << name(Counter(c)) << " count=" << counters[c] << "\n";
+}
+
+const char* Metrics::name(Timer timer)
+{
+    switch (timer) {
+        case GET_MOVE: return "getMove";
+        case GET_SUGGESTION: return "getSuggestion";
+        case GET_CARD: return "getCard";
+        case NOTES_HOOK: return "notesHook";
+        case SEEN_PREDICTOR: return "seenPredictor";
+        case MULTIPLE_PREDICTOR: return "multiplePredictor";
+        case NO_SHOW_PREDICTOR: return "noShowPredictor";
+        case PROBABILITY_PREDICTOR: return "probabilityPredictor";
+        case THINK_AHEAD: return "thinkAhead";
+        case TIMER_COUNT: break;
+    }
+
+    return "";
+}
+
+const char* Metrics::name(Counter counter)
+{
+    switch (counter) {
+        case DEDUCTOR_RUNS: return "deductorRuns";
+        case DEDUCTOR_ITERATIONS: return "deductorIterations";
+        case LOCAL_EXCLUDE_FACTS: return "localExcludeFacts";
+        case NO_SHOW_FACTS: return "noShowFacts";
+        case SEEN_FACTS: return "seenFacts";
+        case CARD_COUNT_EXCLUDE_FACTS: return "cardCountExcludeFacts";
+        case CONSTRAINT_FACTS: return "constraintFacts";
+        case PATH_CALLS: return "pathCalls";
+        case PATH_SEARCHES: return "pathSearches";
+        case PATH_NODES: return "pathNodes";
+        case THOUGHT_ANSWERS: return "thoughtAnswers";
+        case PROBABILITY_FALLBACKS: return "probabilityFallbacks";
+        case COUNTER_COUNT: break;
+    }
+
+    return "";
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,209 @@
+/**
+ * \file information.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../../include/planners/information.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+
+    int envelopeIndex(const NM::CardMask envelope)
+    {
+        int p = __builtin_ctz(envelope & NM::PLAYER_CARDS);
+        int w = __builtin_ctz(envelope & NM::WEAPON_CARDS) - (int(Bot::MAX_PLAYER) + 1);
+        int r = __builtin_ctz(envelope & NM::ROOM_CARDS) -
+            (int(Bot::MAX_PLAYER) + int(Bot::MAX_WEAPON) + 2);
+        return (p * (int(Bot::MAX_WEAPON) + 1) + w) * (int(Bot::MAX_ROOM) + 1) + r;
+    }
+
+    Bot::Suggestion candidate(int pair, Bot::Room room)
+    {
+        return Bot::Suggestion(Bot::Player(pair / (int(Bot::MAX_WEAPON) + 1)),
+                Bot::Weapon(pair % (int(Bot::MAX_WEAPON) + 1)), room);
+    }
+}
+
+const uint8_t InformationPlanner::NOBODY;
+const int InformationPlanner::MOVE_CANDIDATES;
+const int InformationPlanner::WEIGHT;
+
+InformationPlanner::InformationPlanner(Bot::Player player, std::vector<Bot::Player> order,
+        int budget, ParticleOptions options, uint64_t seed) :
+    order(order),
+    player(player),
+    budget(budget),
+    particles(player, order, options, seed),
+    envelopeEntropy(0),
+    candidates(0),
+    envelopeCounts(ENVELOPE_COUNT, 0),
+    joint(ANSWER_COUNT * ENVELOPE_COUNT, 0)
+{
+    for (int i = 0; i < PAIR_COUNT; i++)
+        ranked[i] = i;
+}
+
+bool InformationPlanner::update(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log)
+{
+    const int n = order.size();
+    const int count = particles.update(notes, log) ? particles.alive() : 0;
+
+    envelopes.resize(count);
+    distances.resize(count * CARD_COUNT);
+    envelopeEntropy = 0;
+    if (!count)
+        return false;
+
+    const int me = std::find(order.begin(), order.end(), player) - order.begin();
+
+    std::fill(envelopeCounts.begin(), envelopeCounts.end(), 0);
+    for (int i = 0; i < count; i++) {
+        const NM::CardMask* hands = particles.hands(i);
+        uint8_t* distance = &distances[i * CARD_COUNT];
+
+        std::fill(distance, distance + CARD_COUNT, NOBODY);
+        for (int loc = 0; loc < n; loc++) {
+            if (loc == me)
+                continue;
+            for (NM::CardMask m = hands[loc]; m; m &= m - 1)
+                distance[__builtin_ctz(m)] = (loc - me + n) % n;
+        }
+
+        envelopes[i] = envelopeIndex(hands[n]);
+        envelopeCounts[envelopes[i]]++;
+    }
+
+    for (int c : envelopeCounts)
+        if (c)
+            envelopeEntropy -= double(c) / count * std::log2(double(c) / count);
+
+    // the weights of an answer can be at most the weight of all the deals
+    for (int w = xlogx.size(); w <= WEIGHT * count; w++)
+        xlogx.push_back(w ? w * std::log2(double(w)) : 0);
+
+    // the cards we are least sure about are evaluated first, in case the budget runs out
+    double uncertainty[PAIR_COUNT];
+    for (int i = 0; i < PAIR_COUNT; i++) {
+        ranked[i] = i;
+        double p = particles.envelope(Bot::Player(i / (int(Bot::MAX_WEAPON) + 1)));
+        double w = particles.envelope(Bot::Weapon(i % (int(Bot::MAX_WEAPON) + 1)));
+        uncertainty[i] = p * (1 - p) + w * (1 - w);
+    }
+    std::stable_sort(ranked, ranked + PAIR_COUNT,
+            [&](int a, int b) { return uncertainty[a] > uncertainty[b]; });
+
+    return true;
+}
+
+bool InformationPlanner::plan(Bot::Room room, const Bot::NotesMatrix& notes,
+        const Bot::SuggestionLog& log, Bot::Suggestion& suggestion)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    candidates = 0;
+    if (!update(notes, log))
+        return false;
+
+    double best = -1;
+    for (int pair : ranked) {
+        if (candidates && budget) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            if (std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() >= budget)
+                break;
+        }
+
+        Bot::Suggestion sug = candidate(pair, room);
+        double g = gain(sug);
+        candidates++;
+        if (g > best) {
+            best = g;
+            suggestion = sug;
+        }
+    }
+
+    return true;
+}
+
+bool InformationPlanner::roomGains(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log,
+        double gains[Bot::MAX_ROOM + 1])
+{
+    if (!update(notes, log))
+        return false;
+
+    for (int r = 0; r <= int(Bot::MAX_ROOM); r++) {
+        gains[r] = 0;
+        for (int i = 0; i < MOVE_CANDIDATES; i++)
+            gains[r] = std::max(gains[r], gain(candidate(ranked[i], Bot::Room(r))));
+    }
+
+    return true;
+}
+
+double InformationPlanner::gain(const Bot::Suggestion& suggestion)
+{
+    const int count = envelopes.size();
+    if (!count)
+        return 0;
+
+    const int cards[3] = { NM::index(suggestion.player), NM::index(suggestion.weapon),
+        NM::index(suggestion.room) };
+
+    std::fill(answers, answers + ANSWER_COUNT, 0);
+    touched.clear();
+
+    auto add = [&](int answer, int envelope, int weight) {
+        int& j = joint[answer * ENVELOPE_COUNT + envelope];
+        if (!j)
+            touched.push_back(answer * ENVELOPE_COUNT + envelope);
+        j += weight;
+        answers[answer] += weight;
+    };
+
+    for (int i = 0; i < count; i++) {
+        const uint8_t* distance = &distances[i * CARD_COUNT];
+        uint8_t first = std::min(std::min(distance[cards[0]], distance[cards[1]]),
+                distance[cards[2]]);
+
+        if (first == NOBODY) {
+            add(0, envelopes[i], WEIGHT);
+            continue;
+        }
+
+        // the player can show any of the suggested cards they have
+        int choices = (distance[cards[0]] == first) + (distance[cards[1]] == first) +
+            (distance[cards[2]] == first);
+        for (int k = 0; k < 3; k++)
+            if (distance[cards[k]] == first)
+                add(1 + (first - 1) * 3 + k, envelopes[i], WEIGHT / choices);
+    }
+
+    // H(E | A) = sum over a and e of P(a, e) * log(P(a) / P(a, e)), which with the weights w
+    // summing to W is (sum over a of w(a) log w(a) - sum over a and e of w(a, e) log w(a, e)) / W
+    double expected = 0;
+    for (int t : touched) {
+        expected -= xlogx[joint[t]];
+        joint[t] = 0;
+    }
+    for (int a : answers)
+        expected += xlogx[a];
+    expected /= double(WEIGHT) * count;
+
+    return std::max(0.0, envelopeEntropy - expected);
+}
+
+double InformationPlanner::entropy() const
+{
+    return envelopeEntropy;
+}
+
+int InformationPlanner::evaluated() const
+{
+    return candidates;
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,50 @@
+/**
+ * \file move.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../../include/planners/move.h"
+#include <cmath>
+
+using namespace AI;
+
+constexpr double MovePlanner::DISCOUNT;
+const int MovePlanner::AVERAGE_ROLL;
+
+MovePlanner::MovePlanner() :
+    occupied(Board::BOARD_SIZE, false)
+{
+}
+
+int MovePlanner::plan(int start, int allowedMoves, const double values[Board::ROOM_COUNT])
+{
+    Position::Reach reach = Position(start).reach(occupied);
+
+    int best = -1;
+    double bestScore = 0;
+    int bestDist = 0;
+
+    for (int room = 1; room < Board::ROOM_COUNT; room++) {
+        if (!reach.reachable(room) || (values[room] <= 0))
+            continue;
+
+        int dist = reach.distance(room);
+        int turns = dist <= allowedMoves ? 0 :
+            (dist - allowedMoves + AVERAGE_ROLL - 1) / AVERAGE_ROLL;
+        double score = values[room] * std::pow(DISCOUNT, turns);
+
+        // the closer room wins a tie, since the rooms after it can still be visited later
+        if ((best == -1) || (score > bestScore) || ((score == bestScore) && (dist < bestDist))) {
+            best = room;
+            bestScore = score;
+            bestDist = dist;
+        }
+    }
+
+    if (best == -1)
+        return start;
+
+    return reach.partial(best, allowedMoves);
+}
+
+// vim: set expandtab textwidth=100:
@@ -5,10 +5,272 @@
 
 #include "../include/position.h"
 #include "../include/board.h"
+#include "../include/metrics.h"
 #include <stdexcept>
+#include <algorithm>
+#include <cstdint>
 
 using namespace AI;
 
+namespace {
+    /**
+     * \brief Walks back from the state last to the start, storing the positions on the way
+     *
+     * parent must hold the state every state was reached from, or -1 for the start. The positions
+     * are stored from last back to (but not including) the start, so steps must have room for
+     * Position::Reach::STATES of them.
+     *
+     * \returns the amount of positions stored
+     */
+    int walkBack(const int16_t* parent, int last, int* steps)
+    {
+        int count = 0;
+        for (int s = last; parent[s] != -1; s = parent[s])
+            steps[count++] = s / Board::ROOM_COUNT;
+        return count;
+    }
+
+    /**
+     * \brief Returns the path from start to the state last, see walkBack()
+     */
+    Position::Path buildPath(int start, const int16_t* parent, int last)
+    {
+        int steps[Position::Reach::STATES];
+        int count = walkBack(parent, last, steps);
+
+        Position::Path p(start);
+        while (count > 0)
+            p.append(steps[--count]);
+
+        return p;
+    }
+
+    /**
+     * \brief Shortest path search over the board
+     *
+     * A state in the search is a position together with the amount of turns that were left when it
+     * was reached, since going through a room other than the starting one uses up a turn. Moving
+     * directly from one room to another doesn't cost anything and every other step costs one, so
+     * the states are visited breadth first from a double ended queue: free steps go to the front
+     * and the rest to the back. Everything is kept in flat arrays that are reused between searches,
+     * so searching doesn't allocate.
+     */
+    class Search {
+        public:
+            static const uint8_t UNREACHABLE = 0xff;
+
+            /**
+             * \brief Searches from start until dest is reached, or until everything that can be
+             * reached has been found if dest is -1
+             */
+            void run(int start, int dest, const std::vector<bool>& occupied, int turns);
+
+            /**
+             * \brief Returns the distance to pos, or UNREACHABLE if it wasn't reached
+             */
+            int dist(int pos) const;
+
+            /**
+             * \brief Returns the position just before pos on the path to it
+             */
+            int previous(int pos) const;
+
+            /**
+             * \brief Returns the path to pos
+             * \note pos must have been reached
+             */
+            Position::Path path(int pos) const;
+
+            /**
+             * \brief Returns the state pos was first reached in, or -1 if it wasn't reached
+             */
+            int reached(int pos) const { return best[pos]; }
+
+            /**
+             * \brief Returns the state the given state was reached from, or -1 for the start
+             */
+            int from(int s) const { return parent[s]; }
+
+        private:
+            static const int STATES = Position::Reach::STATES;
+
+            static int state(int pos, int turns)
+            {
+                return pos * Board::ROOM_COUNT + turns - 1;
+            }
+
+            int start;
+
+            uint8_t distance[STATES];
+            int16_t parent[STATES];
+
+            /**
+             * \brief The state every position was first taken from the queue in, which is the one
+             * with the shortest distance, or -1
+             */
+            int16_t best[Board::BOARD_SIZE];
+
+            /**
+             * \brief Ring buffer for the queue, a state is only queued again if its distance
+             * improves and that can happen at most once
+             */
+            int16_t queue[2 * STATES];
+    };
+
+    const uint8_t Search::UNREACHABLE;
+
+    void Search::run(int start, int dest, const std::vector<bool>& occupied, int turns)
+    {
+        // there are fewer rooms than this to go through, so more turns won't make a difference
+        if (turns > Board::ROOM_COUNT)
+            turns = Board::ROOM_COUNT;
+
+        this->start = start;
+        std::fill(distance, distance + STATES, UNREACHABLE);
+        std::fill(parent, parent + STATES, -1);
+        std::fill(best, best + Board::BOARD_SIZE, -1);
+
+        const int capacity = 2 * STATES;
+        int head = 0;
+        int size = 0;
+
+        int first = state(start, turns);
+        distance[first] = 0;
+        parent[first] = -1;
+        queue[size++] = first;
+
+        METRIC_COUNT(Metrics::PATH_SEARCHES, 1);
+
+        while (size > 0) {
+            int s = queue[head];
+            head = (head + 1) % capacity;
+            size--;
+            METRIC_COUNT(Metrics::PATH_NODES, 1);
+
+            int pos = s / Board::ROOM_COUNT;
+            int left = s % Board::ROOM_COUNT + 1;
+
+            if (best[pos] == -1)
+                best[pos] = s;
+            if (pos == dest)
+                break;
+
+            // occupied tiles, the middle room and rooms without turns left can only be entered
+            if (pos != start) {
+                if (pos >= Board::ROOM_COUNT) {
+                    if (occupied[pos])
+                        continue;
+                } else if ((pos == 0) || (left <= 1))
+                    continue;
+                else
+                    left--;
+            }
+
+            for (int ngh : Board::neighbours(pos)) {
+                if (ngh == start)
+                    continue;
+
+                bool free = (pos < Board::ROOM_COUNT) && (ngh < Board::ROOM_COUNT);
+                int n = state(ngh, left);
+                int d = distance[s] + (free ? 0 : 1);
+
+                if (d >= distance[n])
+                    continue;
+
+                distance[n] = d;
+                parent[n] = s;
+
+                if (free) {
+                    head = (head + capacity - 1) % capacity;
+                    queue[head] = n;
+                } else
+                    queue[(head + size) % capacity] = n;
+                size++;
+            }
+        }
+    }
+
+    int Search::dist(int pos) const
+    {
+        return best[pos] == -1 ? UNREACHABLE : distance[best[pos]];
+    }
+
+    int Search::previous(int pos) const
+    {
+        int p = parent[best[pos]];
+        return p == -1 ? pos : p / Board::ROOM_COUNT;
+    }
+
+    Position::Path Search::path(int pos) const
+    {
+        return buildPath(start, parent, best[pos]);
+    }
+
+    /**
+     * \brief Returns the search buffer for the current thread
+     */
+    Search& scratch()
+    {
+        static thread_local Search search;
+        return search;
+    }
+
+    /**
+     * \brief Checks the arguments of a search
+     * \throw std::invalid_argument if occupied isn't the size of the board or turns is less than 1
+     */
+    void checkSearch(const std::vector<bool>& occupied, int turns)
+    {
+        if (occupied.size() != Board::BOARD_SIZE)
+            throw std::invalid_argument("occupied vector must be the size of the board");
+        if (turns < 1)
+            throw std::invalid_argument("turns must be at least 1");
+    }
+
+    /**
+     * \brief Occupied vector for an empty board
+     */
+    const std::vector<bool>& unoccupied()
+    {
+        static const std::vector<bool> none(Board::BOARD_SIZE, false);
+        return none;
+    }
+
+    /**
+     * \brief The shortest paths between all positions on the empty board with turns = 1
+     *
+     * For every starting position this holds the distance to every other position and the position
+     * just before it on the path, so a path can be rebuilt by walking back from the destination.
+     */
+    struct EmptyBoard {
+        uint8_t dist[Board::BOARD_SIZE][Board::BOARD_SIZE];
+        uint8_t previous[Board::BOARD_SIZE][Board::BOARD_SIZE];
+
+        EmptyBoard();
+    };
+
+    EmptyBoard::EmptyBoard()
+    {
+        Search& search = scratch();
+
+        for (int start = 0; start < Board::BOARD_SIZE; start++) {
+            search.run(start, -1, unoccupied(), 1);
+
+            for (int pos = 0; pos < Board::BOARD_SIZE; pos++) {
+                dist[start][pos] = search.dist(pos);
+                if (dist[start][pos] != Search::UNREACHABLE)
+                    previous[start][pos] = search.previous(pos);
+            }
+        }
+    }
+
+    const EmptyBoard& emptyBoard()
+    {
+        static const EmptyBoard table;
+        return table;
+    }
+}
+
 Position::Path::Path(int start_pos)
 {
     path.push_back(start_pos);
@@ -73,95 +335,152 @@ Position::Position(int pos) :
                 std::to_string(Board::BOARD_SIZE-1) + ", inclusive");
 }
 
-std::vector<int> Position::getNeighbours()
+Board::Neighbours Position::getNeighbours() const
 {
-    return Board::board[this->position];
+    return Board::neighbours(position);
 }
 
-Position::Path Position::path(const Position other, std::vector<bool> occupied, int turns)
+Position::Reach::Reach(int start, const std::vector<bool>& occupied, int turns) :
+    start(start)
 {
-    if (occupied.size() != Board::BOARD_SIZE)
-        throw std::invalid_argument("occupied vector must be the size of the board");
-    if (turns < 1)
-        throw std::invalid_argument("turns must be at least 1");
+    checkSearch(occupied, turns);
+
+    // on the empty board with one turn the paths can be copied from the table instead
+    if ((turns == 1) && (std::find(occupied.begin(), occupied.end(), true) == occupied.end())) {
+        const EmptyBoard& table = emptyBoard();
+
+        std::fill(parent, parent + STATES, -1);
+        for (int pos = 0; pos < Board::BOARD_SIZE; pos++) {
+            dist[pos] = table.dist[start][pos];
+            best[pos] = dist[pos] == Search::UNREACHABLE ? -1 : pos * Board::ROOM_COUNT;
+            if ((best[pos] != -1) && (pos != start))
+                parent[best[pos]] = table.previous[start][pos] * Board::ROOM_COUNT;
+        }
 
-    // same position
-    if (other.position == position)
-        return Path(position);
+        return;
+    }
 
-    SPInfo info;
+    Search& search = scratch();
+    search.run(start, -1, occupied, turns);
 
-    info.start = position;
-    info.dest = other.position;
-    info.occupied = occupied;
-    info.visited = std::vector<bool>(Board::BOARD_SIZE, false);
-    info.spMap = std::vector<Path>(Board::BOARD_SIZE, position);
+    for (int pos = 0; pos < Board::BOARD_SIZE; pos++) {
+        dist[pos] = search.dist(pos);
+        best[pos] = search.reached(pos);
+    }
+    for (int s = 0; s < STATES; s++)
+        parent[s] = search.from(s);
+}
 
-    shortestPath(info, turns);
+void Position::Reach::check(int pos) const
+{
+    if (dist[pos] == Search::UNREACHABLE)
+        throw std::runtime_error("unable to find valid path from " + std::to_string(start) +
+                " to " + std::to_string(pos));
+}
 
-    if (info.spMap[info.dest].empty())
-        throw std::runtime_error("unable to find valid path from " + std::to_string(position) +
-                " to " + std::to_string(other.position));
-    return info.spMap[info.dest];
+bool Position::Reach::reachable(int pos) const
+{
+    return dist[pos] != Search::UNREACHABLE;
 }
 
-Position::Path Position::path(const Position other)
+int Position::Reach::distance(int pos) const
 {
-    return path(other, std::vector<bool>(Board::BOARD_SIZE, false), 1);
+    check(pos);
+    return dist[pos];
 }
 
-Position::Path Position::path(const Position other, int turns)
+int Position::Reach::next(int pos) const
 {
-    return path(other, std::vector<bool>(Board::BOARD_SIZE, false), turns);
+    check(pos);
+
+    int s = best[pos];
+    while ((parent[s] != -1) && (parent[parent[s]] != -1))
+        s = parent[s];
+
+    return s / Board::ROOM_COUNT;
 }
 
-Position::Path Position::path(const Position other, std::vector<bool> occupied)
+Position::Path Position::Reach::path(int pos) const
 {
-    return path(other, occupied, 1);
+    check(pos);
+    return buildPath(start, parent, best[pos]);
 }
 
-Position::operator int() const
+int Position::Reach::partial(int pos, int moves) const
 {
-    return position;
+    check(pos);
+
+    int steps[STATES];
+    int count = walkBack(parent, best[pos], steps);
+
+    // follow the path in the same way as Path::partial(), stopping at the first room
+    int at = start;
+    int dist = 0;
+    while ((count > 0) && (dist < moves) && ((at >= Board::ROOM_COUNT) || (at == start))) {
+        int next = steps[--count];
+        if (!((at < Board::ROOM_COUNT) && (next < Board::ROOM_COUNT)))
+            dist++;
+        at = next;
+    }
+
+    return at;
 }
 
-void Position::shortestPath(SPInfo& info, int turns)
+Position::Path Position::path(const Position other, const std::vector<bool>& occupied, int turns)
 {
-    info.visited[position] = true;
+    METRIC_COUNT(Metrics::PATH_CALLS, 1);
+    checkSearch(occupied, turns);
 
-    for (auto ngh : getNeighbours()) {
-        // create path from this node to neigbour
-        Path p(info.spMap[position]);
-        p.append(ngh);
+    // same position
+    if (other.position == position)
+        return Path(position);
 
-        // check if newly created path is shorter than the current one
-        if (((info.spMap[ngh].empty()) || (p < info.spMap[ngh])) && (ngh != info.start)) {
-            info.visited[ngh] = false;
-            info.spMap[ngh] = p;
-        }
+    Search& search = scratch();
+    search.run(position, other.position, occupied, turns);
 
-        // skip occupied tile if it's not a room
-        if (info.occupied[ngh] && (ngh >= Board::ROOM_COUNT))
-            continue;
+    if (search.dist(other.position) == Search::UNREACHABLE)
+        throw std::runtime_error("unable to find valid path from " + std::to_string(position) +
+                " to " + std::to_string(other.position));
+    return search.path(other.position);
+}
 
-        // destination found, return
-        if (ngh == info.dest)
-            return;
+Position::Path Position::path(const Position other)
+{
+    METRIC_COUNT(Metrics::PATH_CALLS, 1);
 
-        // skip visited
-        if (info.visited[ngh])
-            continue;
+    // the reach on the empty board is copied from the table, so this doesn't search either
+    return Reach(position, unoccupied(), 1).path(other.position);
+}
 
-        // middle room
-        if (ngh == 0)
-            continue;
+int Position::distance(const Position other) const
+{
+    const EmptyBoard& table = emptyBoard();
 
-        // room and only one turn
-        if ((ngh < Board::ROOM_COUNT) && (turns <= 1))
-            continue;
+    if (table.dist[position][other.position] == Search::UNREACHABLE)
+        throw std::runtime_error("unable to find valid path from " + std::to_string(position) +
+                " to " + std::to_string(other.position));
 
-        Position(ngh).shortestPath(info, ngh < Board::ROOM_COUNT ? turns - 1 : turns);
-    }
+    return table.dist[position][other.position];
+}
+
+Position::Path Position::path(const Position other, int turns)
+{
+    return path(other, unoccupied(), turns);
+}
+
+Position::Path Position::path(const Position other, const std::vector<bool>& occupied)
+{
+    return path(other, occupied, 1);
+}
+
+Position::Reach Position::reach(const std::vector<bool>& occupied, int turns) const
+{
+    return Reach(position, occupied, turns);
+}
+
+Position::operator int() const
+{
+    return position;
 }
 
 // vim: set expandtab textwidth=100:
@@ -23,4 +23,22 @@ bool Predictor::contains(Deck& deck, Bot::Room room)
     return std::find(deck.rooms.begin(), deck.rooms.end(), room) != deck.rooms.end();
 }
 
+void Predictor::setDeductionLog(DeductionLog* log)
+{
+    deductions = log;
+}
+
+void Predictor::setLogSink(LogSink* sink)
+{
+    logSink = sink;
+}
+
+void Predictor::predicted(DeductionLog::Rule rule, DeductionLog::Fact fact, const Bot::Card& card)
+{
+    if (deductions)
+        deductions->add(rule, fact, player, card);
+    else
+        LOG_LOGIC(DeductionLog::format(DeductionLog::record(rule, fact, player, card)));
+}
+
 // vim: set expandtab textwidth=100:
@@ -12,32 +12,28 @@ MultiplePredictor::MultiplePredictor(Bot::Player player)
     this->player = player;
 }
 
-void MultiplePredictor::run(Deck& deck, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>>
-        notes, Bot::SuggestionLog log)
+void MultiplePredictor::run(Deck& deck, const Bot::NotesMatrix& notes,
+        const Bot::SuggestionLog& log)
 {
-    std::map<Bot::Player, std::map<Bot::Card, int>> sc;
-    for (auto l : log.log()) {
+    METRIC_TIMER(Metrics::MULTIPLE_PREDICTOR);
+
+    int sc[Bot::NotesMatrix::PLAYER_COUNT][Bot::NotesMatrix::CARD_COUNT] = {};
+    for (const auto& l : log.log()) {
         Bot::Suggestion sug = l.suggestion;
         Bot::Player player = l.from;
 
-        std::vector<Bot::Card> cards;
-        if (deck.contains(sug.player))
-            cards.push_back(sug.player);
-        if (deck.contains(sug.weapon))
-            cards.push_back(sug.weapon);
-        if (deck.contains(sug.room))
-            cards.push_back(sug.room);
-
-        for (auto card : cards)
-            if (notes[player][card].lacks)
-                sc[player][card]++;
+        Bot::NotesMatrix::CardMask lacks = notes.cards(player, Bot::NotesMatrix::LACKS);
+        for (auto card : { Bot::Card(sug.player), Bot::Card(sug.weapon), Bot::Card(sug.room) })
+            if ((lacks & Bot::NotesMatrix::mask(card)) && deck.contains(card))
+                sc[player][Bot::NotesMatrix::index(card)]++;
     }
 
-    for (auto player : sc) {
-        for (auto card : player.second) {
-            if (card.second > 1) {
-                LOG_LOGIC("Identified " + std::string(card.first) + " as a high probability card");
-                deck.scores[card.first]--;
+    for (int p = 0; p < Bot::NotesMatrix::PLAYER_COUNT; p++) {
+        for (int i = 0; i < Bot::NotesMatrix::CARD_COUNT; i++) {
+            if (sc[p][i] > 1) {
+                Bot::Card card = Bot::NotesMatrix::card(i);
+                predicted(DeductionLog::MULTIPLE_PREDICTOR, DeductionLog::HIGH_PROBABILITY, card);
+                deck.scores[card]--;
             }
         }
     }
@@ -12,31 +12,37 @@ NoShowPredictor::NoShowPredictor(Bot::Player player)
     this->player = player;
 }
 
-void NoShowPredictor::run(Deck& deck, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>>
-        notes, Bot::SuggestionLog log)
+void NoShowPredictor::run(Deck& deck, const Bot::NotesMatrix& notes,
+        const Bot::SuggestionLog& log)
 {
-    for (auto l : log.log()) {
+    METRIC_TIMER(Metrics::NO_SHOW_PREDICTOR);
+
+    for (const auto& l : log.log()) {
         if (l.showed)
             continue;
 
-        Bot::Player from = l.from;
+        Bot::NotesMatrix::CardMask has = notes.cards(l.from, Bot::NotesMatrix::HAS);
 
         Bot::Player p = l.suggestion.player;
         Bot::Weapon w = l.suggestion.weapon;
         Bot::Room r = l.suggestion.room;
 
-        if (notes[from][p].has && notes[from][w].has && deck.contains(r)) {
-            LOG_LOGIC("Identified " + Bot::enumToStr(r) + " as a very high probability card");
+        Bot::NotesMatrix::CardMask pm = Bot::NotesMatrix::mask(Bot::Card(p));
+        Bot::NotesMatrix::CardMask wm = Bot::NotesMatrix::mask(Bot::Card(w));
+        Bot::NotesMatrix::CardMask rm = Bot::NotesMatrix::mask(Bot::Card(r));
+
+        if (((has & (pm | wm)) == (pm | wm)) && deck.contains(r)) {
+            predicted(DeductionLog::NO_SHOW_PREDICTOR, DeductionLog::VERY_HIGH_PROBABILITY, r);
             deck.scores[r] -= 5;
         }
 
-        if (notes[from][p].has && notes[from][r].has && deck.contains(w)) {
-            LOG_LOGIC("Identified " + Bot::enumToStr(w) + " as a very high probability card");
+        if (((has & (pm | rm)) == (pm | rm)) && deck.contains(w)) {
+            predicted(DeductionLog::NO_SHOW_PREDICTOR, DeductionLog::VERY_HIGH_PROBABILITY, w);
             deck.scores[w] -= 5;
         }
 
-        if (notes[from][w].has && notes[from][r].has && deck.contains(p)) {
-            LOG_LOGIC("Identified " + Bot::enumToStr(p) + " as a very high probability card");
+        if (((has & (wm | rm)) == (wm | rm)) && deck.contains(p)) {
+            predicted(DeductionLog::NO_SHOW_PREDICTOR, DeductionLog::VERY_HIGH_PROBABILITY, p);
             deck.scores[p] -= 5;
         }
     }
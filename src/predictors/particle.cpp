@@ -0,0 +1,431 @@
+/**
+ * \file particle.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../../include/predictors/particle.h"
+#include "../../include/predictors/probability.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+
+    const int DEAL_ATTEMPTS = 20;
+    const int REPAIR_STEPS = 50;
+
+    /**
+     * \returns a random card from the mask, or -1 if the mask is empty
+     */
+    int pick(NM::CardMask mask, Random& rng)
+    {
+        int count = __builtin_popcount(mask);
+        if (!count)
+            return -1;
+
+        for (int k = rng() % count; k; k--)
+            mask &= mask - 1;
+        return __builtin_ctz(mask);
+    }
+
+    int typeOf(int card)
+    {
+        return (NM::PLAYER_CARDS >> card) & 1 ? 0 : (NM::WEAPON_CARDS >> card) & 1 ? 1 : 2;
+    }
+}
+
+ParticlePredictor::ParticlePredictor(Bot::Player player, std::vector<Bot::Player> order,
+        ParticleOptions options, uint64_t seed) :
+    order(order),
+    options(options),
+    rng(seed),
+    started(false)
+{
+    this->player = player;
+    reset();
+}
+
+void ParticlePredictor::reset()
+{
+    const int n = order.size();
+    const int totalCards = 18; // 21 total - 3 in envelope
+
+    std::fill(hasCards, hasCards + LOCATION_COUNT, 0);
+    std::fill(lacksCards, lacksCards + LOCATION_COUNT, 0);
+    std::fill(sizes, sizes + LOCATION_COUNT, 0);
+    for (int i = 0; i < n; i++)
+        sizes[i] = (totalCards - (totalCards % n)) / n;
+    sizes[n] = 3;
+
+    tableCards = 0;
+    shows.clear();
+    for (auto& s : showsOf)
+        s.clear();
+    logSize = 0;
+    particles.clear();
+    std::fill(&probs[0][0], &probs[0][0] + LOCATION_COUNT * CARD_COUNT, 0.0);
+}
+
+void ParticlePredictor::run(Deck& deck, const Bot::NotesMatrix& notes,
+        const Bot::SuggestionLog& log)
+{
+    if (!update(notes, log))
+        return;
+
+    auto score = [&](const Bot::Card& c) {
+        deck.scores[c] += int(std::lround((1 - envelope(c)) * ProbabilityPredictor::SCORE_SCALE));
+    };
+
+    for (auto c : deck.players)
+        score(c);
+    for (auto c : deck.weapons)
+        score(c);
+    for (auto c : deck.rooms)
+        score(c);
+}
+
+bool ParticlePredictor::update(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log)
+{
+    const int n = order.size();
+
+    NM::CardMask table = 0;
+    for (auto p : order)
+        table |= notes.cards(p, NM::TABLE);
+
+    // the table cards are only set at the start of the game, everything else only grows
+    if (!started || (table != tableCards) || (log.log().size() < logSize)) {
+        reset();
+        tableCards = table;
+        started = true;
+    }
+
+    NM::CardMask has[LOCATION_COUNT];
+    NM::CardMask lacks[LOCATION_COUNT];
+    for (int i = 0; i < n; i++) {
+        has[i] = notes.cards(order[i], NM::HAS) & ~table;
+        lacks[i] = notes.cards(order[i], NM::LACKS);
+    }
+    has[n] = notes.cards(player, NM::ENVELOPE);
+    lacks[n] = 0;
+
+    auto location = [&](Bot::Player p) {
+        return int(std::find(order.begin(), order.end(), p) - order.begin());
+    };
+
+    // the players between the suggesting player and the one that showed a card have none of the
+    // suggested cards, and the one that showed has at least one of them
+    size_t firstShow = shows.size();
+    for (size_t i = logSize; i < log.log().size(); i++) {
+        const auto& l = log.log()[i];
+        int start = location(l.from);
+        if (start >= n)
+            continue;
+
+        for (int pos = (start + 1) % n; pos != start; pos = (pos + 1) % n) {
+            if (l.showed && (order[pos] == l.show))
+                break;
+            lacks[pos] |= NM::mask(l.suggestion);
+        }
+
+        int show = location(l.show);
+        if (l.showed && (l.show != player) && (show < n)) {
+            shows.push_back({ show, NM::mask(l.suggestion) & ~table });
+            showsOf[show].push_back(shows.back().cards);
+        }
+    }
+    logSize = log.log().size();
+
+    // only the new facts have to be checked, the particles already agree with the old ones
+    NM::CardMask newHas[LOCATION_COUNT];
+    NM::CardMask newLacks[LOCATION_COUNT];
+    for (int i = 0; i <= n; i++) {
+        lacks[i] |= lacksCards[i];
+        newHas[i] = has[i] & ~hasCards[i];
+        newLacks[i] = lacks[i] & ~lacksCards[i];
+        hasCards[i] |= has[i];
+        lacksCards[i] = lacks[i];
+    }
+
+    next.clear();
+    for (const auto& p : particles)
+        if (agrees(p, newHas, newLacks, firstShow))
+            next.push_back(p);
+    particles.swap(next);
+
+    if (particles.empty()) {
+        Particle p;
+        for (int i = 0; i < options.particles; i++) {
+            if (deal(p))
+                particles.push_back(p);
+            else if (particles.empty())
+                break;
+            else {
+                Particle q = particles[rng() % particles.size()];
+                mix(q, options.moves);
+                particles.push_back(q);
+            }
+        }
+    }
+
+    if (particles.empty()) {
+        std::fill(&probs[0][0], &probs[0][0] + LOCATION_COUNT * CARD_COUNT, 0.0);
+        return false;
+    }
+
+    if ((options.policy == ParticleOptions::RESAMPLE) ||
+            (particles.size() < options.minAlive * options.particles))
+        refill();
+
+    count();
+    return true;
+}
+
+bool ParticlePredictor::agrees(const Particle& p, const NM::CardMask* has,
+        const NM::CardMask* lacks, size_t firstShow) const
+{
+    for (size_t i = 0; i <= order.size(); i++)
+        if ((p.hands[i] & lacks[i]) || ((p.hands[i] & has[i]) != has[i]))
+            return false;
+
+    for (size_t i = firstShow; i < shows.size(); i++)
+        if (!(p.hands[shows[i].location] & shows[i].cards))
+            return false;
+
+    return true;
+}
+
+bool ParticlePredictor::deal(Particle& p)
+{
+    const int n = order.size();
+
+    NM::CardMask fixed = tableCards;
+    NM::CardMask lackedByAll = NM::ALL_CARDS;
+    for (int i = 0; i <= n; i++) {
+        if ((__builtin_popcount(hasCards[i]) > sizes[i]) || (hasCards[i] & lacksCards[i]) ||
+                (hasCards[i] & fixed))
+            return false;
+        fixed |= hasCards[i];
+        if (i < n)
+            lackedByAll &= lacksCards[i];
+    }
+    const NM::CardMask movable = NM::ALL_CARDS & ~fixed;
+
+    std::vector<int> cards;
+    for (int attempt = 0; attempt < DEAL_ATTEMPTS; attempt++) {
+        std::copy(hasCards, hasCards + LOCATION_COUNT, p.hands);
+
+        // cards nobody can have must be in the envelope
+        bool dealt = true;
+        for (auto type : { Bot::Card::PLAYER, Bot::Card::WEAPON, Bot::Card::ROOM }) {
+            if (p.hands[n] & NM::typeMask(type))
+                continue;
+
+            NM::CardMask candidates = movable & NM::typeMask(type);
+            if (candidates & lackedByAll)
+                candidates &= lackedByAll;
+
+            int c = pick(candidates, rng);
+            if (c < 0)
+                dealt = false;
+            else
+                p.hands[n] |= NM::CardMask(1) << c;
+        }
+
+        cards.clear();
+        for (int c = 0; c < CARD_COUNT; c++)
+            if (movable & ~p.hands[n] & (NM::CardMask(1) << c))
+                cards.push_back(c);
+        std::shuffle(cards.begin(), cards.end(), rng);
+
+        // handing the shuffled cards out in order gives every deal the same chance, so at first
+        // deals where someone got a card they lack are simply thrown away. If that keeps on
+        // failing the cards are rather given to players that don't lack them, which favours
+        // some deals, and the swaps made to the copies have to even it out.
+        bool strict = attempt < DEAL_ATTEMPTS / 2;
+        int slot = 0;
+        int left = 0;
+        for (size_t k = 0; dealt && (k < cards.size()); k++) {
+            NM::CardMask m = NM::CardMask(1) << cards[k];
+
+            if (strict) {
+                while ((slot < n) && (left == sizes[slot] - __builtin_popcount(hasCards[slot]))) {
+                    slot++;
+                    left = 0;
+                }
+                if ((slot >= n) || (lacksCards[slot] & m))
+                    dealt = false;
+                else
+                    p.hands[slot] |= m;
+                left++;
+                continue;
+            }
+
+            int choices[LOCATION_COUNT];
+            int count = 0;
+            for (int i = 0; i < n; i++)
+                if ((__builtin_popcount(p.hands[i]) < sizes[i]) && !(lacksCards[i] & m))
+                    choices[count++] = i;
+
+            if (!count)
+                dealt = false;
+            else
+                p.hands[choices[rng() % count]] |= m;
+        }
+
+        if (dealt && repair(p))
+            return true;
+    }
+
+    return false;
+}
+
+bool ParticlePredictor::repair(Particle& p)
+{
+    NM::CardMask fixed = tableCards;
+    for (size_t i = 0; i <= order.size(); i++)
+        fixed |= hasCards[i];
+    const NM::CardMask movable = NM::ALL_CARDS & ~fixed;
+
+    std::vector<size_t> broken;
+    for (size_t step = 0; step < REPAIR_STEPS * (shows.size() + 1); step++) {
+        broken.clear();
+        for (size_t i = 0; i < shows.size(); i++)
+            if (!(p.hands[shows[i].location] & shows[i].cards))
+                broken.push_back(i);
+
+        if (broken.empty())
+            return true;
+
+        // give the player one of the shown cards in exchange for one of their own
+        const Show& s = shows[broken[rng() % broken.size()]];
+        int c = pick(s.cards & movable & ~lacksCards[s.location], rng);
+        if (c < 0)
+            return false;
+        int lc = locationOf(p, c);
+
+        int d = pick(p.hands[s.location] & movable, rng);
+        if ((d < 0) || !canSwap(c, lc, d, s.location))
+            continue;
+
+        int before = violations(p, lc) + violations(p, s.location);
+        NM::CardMask swap = (NM::CardMask(1) << c) | (NM::CardMask(1) << d);
+        p.hands[lc] ^= swap;
+        p.hands[s.location] ^= swap;
+
+        // sometimes keep a worse swap so that the search doesn't get stuck
+        if ((violations(p, lc) + violations(p, s.location) > before) && (rng() % 10)) {
+            p.hands[lc] ^= swap;
+            p.hands[s.location] ^= swap;
+        }
+    }
+
+    return false;
+}
+
+void ParticlePredictor::mix(Particle& p, int moves)
+{
+    NM::CardMask fixed = tableCards;
+    for (size_t i = 0; i <= order.size(); i++)
+        fixed |= hasCards[i];
+    const NM::CardMask movable = NM::ALL_CARDS & ~fixed;
+
+    for (int m = 0; m < moves; m++) {
+        int a = pick(movable, rng);
+        int b = pick(movable, rng);
+        if (a < 0)
+            return;
+
+        int la = locationOf(p, a);
+        int lb = locationOf(p, b);
+        if (!canSwap(a, la, b, lb))
+            continue;
+
+        NM::CardMask swap = (NM::CardMask(1) << a) | (NM::CardMask(1) << b);
+        p.hands[la] ^= swap;
+        p.hands[lb] ^= swap;
+
+        if (violations(p, la) || violations(p, lb)) {
+            p.hands[la] ^= swap;
+            p.hands[lb] ^= swap;
+        }
+    }
+}
+
+int ParticlePredictor::locationOf(const Particle& p, int card) const
+{
+    for (size_t i = 0; i <= order.size(); i++)
+        if (p.hands[i] & (NM::CardMask(1) << card))
+            return i;
+    return -1;
+}
+
+bool ParticlePredictor::canSwap(int a, int la, int b, int lb) const
+{
+    const int n = order.size();
+
+    if ((la == lb) || (la < 0) || (lb < 0))
+        return false;
+    if ((la == n || lb == n) && (typeOf(a) != typeOf(b)))
+        return false;
+    if ((lacksCards[lb] & (NM::CardMask(1) << a)) || (lacksCards[la] & (NM::CardMask(1) << b)))
+        return false;
+
+    return true;
+}
+
+int ParticlePredictor::violations(const Particle& p, int location) const
+{
+    int count = 0;
+    for (auto cards : showsOf[location])
+        if (!(p.hands[location] & cards))
+            count++;
+    return count;
+}
+
+void ParticlePredictor::refill()
+{
+    const size_t alive = particles.size();
+    while (particles.size() < size_t(options.particles)) {
+        Particle p = particles[rng() % alive];
+        mix(p, options.moves);
+        particles.push_back(p);
+    }
+}
+
+void ParticlePredictor::count()
+{
+    std::fill(&probs[0][0], &probs[0][0] + LOCATION_COUNT * CARD_COUNT, 0.0);
+
+    for (const auto& p : particles) {
+        for (size_t i = 0; i <= order.size(); i++) {
+            for (NM::CardMask m = p.hands[i]; m; m &= m - 1)
+                probs[i][__builtin_ctz(m)]++;
+        }
+    }
+
+    for (auto& row : probs)
+        for (auto& prob : row)
+            prob /= particles.size();
+}
+
+double ParticlePredictor::envelope(const Bot::Card& card) const
+{
+    return probs[order.size()][NM::index(card)];
+}
+
+double ParticlePredictor::has(Bot::Player player, const Bot::Card& card) const
+{
+    size_t i = std::find(order.begin(), order.end(), player) - order.begin();
+    if (i >= order.size())
+        return 0;
+    return probs[i][NM::index(card)];
+}
+
+int ParticlePredictor::alive() const
+{
+    return particles.size();
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,417 @@
+/**
+ * \file probability.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../../include/predictors/probability.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+
+    // the key of a state holds the amount of cards every player still needs (4 bits each), the
+    // card types the envelope still needs and the flags of the open shows
+    const int QUOTA_BITS = 4;
+    const int ENVELOPE_SHIFT = QUOTA_BITS * NM::PLAYER_COUNT;
+    const int SLOT_SHIFT = ENVELOPE_SHIFT + 3;
+
+    int typeOf(int card)
+    {
+        return int(NM::card(card).type);
+    }
+}
+
+const int ProbabilityPredictor::SCORE_SCALE;
+const int ProbabilityPredictor::MAX_OPEN_SHOWS;
+const size_t ProbabilityPredictor::MAX_EDGES;
+
+ProbabilityPredictor::ProbabilityPredictor(Bot::Player player, std::vector<Bot::Player> order,
+        size_t maxEdges) :
+    order(order),
+    maxEdges(maxEdges),
+    exceeded(false),
+    valid(false),
+    consistent(false),
+    total(0)
+{
+    this->player = player;
+
+    std::fill(envelopeProb, envelopeProb + CARD_COUNT, 0.0);
+    std::fill(&hasProb[0][0], &hasProb[0][0] + PLAYER_COUNT * CARD_COUNT, 0.0);
+}
+
+void ProbabilityPredictor::run(Deck& deck, const Bot::NotesMatrix& notes,
+        const Bot::SuggestionLog& log)
+{
+    METRIC_TIMER(Metrics::PROBABILITY_PREDICTOR);
+
+    if (!update(notes, log))
+        return;
+
+    auto score = [&](const Bot::Card& c) {
+        deck.scores[c] += int(std::lround((1 - envelope(c)) * SCORE_SCALE));
+    };
+
+    for (auto c : deck.players)
+        score(c);
+    for (auto c : deck.weapons)
+        score(c);
+    for (auto c : deck.rooms)
+        score(c);
+}
+
+bool ProbabilityPredictor::update(const Bot::NotesMatrix& notes, const Bot::SuggestionLog& log)
+{
+    const int n = order.size();
+
+    NM::CardMask has[PLAYER_COUNT];
+    NM::CardMask lacks[PLAYER_COUNT];
+    NM::CardMask table = 0;
+    for (int i = 0; i < n; i++) {
+        has[i] = notes.cards(order[i], NM::HAS);
+        lacks[i] = notes.cards(order[i], NM::LACKS);
+        table |= notes.cards(order[i], NM::TABLE);
+    }
+    NM::CardMask env = notes.cards(player, NM::ENVELOPE);
+
+    if (valid && (logSize == log.log().size()) && (tableCards == table) &&
+            (envelopeCards == env) && std::equal(has, has + n, hasCards) &&
+            std::equal(lacks, lacks + n, lacksCards))
+        return consistent;
+
+    std::copy(has, has + n, hasCards);
+    std::copy(lacks, lacks + n, lacksCards);
+    tableCards = table;
+    envelopeCards = env;
+    logSize = log.log().size();
+    valid = true;
+    consistent = false;
+    exceeded = false;
+    total = 0;
+
+    std::fill(envelopeProb, envelopeProb + CARD_COUNT, 0.0);
+    std::fill(&hasProb[0][0], &hasProb[0][0] + PLAYER_COUNT * CARD_COUNT, 0.0);
+
+    auto location = [&](Bot::Player p) {
+        return int(std::find(order.begin(), order.end(), p) - order.begin());
+    };
+
+    // the players between the suggesting player and the one that showed a card have none of the
+    // suggested cards
+    for (const auto& l : log.log()) {
+        int start = location(l.from);
+        if (start >= n)
+            continue;
+
+        for (int pos = (start + 1) % n; pos != start; pos = (pos + 1) % n) {
+            if (l.showed && (order[pos] == l.show))
+                break;
+            lacks[pos] |= NM::mask(l.suggestion);
+        }
+    }
+
+    const int totalCards = 18; // 21 total - 3 in envelope
+    const int cardsPerPlayer = (totalCards - (totalCards % n)) / n;
+
+    NM::CardMask dealt = 0;
+    quotas.assign(n, 0);
+    for (int i = 0; i < n; i++) {
+        NM::CardMask hand = has[i] & ~table;
+        if ((hand & dealt) || (hand & lacks[i]))
+            return false;
+        dealt |= hand;
+
+        quotas[i] = cardsPerPlayer - __builtin_popcount(hand);
+        if (quotas[i] < 0)
+            return false;
+    }
+
+    if (env & (dealt | table))
+        return false;
+
+    envelopeNeeded = 0;
+    for (int type = 0; type < 3; type++) {
+        int known = __builtin_popcount(env & NM::typeMask(Bot::Card::Type(type)));
+        if (known > 1)
+            return false;
+        if (!known)
+            envelopeNeeded |= uint64_t(1) << (ENVELOPE_SHIFT + type);
+    }
+
+    NM::CardMask unknown = NM::ALL_CARDS & ~(dealt | table | env);
+    int needed = __builtin_popcount(uint32_t(envelopeNeeded >> ENVELOPE_SHIFT));
+    for (int q : quotas)
+        needed += q;
+    if (needed != __builtin_popcount(unknown))
+        return false;
+
+    // every player that showed a card has one of the suggested cards
+    shows.clear();
+    for (const auto& l : log.log()) {
+        if (!l.showed || (l.show == player))
+            continue;
+
+        int loc = location(l.show);
+        if ((loc >= n) || (has[loc] & NM::mask(l.suggestion)))
+            continue;
+
+        NM::CardMask cs = NM::mask(l.suggestion) & unknown & ~lacks[loc];
+        if (!cs)
+            return false;
+
+        // a show whose cards include all the cards of another show tells us nothing more
+        if (std::any_of(shows.begin(), shows.end(), [&](const Show& s)
+                    { return (s.location == loc) && ((s.cards & cs) == s.cards); }))
+            continue;
+
+        shows.erase(std::remove_if(shows.begin(), shows.end(), [&](const Show& s)
+                    { return (s.location == loc) && ((s.cards & cs) == cs); }), shows.end());
+        shows.push_back({ loc, cs, -1, -1, -1 });
+    }
+
+    // hand out the cards that close the most shows and open the fewest first
+    cards.clear();
+    NM::CardMask handed = 0;
+    while (handed != unknown) {
+        int best = -1;
+        int bestScore = 0;
+        for (int c = 0; c < CARD_COUNT; c++) {
+            NM::CardMask m = NM::CardMask(1) << c;
+            if (!(unknown & m) || (handed & m))
+                continue;
+
+            int score = 0;
+            for (const auto& s : shows) {
+                if (!(s.cards & m))
+                    continue;
+                if (!(s.cards & handed))
+                    score++;
+                if ((s.cards & ~handed) == m)
+                    score--;
+            }
+
+            if ((best < 0) || (score < bestScore)) {
+                best = c;
+                bestScore = score;
+            }
+        }
+
+        cards.push_back(best);
+        handed |= NM::CardMask(1) << best;
+    }
+
+    const int steps = cards.size();
+
+    allowed.assign(steps, 0);
+    for (int t = 0; t < steps; t++) {
+        NM::CardMask m = NM::CardMask(1) << cards[t];
+        for (int i = 0; i < n; i++)
+            if (!(lacks[i] & m))
+                allowed[t] |= 1 << i;
+        if (envelopeNeeded & (uint64_t(1) << (ENVELOPE_SHIFT + typeOf(cards[t]))))
+            allowed[t] |= 1 << n;
+    }
+
+    for (auto& s : shows) {
+        for (int t = 0; t < steps; t++) {
+            if (!(s.cards & (NM::CardMask(1) << cards[t])))
+                continue;
+            if (s.first < 0)
+                s.first = t;
+            s.last = t;
+        }
+    }
+
+    // give every show a flag for as long as it is open, flags are reused once a show closes
+    openBits.assign(steps, std::vector<uint64_t>(n, 0));
+    closeBits.assign(steps, 0);
+    std::vector<int> free;
+    int slots = 0;
+    for (int t = 0; t < steps; t++) {
+        for (auto& s : shows) {
+            if (s.first != t)
+                continue;
+            if (free.empty()) {
+                if (slots >= MAX_OPEN_SHOWS)
+                    return false;
+                free.push_back(slots++);
+            }
+            s.slot = free.back();
+            free.pop_back();
+        }
+
+        for (const auto& s : shows) {
+            if ((s.first > t) || (s.last < t))
+                continue;
+            uint64_t bit = uint64_t(1) << (SLOT_SHIFT + s.slot);
+            if (s.cards & (NM::CardMask(1) << cards[t]))
+                openBits[t][s.location] |= bit;
+            if (s.last == t) {
+                closeBits[t] |= bit;
+                free.push_back(s.slot);
+            }
+        }
+    }
+
+    // the amount of cards from every step onwards that can still go to every player, and to the
+    // envelope for every card type
+    remaining.assign(steps + 1, std::vector<int>(n + 3, 0));
+    for (int t = steps - 1; t >= 0; t--) {
+        remaining[t] = remaining[t + 1];
+        for (int i = 0; i < n; i++)
+            if (allowed[t] & (1 << i))
+                remaining[t][i]++;
+        if (allowed[t] & (1 << n))
+            remaining[t][n + typeOf(cards[t])]++;
+    }
+
+    if (!count())
+        return false;
+
+    for (int i = 0; i < n; i++)
+        for (int c = 0; c < CARD_COUNT; c++)
+            if (has[i] & ~table & (NM::CardMask(1) << c))
+                hasProb[order[i]][c] = 1;
+    for (int c = 0; c < CARD_COUNT; c++)
+        if (env & (NM::CardMask(1) << c))
+            envelopeProb[c] = 1;
+
+    consistent = true;
+    return true;
+}
+
+bool ProbabilityPredictor::transition(uint64_t key, int step, int location, uint64_t& next) const
+{
+    const int n = order.size();
+
+    if (location < n) {
+        int shift = QUOTA_BITS * location;
+        if (!((key >> shift) & ((1 << QUOTA_BITS) - 1)))
+            return false;
+        next = (key - (uint64_t(1) << shift)) | openBits[step][location];
+    } else {
+        uint64_t bit = uint64_t(1) << (ENVELOPE_SHIFT + typeOf(cards[step]));
+        if (!(key & bit))
+            return false;
+        next = key & ~bit;
+    }
+
+    // every show that closes must have been given one of its cards
+    if ((next & closeBits[step]) != closeBits[step])
+        return false;
+    next &= ~closeBits[step];
+
+    return feasible(next, step + 1);
+}
+
+bool ProbabilityPredictor::feasible(uint64_t key, int step) const
+{
+    const int n = order.size();
+
+    for (int i = 0; i < n; i++)
+        if (int((key >> (QUOTA_BITS * i)) & ((1 << QUOTA_BITS) - 1)) > remaining[step][i])
+            return false;
+    for (int type = 0; type < 3; type++)
+        if ((key & (uint64_t(1) << (ENVELOPE_SHIFT + type))) && !remaining[step][n + type])
+            return false;
+
+    return true;
+}
+
+bool ProbabilityPredictor::count()
+{
+    const int n = order.size();
+    const int steps = cards.size();
+
+    uint64_t start = envelopeNeeded;
+    for (int i = 0; i < n; i++)
+        start |= uint64_t(quotas[i]) << (QUOTA_BITS * i);
+
+    layers.resize(steps + 1);
+    layers[0].assign(1, Entry{ start, 1 });
+    if (!feasible(start, 0))
+        return false;
+
+    size_t budget = maxEdges;
+    edges.resize(steps);
+    for (int t = 0; t < steps; t++) {
+        auto& step = edges[t];
+        step.clear();
+        for (size_t i = 0; i < layers[t].size(); i++) {
+            for (int loc = 0; loc <= n; loc++) {
+                uint64_t key;
+                if (!(allowed[t] & (1 << loc)) || !transition(layers[t][i].key, t, loc, key))
+                    continue;
+
+                if (!budget--) {
+                    METRIC_COUNT(Metrics::PROBABILITY_FALLBACKS, 1);
+                    exceeded = true;
+                    return false;
+                }
+                step.push_back(Edge{ key, uint32_t(i), 0, loc });
+            }
+        }
+
+        if (step.empty())
+            return false;
+
+        // deals that reach the same state are counted together
+        std::sort(step.begin(), step.end());
+        auto& layer = layers[t + 1];
+        layer.clear();
+        for (auto& e : step) {
+            if (layer.empty() || (layer.back().key != e.key))
+                layer.push_back(Entry{ e.key, 0 });
+            layer.back().count += layers[t][e.from].count;
+            e.to = layer.size() - 1;
+        }
+    }
+
+    // every player has received all their cards and the envelope is full
+    if ((layers[steps].size() != 1) || layers[steps][0].key)
+        return false;
+    total = layers[steps][0].count;
+
+    backward.assign(1, 1.0);
+    for (int t = steps - 1; t >= 0; t--) {
+        nextBackward.assign(layers[t].size(), 0.0);
+
+        for (const auto& e : edges[t]) {
+            nextBackward[e.from] += backward[e.to];
+            double deals = layers[t][e.from].count * backward[e.to];
+            if (e.location < n)
+                hasProb[order[e.location]][cards[t]] += deals / total;
+            else
+                envelopeProb[cards[t]] += deals / total;
+        }
+
+        backward.swap(nextBackward);
+    }
+
+    return true;
+}
+
+bool ProbabilityPredictor::overBudget() const
+{
+    return exceeded;
+}
+
+double ProbabilityPredictor::envelope(const Bot::Card& card) const
+{
+    return envelopeProb[NM::index(card)];
+}
+
+double ProbabilityPredictor::has(Bot::Player player, const Bot::Card& card) const
+{
+    return hasProb[player][NM::index(card)];
+}
+
+double ProbabilityPredictor::deals() const
+{
+    return total;
+}
+
+// vim: set expandtab textwidth=100:
@@ -12,27 +12,28 @@ SeenPredictor::SeenPredictor(Bot::Player player)
     this->player = player;
 }
 
-void SeenPredictor::run(Deck& deck, std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes,
-        Bot::SuggestionLog log)
+void SeenPredictor::run(Deck& deck, const Bot::NotesMatrix& notes,
+        const Bot::SuggestionLog& log)
 {
-    for (auto l : log.log()) {
+    METRIC_TIMER(Metrics::SEEN_PREDICTOR);
+
+    for (const auto& l : log.log()) {
         if (!l.showed)
             continue;
 
         Bot::Suggestion sug = l.suggestion;
+        Bot::NotesMatrix::CardMask sugMask = Bot::NotesMatrix::mask(sug);
+        Bot::NotesMatrix::CardMask seen = notes.cards(l.from, Bot::NotesMatrix::SEEN);
+
+        // if the player already saw the other two cards, they were probably shown the third
+        for (auto c : { Bot::Card(sug.room), Bot::Card(sug.weapon), Bot::Card(sug.player) }) {
+            Bot::NotesMatrix::CardMask others = sugMask & ~Bot::NotesMatrix::mask(c);
 
-        if (notes[l.from][sug.player].seen && notes[l.from][sug.weapon].seen &&
-                !notes[l.from][sug.room].seen && contains(deck, sug.room)) {
-            LOG_LOGIC("Identified " + Bot::roomToStr(sug.room) + " as a low probability card");
-            deck.scores[sug.room]++;
-        } else if (notes[l.from][sug.player].seen && notes[l.from][sug.room].seen &&
-                !notes[l.from][sug.weapon].seen && contains(deck, sug.weapon)) {
-            LOG_LOGIC("Identified " + Bot::weaponToStr(sug.weapon) + " as a low probability card");
-            deck.scores[sug.weapon]++;
-        } else if (notes[l.from][sug.weapon].seen && notes[l.from][sug.room].seen &&
-                !notes[l.from][sug.player].seen && contains(deck, sug.player)) {
-            LOG_LOGIC("Identified " + Bot::playerToStr(sug.player) + " as a low probability card");
-            deck.scores[sug.player]++;
+            if (((seen & sugMask) == others) && deck.contains(c)) {
+                predicted(DeductionLog::SEEN_PREDICTOR, DeductionLog::LOW_PROBABILITY, c);
+                deck.scores[c]++;
+                break;
+            }
         }
     }
 }
@@ -0,0 +1,348 @@
+/**
+ * \file protocol.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../include/protocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace AI;
+
+const size_t ProtocolDriver::BUFFER_SIZE;
+
+namespace {
+    /**
+     * \returns the part of rest up to the first sep, and removes it and the sep from rest
+     */
+    StringView next(StringView& rest, char sep)
+    {
+        size_t end = rest.find(sep);
+        StringView part = rest.substr(0, end);
+        rest = (end == StringView::npos) ? StringView() : rest.substr(end + 1);
+
+        return part;
+    }
+
+    /**
+     * \returns the part of rest up to the next space, which is required
+     * \throw std::invalid_argument if rest is empty
+     */
+    StringView word(StringView& rest, const char* what)
+    {
+        if (rest.empty())
+            throw std::invalid_argument(std::string("missing ") + what);
+
+        return next(rest, ' ');
+    }
+
+    StringView trim(StringView s)
+    {
+        while (!s.empty() && (s[0] == ' '))
+            s = s.substr(1);
+        while (!s.empty() && (s[s.size() - 1] == ' '))
+            s = s.substr(0, s.size() - 1);
+
+        return s;
+    }
+
+    bool toNumber(StringView s, uint64_t& number)
+    {
+        if (s.empty())
+            return false;
+
+        number = 0;
+        for (char c : s) {
+            if ((c < '0') || (c > '9'))
+                return false;
+            if (number > (std::numeric_limits<uint64_t>::max() - (c - '0')) / 10)
+                return false;
+            number = number * 10 + (c - '0');
+        }
+
+        return true;
+    }
+
+    /**
+     * \throw std::invalid_argument if s is empty or isn't a number that fits in an int
+     */
+    int toInt(StringView s, const char* what)
+    {
+        if (s.empty())
+            throw std::invalid_argument(std::string("missing ") + what);
+
+        uint64_t number;
+        if (!toNumber(s, number) || (number > uint64_t(std::numeric_limits<int>::max())))
+            throw std::invalid_argument(std::string("invalid ") + what + " \"" + s.str() + "\"");
+
+        return int(number);
+    }
+
+    void toCards(StringView list, std::vector<Bot::Card>& cards)
+    {
+        cards.clear();
+        while (!list.empty())
+            cards.push_back(Bot::Card(trim(next(list, ','))));
+    }
+
+    Bot::Suggestion toSuggestion(StringView list)
+    {
+        Bot::Player player = Bot::strToPlayer(trim(next(list, ',')));
+        Bot::Weapon weapon = Bot::strToWeapon(trim(next(list, ',')));
+        Bot::Room room = Bot::strToRoom(trim(list));
+
+        return Bot::Suggestion(player, weapon, room);
+    }
+}
+
+ProtocolDriver::ProtocolDriver(int in, int out) :
+    in(in),
+    out(out),
+    input(new char[BUFFER_SIZE])
+{
+    output.reserve(BUFFER_SIZE);
+}
+
+void ProtocolDriver::run()
+{
+    size_t have = 0;
+    bool skipping = false;
+
+    while (true) {
+        ssize_t got = read(in, input.get() + have, BUFFER_SIZE - have);
+        if (got < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("couldn't read: ") + std::strerror(errno));
+        }
+
+        if (got == 0) {
+            // the last line doesn't need a newline
+            if (have && !skipping)
+                handle(StringView(input.get(), have));
+            flush();
+            return;
+        }
+
+        have += got;
+
+        // handle every complete line, the rest is kept for the next read
+        size_t start = 0;
+        for (size_t i = have - got; i < have; i++) {
+            if (input[i] != '\n')
+                continue;
+
+            if (skipping) {
+                skipping = false;
+                error(nullptr, "line is too long");
+            } else {
+                handle(StringView(input.get() + start, i - start));
+            }
+            start = i + 1;
+        }
+
+        have -= start;
+        std::memmove(input.get(), input.get() + start, have);
+
+        // a line that doesn't fit in the buffer is thrown away up to its newline
+        if (have == BUFFER_SIZE) {
+            skipping = true;
+            have = 0;
+        }
+
+        flush();
+    }
+}
+
+void ProtocolDriver::handle(StringView line)
+{
+    if (!line.empty() && (line[line.size() - 1] == '\r'))
+        line = line.substr(0, line.size() - 1);
+    if (line.empty())
+        return;
+
+    uint64_t game;
+    if (!toNumber(next(line, ' '), game)) {
+        error(nullptr, "a line has to start with a game id");
+        return;
+    }
+
+    try {
+        command(game, line);
+    } catch (std::exception& e) {
+        error(&game, e.what());
+    }
+
+    if (output.size() >= BUFFER_SIZE)
+        flush();
+}
+
+void ProtocolDriver::command(uint64_t game, StringView line)
+{
+    StringView name = word(line, "command");
+
+    if (name == "new") {
+        Bot::Player player = Bot::strToPlayer(word(line, "player"));
+
+        players.clear();
+        StringView order = word(line, "order");
+        while (!order.empty())
+            players.push_back(Bot::strToPlayer(trim(next(order, ','))));
+
+        if (bots.count(game))
+            throw std::invalid_argument("the game has already started");
+
+        if (players.size() < 3)
+            throw std::invalid_argument("the order needs at least 3 players");
+        for (size_t i = 0; i < players.size(); i++)
+            if (std::find(players.begin(), players.begin() + i, players[i]) != players.begin() + i)
+                throw std::invalid_argument(Bot::playerToStr(players[i]) +
+                        " is in the order more than once");
+        if (std::find(players.begin(), players.end(), player) == players.end())
+            throw std::invalid_argument("the order doesn't include " + Bot::playerToStr(player));
+
+        std::unique_ptr<Bot> b;
+        uint64_t seed;
+        if (line.empty())
+            b.reset(new Bot(player, players));
+        else if (toNumber(line, seed))
+            b.reset(new Bot(player, players, seed));
+        else
+            throw std::invalid_argument("invalid seed \"" + line.str() + "\"");
+
+        bots[game] = std::move(b);
+    } else if (name == "end") {
+        bot(game);
+        bots.erase(game);
+    } else if ((name == "cards") || (name == "table")) {
+        toCards(line, cards);
+        bot(game).setCards(cards, name == "table");
+    } else if (name == "board") {
+        board.clear();
+        while (!line.empty()) {
+            StringView pos = next(line, ',');
+            Bot::Player player = Bot::strToPlayer(trim(next(pos, ':')));
+            board.push_back({ player, toInt(trim(pos), "position") });
+        }
+        bot(game).updateBoard(board);
+    } else if (name == "move") {
+        Bot::Player player = Bot::strToPlayer(word(line, "player"));
+        bot(game).movePlayer(player, toInt(line, "position"));
+    } else if ((name == "suggest") || (name == "accuse")) {
+        Bot::Player player = Bot::strToPlayer(word(line, "player"));
+        bot(game).madeSuggestion(player, toSuggestion(line), name == "accuse");
+    } else if (name == "shown") {
+        bot(game).otherShownCard(Bot::strToPlayer(line));
+    } else if (name == "noshown") {
+        bot(game).noOtherShownCard();
+    } else if (name == "showcard") {
+        Bot::Player player = Bot::strToPlayer(word(line, "player"));
+        bot(game).showCard(player, Bot::Card(line));
+    } else if (name == "noshowcard") {
+        bot(game).noShowCard();
+    } else if (name == "turn") {
+        bot(game).newTurn();
+    } else if (name == "getmove") {
+        int move = bot(game).getMove(toInt(line, "roll"));
+
+        reply(game, "move");
+        append(uint64_t(move));
+        output += '\n';
+    } else if (name == "getsuggestion") {
+        Bot::Suggestion sug = bot(game).getSuggestion();
+
+        reply(game, "suggestion");
+        append(Bot::playerName(sug.player));
+        output += ',';
+        append(Bot::weaponName(sug.weapon));
+        output += ',';
+        append(Bot::roomName(sug.room));
+        output += '\n';
+    } else if (name == "getcard") {
+        Bot::Player player = Bot::strToPlayer(word(line, "player"));
+        toCards(line, cards);
+        Bot::Card card = bot(game).getCard(player, cards);
+
+        reply(game, "card");
+        append(card.name());
+        output += '\n';
+    } else {
+        throw std::invalid_argument("unknown command \"" + name.str() + "\"");
+    }
+}
+
+Bot& ProtocolDriver::bot(uint64_t game)
+{
+    auto b = bots.find(game);
+    if (b == bots.end())
+        throw std::invalid_argument("the game hasn't started");
+
+    return *b->second;
+}
+
+void ProtocolDriver::reply(uint64_t game, StringView kind)
+{
+    append(game);
+    output += ' ';
+    append(kind);
+    output += ' ';
+}
+
+void ProtocolDriver::error(const uint64_t* game, StringView message)
+{
+    if (game) {
+        reply(*game, "error");
+    } else {
+        append("error ");
+    }
+
+    // the message may not end the line early
+    for (char c : message)
+        output += ((c == '\n') || (c == '\r')) ? ' ' : c;
+    output += '\n';
+}
+
+void ProtocolDriver::append(StringView s)
+{
+    output.append(s.data(), s.size());
+}
+
+void ProtocolDriver::append(uint64_t number)
+{
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = char('0' + number % 10);
+        number /= 10;
+    } while (number);
+
+    while (n)
+        output += digits[--n];
+}
+
+void ProtocolDriver::flush()
+{
+    size_t written = 0;
+    while (written < output.size()) {
+        ssize_t w = write(out, output.data() + written, output.size() - written);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("couldn't write: ") + std::strerror(errno));
+        }
+        written += w;
+    }
+
+    output.clear();
+}
+
+int ProtocolDriver::games() const
+{
+    return bots.size();
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,559 @@
+/**
+ * \file replay.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../include/replay.h"
+#include "../include/board.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace AI;
+
+namespace {
+    const uint8_t REPLAY_MAGIC[4] = { 'C', 'L', 'R', 'P' };
+    const uint8_t REPLAY_VERSION = 1;
+    const size_t HEADER_SIZE = sizeof(REPLAY_MAGIC) + 1;
+
+    const int PLAYER_COUNT = Bot::NotesMatrix::PLAYER_COUNT;
+    const int WEAPON_COUNT = int(Bot::MAX_WEAPON) + 1;
+    const int ROOM_COUNT = int(Bot::MAX_ROOM) + 1;
+
+    /**
+     * \brief Amount of records a thread takes at a time
+     */
+    const size_t REPLAY_CHUNK = 64;
+
+    int encode(const Bot::Suggestion& s)
+    {
+        return (int(s.player) * WEAPON_COUNT + s.weapon) * ROOM_COUNT + s.room;
+    }
+
+    Bot::NotesMatrix::CardMask mask(const std::vector<Bot::Card>& cards)
+    {
+        Bot::NotesMatrix::CardMask m = 0;
+        for (auto& c : cards)
+            m |= Bot::NotesMatrix::mask(c);
+        return m;
+    }
+
+    /**
+     * \brief Reads the values in a record
+     * \throw std::invalid_argument when reading past the end of the record or reading a value
+     * that is out of range
+     */
+    struct RecordReader {
+        RecordReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+        bool done() const
+        {
+            return pos >= size;
+        }
+
+        uint8_t byte()
+        {
+            if (pos >= size)
+                throw std::invalid_argument("replay record is truncated");
+            return data[pos++];
+        }
+
+        uint64_t word(int bytes)
+        {
+            uint64_t v = 0;
+            for (int b = 0; b < bytes; b++)
+                v |= uint64_t(byte()) << (8 * b);
+            return v;
+        }
+
+        Bot::Player player(int value)
+        {
+            if (value >= PLAYER_COUNT)
+                throw std::invalid_argument("replay record has an invalid player");
+            return Bot::Player(value);
+        }
+
+        Bot::Player player()
+        {
+            return player(byte());
+        }
+
+        int position()
+        {
+            int p = byte();
+            if (p >= Board::BOARD_SIZE)
+                throw std::invalid_argument("replay record has an invalid position");
+            return p;
+        }
+
+        Bot::Card card()
+        {
+            int c = byte();
+            if (c >= Bot::NotesMatrix::CARD_COUNT)
+                throw std::invalid_argument("replay record has an invalid card");
+            return Bot::NotesMatrix::card(c);
+        }
+
+        std::vector<Bot::Card> cards()
+        {
+            Bot::NotesMatrix::CardMask m = word(3);
+            if (m & ~Bot::NotesMatrix::ALL_CARDS)
+                throw std::invalid_argument("replay record has an invalid card");
+
+            std::vector<Bot::Card> cards;
+            for (; m; m &= m - 1)
+                cards.push_back(Bot::NotesMatrix::card(__builtin_ctz(m)));
+            return cards;
+        }
+
+        Bot::Suggestion suggestion()
+        {
+            int s = word(2);
+            if (s >= PLAYER_COUNT * WEAPON_COUNT * ROOM_COUNT)
+                throw std::invalid_argument("replay record has an invalid suggestion");
+            return Bot::Suggestion(Bot::Player(s / ROOM_COUNT / WEAPON_COUNT),
+                    Bot::Weapon(s / ROOM_COUNT % WEAPON_COUNT), Bot::Room(s % ROOM_COUNT));
+        }
+
+        const uint8_t* data;
+        size_t size;
+        size_t pos = 0;
+    };
+
+    /**
+     * \throw std::invalid_argument if the data doesn't start with the replay file header
+     */
+    void checkHeader(const uint8_t* data, size_t size)
+    {
+        if ((size < HEADER_SIZE) || !std::equal(REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC),
+                    data))
+            throw std::invalid_argument("not a replay file");
+        if (data[sizeof(REPLAY_MAGIC)] != REPLAY_VERSION)
+            throw std::invalid_argument("replay file was made by another version");
+    }
+}
+
+ReplayRecorder::ReplayRecorder(Bot::Player player, std::vector<Bot::Player> order, uint64_t seed,
+        Bot::Strategy strategy, int budget)
+{
+    data.push_back(player);
+    data.push_back(strategy);
+    for (int b = 0; b < 4; b++)
+        data.push_back(uint32_t(budget) >> (8 * b));
+    for (int b = 0; b < 8; b++)
+        data.push_back(seed >> (8 * b));
+    data.push_back(order.size());
+    for (auto p : order)
+        data.push_back(p);
+}
+
+void ReplayRecorder::event(ReplayEvent e, int player)
+{
+    data.push_back(e | (player << 4));
+}
+
+void ReplayRecorder::cards(Bot::NotesMatrix::CardMask mask)
+{
+    for (int b = 0; b < 3; b++)
+        data.push_back(mask >> (8 * b));
+}
+
+void ReplayRecorder::suggestion(Bot::Suggestion suggestion)
+{
+    int s = encode(suggestion);
+    data.push_back(s);
+    data.push_back(s >> 8);
+}
+
+void ReplayRecorder::setCards(const std::vector<Bot::Card>& cards, bool table)
+{
+    event(table ? REPLAY_SET_TABLE_CARDS : REPLAY_SET_CARDS);
+    this->cards(mask(cards));
+}
+
+void ReplayRecorder::updateBoard(const std::vector<std::pair<Bot::Player, Position>>& players)
+{
+    event(REPLAY_UPDATE_BOARD);
+    data.push_back(players.size());
+    for (auto& p : players) {
+        data.push_back(p.first);
+        data.push_back(int(p.second));
+    }
+}
+
+void ReplayRecorder::movePlayer(Bot::Player player, int position)
+{
+    event(REPLAY_MOVE_PLAYER, player);
+    data.push_back(position);
+}
+
+void ReplayRecorder::madeSuggestion(Bot::Player player, Bot::Suggestion suggestion, bool accuse)
+{
+    event(accuse ? REPLAY_MADE_ACCUSATION : REPLAY_MADE_SUGGESTION, player);
+    this->suggestion(suggestion);
+}
+
+void ReplayRecorder::otherShownCard(Bot::Player showed)
+{
+    event(REPLAY_OTHER_SHOWN_CARD, showed);
+}
+
+void ReplayRecorder::noOtherShownCard()
+{
+    event(REPLAY_NO_OTHER_SHOWN_CARD);
+}
+
+void ReplayRecorder::showCard(Bot::Player player, Bot::Card card)
+{
+    event(REPLAY_SHOW_CARD, player);
+    data.push_back(Bot::NotesMatrix::index(card));
+}
+
+void ReplayRecorder::noShowCard()
+{
+    event(REPLAY_NO_SHOW_CARD);
+}
+
+void ReplayRecorder::newTurn()
+{
+    event(REPLAY_NEW_TURN);
+}
+
+void ReplayRecorder::getMove(int allowedMoves, int position)
+{
+    event(REPLAY_GET_MOVE);
+    data.push_back(allowedMoves);
+    data.push_back(position);
+}
+
+void ReplayRecorder::getSuggestion(Bot::Suggestion suggestion)
+{
+    event(REPLAY_GET_SUGGESTION);
+    this->suggestion(suggestion);
+}
+
+void ReplayRecorder::getCard(Bot::Player player, const std::vector<Bot::Card>& cards,
+        Bot::Card card)
+{
+    event(REPLAY_GET_CARD, player);
+    this->cards(mask(cards));
+    data.push_back(Bot::NotesMatrix::index(card));
+}
+
+void ReplayRecorder::finish(std::vector<uint8_t>& out) const
+{
+    for (int b = 0; b < 4; b++)
+        out.push_back(uint32_t(data.size()) >> (8 * b));
+    out.insert(out.end(), data.begin(), data.end());
+}
+
+void AI::writeReplayHeader(std::vector<uint8_t>& out)
+{
+    out.insert(out.end(), REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+    out.push_back(REPLAY_VERSION);
+}
+
+void ReplayStats::merge(const ReplayStats& other)
+{
+    games += other.games;
+    events += other.events;
+    decisions += other.decisions;
+    divergences += other.divergences;
+    divergentGames += other.divergentGames;
+    errors += other.errors;
+    if (error.empty())
+        error = other.error;
+}
+
+void AI::replayRecord(const uint8_t* data, size_t size, ReplayStats& stats)
+{
+    RecordReader r(data, size);
+
+    Bot::Player player = r.player();
+    int strategy = r.byte();
+    if (strategy > Bot::INFORMATION)
+        throw std::invalid_argument("replay record has an invalid strategy");
+    int budget = r.word(4);
+    uint64_t seed = r.word(8);
+
+    int count = r.byte();
+    if ((count == 0) || (count > PLAYER_COUNT))
+        throw std::invalid_argument("replay record has an invalid order");
+    std::vector<Bot::Player> order;
+    for (int i = 0; i < count; i++)
+        order.push_back(r.player());
+
+    Bot bot(player, order, seed);
+    if (strategy == Bot::INFORMATION)
+        bot.setStrategy(Bot::INFORMATION, budget);
+
+    stats.games++;
+    bool diverged = false;
+
+    // counts a choice and notes the first one that differs from the recording
+    auto decision = [&](bool same, long event, const std::string& what) {
+        stats.decisions++;
+        if (same)
+            return;
+        stats.divergences++;
+        diverged = true;
+        if (stats.error.empty())
+            stats.error = "event " + std::to_string(event) + ": " + what;
+    };
+
+    for (long event = 0; !r.done(); event++) {
+        uint8_t e = r.byte();
+        int p = e >> 4;
+        stats.events++;
+
+        switch (e & 0x0f) {
+            case REPLAY_SET_CARDS:
+                bot.setCards(r.cards());
+                break;
+
+            case REPLAY_SET_TABLE_CARDS:
+                bot.setCards(r.cards(), true);
+                break;
+
+            case REPLAY_UPDATE_BOARD: {
+                std::vector<std::pair<Bot::Player, Position>> players;
+                for (int i = r.byte(); i > 0; i--) {
+                    Bot::Player o = r.player();
+                    players.push_back({ o, Position(r.position()) });
+                }
+                bot.updateBoard(players);
+                break;
+            }
+
+            case REPLAY_MOVE_PLAYER:
+                bot.movePlayer(r.player(p), r.position());
+                break;
+
+            case REPLAY_MADE_SUGGESTION:
+            case REPLAY_MADE_ACCUSATION:
+                bot.madeSuggestion(r.player(p), r.suggestion(),
+                        (e & 0x0f) == REPLAY_MADE_ACCUSATION);
+                break;
+
+            case REPLAY_OTHER_SHOWN_CARD:
+                bot.otherShownCard(r.player(p));
+                break;
+
+            case REPLAY_NO_OTHER_SHOWN_CARD:
+                bot.noOtherShownCard();
+                break;
+
+            case REPLAY_SHOW_CARD: {
+                Bot::Player o = r.player(p);
+                bot.showCard(o, r.card());
+                break;
+            }
+
+            case REPLAY_NO_SHOW_CARD:
+                bot.noShowCard();
+                break;
+
+            case REPLAY_NEW_TURN:
+                bot.newTurn();
+                break;
+
+            case REPLAY_GET_MOVE: {
+                int dice = r.byte();
+                int recorded = r.position();
+                int move = bot.getMove(dice);
+                decision(move == recorded, event, "moved to " + std::to_string(move) +
+                        " instead of " + std::to_string(recorded));
+                break;
+            }
+
+            case REPLAY_GET_SUGGESTION: {
+                Bot::Suggestion recorded = r.suggestion();
+                Bot::Suggestion sug = bot.getSuggestion();
+                decision(sug == recorded, event, "suggested " + std::string(sug) +
+                        " instead of " + std::string(recorded));
+                break;
+            }
+
+            case REPLAY_GET_CARD: {
+                Bot::Player o = r.player(p);
+                std::vector<Bot::Card> cards = r.cards();
+                Bot::Card recorded = r.card();
+                Bot::Card card = bot.getCard(o, cards);
+                decision(card == recorded, event, "showed " + card.str() + " instead of " +
+                        recorded.str());
+                break;
+            }
+
+            default:
+                throw std::invalid_argument("replay record has an invalid event");
+        }
+    }
+
+    if (diverged)
+        stats.divergentGames++;
+}
+
+ReplayStats AI::replayData(const uint8_t* data, size_t size, int threads)
+{
+    if (threads < 0)
+        throw std::invalid_argument("amount of threads can't be negative");
+    checkHeader(data, size);
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto start = std::chrono::steady_clock::now();
+
+    // the records can only be found by walking the lengths, which is quick compared to replaying
+    ReplayStats total;
+    std::vector<size_t> records;
+    size_t pos = HEADER_SIZE;
+    while (pos < size) {
+        uint32_t length = 0;
+        if (size - pos >= 4)
+            length = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) |
+                (uint32_t(data[pos + 3]) << 24);
+
+        if ((size - pos < 4) || (size - pos - 4 < length)) {
+            // the last record was cut off, e.g. because the recording was stopped
+            total.errors++;
+            total.error = "replay file is truncated";
+            break;
+        }
+
+        records.push_back(pos);
+        pos += 4 + length;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<ReplayStats> stats(threads);
+
+    auto worker = [&](int t) {
+        size_t first;
+        while ((first = next.fetch_add(REPLAY_CHUNK, std::memory_order_relaxed)) <
+                records.size()) {
+            size_t last = std::min(first + REPLAY_CHUNK, records.size());
+            for (size_t i = first; i < last; i++) {
+                ReplayStats& s = stats[t];
+                bool noted = !s.error.empty();
+                const uint8_t* record = data + records[i];
+                size_t length = record[0] | (record[1] << 8) | (record[2] << 16) |
+                    (uint32_t(record[3]) << 24);
+
+                try {
+                    replayRecord(record + 4, length, s);
+                } catch (std::exception& e) {
+                    s.errors++;
+                    if (s.error.empty())
+                        s.error = e.what();
+                }
+
+                if (!noted && !s.error.empty())
+                    s.error = "record " + std::to_string(i) + ", " + s.error;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.push_back(std::thread(worker, t));
+    for (auto& t : pool)
+        t.join();
+
+    auto end = std::chrono::steady_clock::now();
+
+    for (auto& s : stats)
+        total.merge(s);
+    total.seconds = std::chrono::duration<double>(end - start).count();
+
+    return total;
+}
+
+ReplayStats AI::replayFile(const std::string& path, int threads)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("can't open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        throw std::runtime_error("can't read " + path);
+    }
+
+    size_t size = st.st_size;
+    if (size < HEADER_SIZE) {
+        close(fd);
+        throw std::invalid_argument("not a replay file");
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        throw std::runtime_error("can't map " + path);
+
+    // the records are read from front to back
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    try {
+        ReplayStats stats = replayData(static_cast<const uint8_t*>(data), size, threads);
+        munmap(data, size);
+        return stats;
+    } catch (...) {
+        munmap(data, size);
+        throw;
+    }
+}
+
+void AI::appendReplayFile(const std::string& path, const std::vector<uint8_t>& records)
+{
+    std::vector<uint8_t> header;
+    {
+        std::ifstream in(path, std::ios::binary);
+        char existing[HEADER_SIZE];
+        if (in && in.read(existing, HEADER_SIZE))
+            checkHeader(reinterpret_cast<const uint8_t*>(existing), HEADER_SIZE);
+        else if (in && (in.gcount() > 0))
+            throw std::invalid_argument("not a replay file");
+        else
+            writeReplayHeader(header);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out.write(reinterpret_cast<const char*>(header.data()), header.size());
+    out.write(reinterpret_cast<const char*>(records.data()), records.size());
+    if (!out)
+        throw std::runtime_error("can't write " + path);
+}
+
+void AI::printReplayStats(std::ostream& out, const ReplayStats& stats)
+{
+    auto flags = out.flags();
+    auto precision = out.precision();
+
+    out << std::setprecision(3);
+
+    out << "games replayed: " << stats.games << " in " << stats.seconds << "s (" <<
+        long(stats.seconds > 0 ? stats.games / stats.seconds : 0) << " games/s)\n";
+    out << "events replayed: " << stats.events << " (" <<
+        long(stats.seconds > 0 ? stats.events / stats.seconds : 0) << " events/s)\n";
+    out << "choices compared: " << stats.decisions << ", divergences: " << stats.divergences <<
+        " in " << stats.divergentGames << " games\n";
+    if (stats.errors)
+        out << "games aborted: " << stats.errors << "\n";
+    if (!stats.error.empty())
+        out << "first problem: " << stats.error << "\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// vim: set expandtab textwidth=100:
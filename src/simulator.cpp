@@ -0,0 +1,974 @@
+/**
+ * \file simulator.cpp
+ * \author Kobus van Schoor
+ */
+
+#include "../include/simulator.h"
+#include "../include/bot.h"
+#include "../include/board.h"
+#include "../include/replay.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace AI;
+
+namespace {
+    template <typename T>
+    void erase(std::vector<T>& vec, T obj)
+    {
+        vec.erase(std::find(vec.begin(), vec.end(), obj));
+    }
+
+    template <typename T>
+    bool contains(std::vector<T> vec, T obj)
+    {
+        return std::find(vec.begin(), vec.end(), obj) != vec.end();
+    }
+
+    int getRoomPos(Bot::Room room)
+    {
+        switch (room) {
+            case Bot::BEDROOM: return 4;
+            case Bot::BATHROOM: return 5;
+            case Bot::STUDY: return 6;
+            case Bot::KITCHEN: return 7;
+            case Bot::DINING_ROOM: return 8;
+            case Bot::LIVING_ROOM: return 9;
+            case Bot::COURTYARD: return 1;
+            case Bot::GARAGE: return 2;
+            case Bot::GAMES_ROOM: return 3;
+        }
+
+        return 0;
+    }
+
+    Bot::Room getPosRoom(int pos)
+    {
+        switch (pos) {
+            case 1: return Bot::COURTYARD;
+            case 2: return Bot::GARAGE;
+            case 3: return Bot::GAMES_ROOM;
+            case 4: return Bot::BEDROOM;
+            case 5: return Bot::BATHROOM;
+            case 6: return Bot::STUDY;
+            case 7: return Bot::KITCHEN;
+            case 8: return Bot::DINING_ROOM;
+            case 9: return Bot::LIVING_ROOM;
+        }
+
+        return Bot::COURTYARD;
+    }
+
+    /**
+     * \brief A reference bot
+     *
+     * This bot doesn't implement any fancy deductions or predictions, nor does it look at the history
+     * of the game. This bot is a more realistic representation of how a human player will play. It
+     * still follows a set strategy, it just doesn't extract as much information from the game as the
+     * actual AI.
+     */
+    class DumbBot
+    {
+        public:
+            DumbBot(Bot::Player player, Random& rng) :
+                rng(rng),
+                player(player),
+                pos(0)
+            {
+                for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+                    notes[Bot::Player(i)] = false;
+                for (int i = 0; i <= int(Bot::MAX_WEAPON); i++)
+                    notes[Bot::Weapon(i)] = false;
+                for (int i = 0; i <= int(Bot::MAX_ROOM); i++)
+                    notes[Bot::Room(i)] = false;
+            }
+
+            Bot::Suggestion getSuggestion()
+            {
+                Bot::Suggestion sug(Bot::Player(0), Bot::Weapon(0), Bot::Room(0));
+                if (pos == 0) {
+                    sug.player = envelopePlayer;
+                    sug.weapon = envelopeWeapon;
+                    sug.room = envelopeRoom;
+                } else {
+                    auto safePlayers = getSafePlayers();
+                    auto safeWeapons = getSafeWeapons();
+                    auto wantedPlayers = getWantedPlayers();
+                    auto wantedWeapons = getWantedWeapons();
+
+                    sug.room = getPosRoom(pos);
+
+                    if (!haveRoom) {
+                        if (safePlayers.empty())
+                            sug.player = wantedPlayers[rng() % wantedPlayers.size()];
+                        else
+                            sug.player = safePlayers[rng() % safePlayers.size()];
+
+                        if (safeWeapons.empty())
+                            sug.weapon = wantedWeapons[rng() %  wantedWeapons.size()];
+                        else
+                            sug.weapon = safeWeapons[rng() % safeWeapons.size()];
+                    } else if (!havePlayer) {
+                        sug.player = wantedPlayers[rng() % wantedPlayers.size()];
+
+                        if (safeWeapons.empty())
+                            sug.weapon = wantedWeapons[rng() %  wantedWeapons.size()];
+                        else
+                            sug.weapon = safeWeapons[rng() % safeWeapons.size()];
+                    } else {
+                        sug.player = safePlayers[rng() % safePlayers.size()];
+                        sug.weapon = wantedWeapons[rng() %  wantedWeapons.size()];
+                    }
+                }
+
+                curSug = sug;
+                return sug;
+            }
+
+            int getMove(int moves)
+            {
+                auto findRoom = [&](std::vector<Bot::Room> wanted) {
+                    for (auto w : wanted)
+                        if (Position(this->pos).path(getRoomPos(w)) <= moves)
+                            return getRoomPos(w);
+
+                    Bot::Room minRoom = wanted[0];
+                    int dist = Position(this->pos).path(getRoomPos(wanted[0]));
+
+                    for (auto w : wanted) {
+                        int d = Position(this->pos).path(getRoomPos(w));
+                        if (d < dist) {
+                            dist = d;
+                            minRoom = w;
+                        }
+                    }
+
+                    return Position(pos).path(getRoomPos(minRoom)).partial(moves);
+                };
+
+                if (!haveRoom) {
+                    return findRoom(getWantedRooms());
+                } else if (!havePlayer || !haveWeapon) {
+                    return findRoom(getSafeRooms());
+                } else {
+                    return Position(pos).path(0).partial(moves);
+                }
+            }
+
+            void setCards(std::vector<Bot::Card> cards)
+            {
+                for (auto c : cards) {
+                    notes[c] = true;
+                    set.push_back(c);
+                }
+                findEnvelope();
+            }
+
+            void showCard(Bot::Card card)
+            {
+                notes[card] = true;
+                findEnvelope();
+            }
+
+            void move(int p)
+            {
+                this->pos = p;
+            }
+
+            void noShowCard()
+            {
+                if (!haveRoom && !contains(set, Bot::Card(curSug.room))) {
+                    haveRoom = true;
+                    envelopeRoom = curSug.room;
+                }
+
+                if (!haveWeapon && !contains(set, Bot::Card(curSug.weapon))) {
+                    haveWeapon = true;
+                    envelopeWeapon = curSug.weapon;
+                }
+
+                if (!havePlayer && !contains(set, Bot::Card(curSug.player))) {
+                    havePlayer = true;
+                    envelopePlayer = curSug.player;
+                }
+            }
+
+            Bot::Card getCard(std::vector<Bot::Card> cards)
+            {
+                return cards[rng() % cards.size()];
+            }
+
+        private:
+            template <typename T>
+            std::pair<bool, T> finder(T max)
+            {
+                bool found = false;
+                T envc;
+                for (int i = 0; i <= int(max); i++) {
+                    T c = T(i);
+                    if (!notes[c]) {
+                        if (!found) {
+                            found = true;
+                            envc = c;
+                        } else {
+                            found = false;
+                            break;
+                        }
+                    }
+                }
+
+                return std::make_pair(found, envc);
+            }
+
+            void findEnvelope()
+            {
+                if (!haveRoom) {
+                    auto p = finder(Bot::MAX_ROOM);
+                    haveRoom = p.first;
+                    envelopeRoom = p.second;
+                }
+
+                if (!haveWeapon) {
+                    auto p = finder(Bot::MAX_WEAPON);
+                    haveWeapon = p.first;
+                    envelopeWeapon = p.second;
+                }
+
+                if (!havePlayer) {
+                    auto p = finder(Bot::MAX_PLAYER);
+                    havePlayer = p.first;
+                    envelopePlayer = p.second;
+                }
+            }
+
+            std::vector<Bot::Room> getWantedRooms()
+            {
+                std::vector<Bot::Room> wanted;
+                for (int i = 0; i <= int(Bot::MAX_ROOM); i++)
+                    if (!notes[Bot::Room(i)])
+                        wanted.push_back(Bot::Room(i));
+
+                return wanted;
+            }
+
+            std::vector<Bot::Player> getWantedPlayers()
+            {
+                std::vector<Bot::Player> wanted;
+                for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+                    if (!notes[Bot::Player(i)])
+                        wanted.push_back(Bot::Player(i));
+
+                return wanted;
+            }
+
+            std::vector<Bot::Weapon> getWantedWeapons()
+            {
+                std::vector<Bot::Weapon> wanted;
+                for (int i = 0; i <= int(Bot::MAX_WEAPON); i++)
+                    if (!notes[Bot::Weapon(i)])
+                        wanted.push_back(Bot::Weapon(i));
+
+                return wanted;
+            }
+
+            std::vector<Bot::Room> getSafeRooms()
+            {
+                std::vector<Bot::Room> safe;
+                for (auto c : set)
+                    if (c.type == Bot::Card::ROOM)
+                        safe.push_back(Bot::Room(c.card));
+
+                if (safe.empty() && haveRoom)
+                    safe.push_back(envelopeRoom);
+
+                return safe;
+            }
+
+            std::vector<Bot::Weapon> getSafeWeapons()
+            {
+                std::vector<Bot::Weapon> safe;
+                for (auto c : set)
+                    if (c.type == Bot::Card::WEAPON)
+                        safe.push_back(Bot::Weapon(c.card));
+
+                if (safe.empty() && haveWeapon)
+                    safe.push_back(envelopeWeapon);
+
+                return safe;
+            }
+
+            std::vector<Bot::Player> getSafePlayers()
+            {
+                std::vector<Bot::Player> safe;
+                for (auto c : set)
+                    if (c.type == Bot::Card::PLAYER)
+                        safe.push_back(Bot::Player(c.card));
+
+                if (safe.empty() && havePlayer)
+                    safe.push_back(envelopePlayer);
+
+                return safe;
+            }
+
+            Random& rng;
+            std::map<Bot::Card, bool> notes;
+            std::vector<Bot::Card> set;
+            Bot::Player player;
+            int pos;
+            Bot::Player envelopePlayer;
+            bool havePlayer = false;
+            Bot::Weapon envelopeWeapon;
+            bool haveWeapon = false;
+            Bot::Room envelopeRoom;
+            bool haveRoom = false;
+            Bot::Suggestion curSug = Bot::Suggestion(Bot::Player(0), Bot::Weapon(0), Bot::Room(0));
+    };
+
+    class Player {
+        public:
+            Player(Bot::Player p, std::vector<Bot::Player> order, bool dumb,
+                    const GameOptions& options, Random& rng) :
+                migrate(options.migrate),
+                thinkAhead(options.thinkAhead),
+                player(p)
+            {
+                this->dumb = dumb;
+                if (dumb) {
+                    dbot = new DumbBot(p, rng);
+                    return;
+                }
+
+                uint64_t seed = rng.seed();
+                bot = new Bot(p, order, seed);
+
+                // without a time budget the planner makes the same choices on every replay
+                if (options.planner)
+                    bot->setStrategy(Bot::INFORMATION, 0);
+
+                if (options.record)
+                    recorder = new ReplayRecorder(p, order, seed,
+                            options.planner ? Bot::INFORMATION : Bot::HEURISTIC, 0);
+            }
+
+            ~Player()
+            {
+                delete bot;
+                delete dbot;
+                delete recorder;
+            }
+
+            /**
+             * \brief Appends the recording of the AI's game to a replay file's data, if it was
+             * recorded
+             */
+            void finish(std::vector<uint8_t>& out)
+            {
+                if (recorder)
+                    recorder->finish(out);
+            }
+
+            /**
+             * \brief Adds the metrics of the AI, including the ones of the bots it replaced when
+             * migrating, to metrics
+             */
+            void addMetrics(Metrics& metrics)
+            {
+                if (dumb)
+                    return;
+                metrics.merge(migrated);
+                metrics.merge(bot->getMetrics());
+            }
+
+            void setCards(std::vector<Bot::Card> cards, bool table = false)
+            {
+                if (dumb)
+                    dbot->setCards(cards);
+                else
+                    bot->setCards(cards, table);
+                if (recorder)
+                    recorder->setCards(cards, table);
+                checkpoint();
+            }
+
+            void updateBoard(std::vector<std::pair<Bot::Player, Position>> players)
+            {
+                if (!dumb)
+                    bot->updateBoard(players);
+                if (recorder)
+                    recorder->updateBoard(players);
+                checkpoint();
+            }
+
+            int getMove(int dice)
+            {
+                if (dumb)
+                    return dbot->getMove(dice);
+
+                int move = bot->getMove(dice);
+                if (recorder)
+                    recorder->getMove(dice, move);
+                checkpoint();
+                return move;
+            }
+
+            void movePlayer(Bot::Player p, int pos)
+            {
+                if (dumb) {
+                    if (player == p)
+                        dbot->move(pos);
+                } else
+                    bot->movePlayer(p, pos);
+                if (recorder)
+                    recorder->movePlayer(p, pos);
+                checkpoint();
+            }
+
+            Bot::Suggestion getSuggestion()
+            {
+                if (dumb)
+                    return dbot->getSuggestion();
+
+                Bot::Suggestion sug = bot->getSuggestion();
+                if (recorder)
+                    recorder->getSuggestion(sug);
+                checkpoint();
+                return sug;
+            }
+
+            void madeSuggestion(Bot::Player player, Bot::Suggestion sug)
+            {
+                if (dumb) {
+                    if (sug.player == this->player)
+                        dbot->move(getRoomPos(sug.room));
+                } else
+                    bot->madeSuggestion(player, sug);
+                if (recorder)
+                    recorder->madeSuggestion(player, sug);
+                checkpoint();
+            }
+
+            void noShowCard()
+            {
+                if (dumb)
+                    dbot->noShowCard();
+                else
+                    bot->noShowCard();
+                if (recorder)
+                    recorder->noShowCard();
+                checkpoint();
+            }
+
+            void noOtherShownCard()
+            {
+                if (!dumb)
+                    bot->noOtherShownCard();
+                if (recorder)
+                    recorder->noOtherShownCard();
+                checkpoint();
+            }
+
+            Bot::Card getCard(Bot::Player p, std::vector<Bot::Card> cards)
+            {
+                if (dumb)
+                    return dbot->getCard(cards);
+
+                Bot::Card card = bot->getCard(p, cards);
+                if (recorder)
+                    recorder->getCard(p, cards, card);
+                checkpoint();
+                return card;
+            }
+
+            void showCard(Bot::Player player, Bot::Card card)
+            {
+                if (dumb)
+                    dbot->showCard(card);
+                else
+                    bot->showCard(player, card);
+                if (recorder)
+                    recorder->showCard(player, card);
+                checkpoint();
+            }
+
+            void otherShownCard(Bot::Player other)
+            {
+                if (!dumb)
+                    bot->otherShownCard(other);
+                if (recorder)
+                    recorder->otherShownCard(other);
+                checkpoint();
+            }
+
+            void newTurn()
+            {
+                if (!dumb)
+                    bot->newTurn();
+                if (recorder)
+                    recorder->newTurn();
+                checkpoint();
+            }
+
+
+        private:
+            /**
+             * \brief Lets the AI think ahead and replaces it with a new bot restored from a
+             * snapshot of it, if the game does so
+             */
+            void checkpoint()
+            {
+                if (dumb)
+                    return;
+
+                if (thinkAhead)
+                    while (bot->thinkAhead());
+                if (!migrate)
+                    return;
+
+                size_t size = bot->serialize(snapshot.data(), snapshot.size());
+                if (size > snapshot.size()) {
+                    snapshot.resize(size);
+                    bot->serialize(snapshot.data(), snapshot.size());
+                }
+
+                // the player, order and seed are all replaced by the snapshot
+                Bot* restored = new Bot(player, { player }, 0);
+                restored->deserialize(snapshot.data(), size);
+                migrated.merge(bot->getMetrics());
+                delete bot;
+                bot = restored;
+            }
+
+            bool dumb;
+            bool migrate;
+            bool thinkAhead;
+            std::vector<uint8_t> snapshot;
+            DumbBot* dbot = nullptr;
+            Bot* bot = nullptr;
+            ReplayRecorder* recorder = nullptr;
+            Bot::Player player;
+
+            /**
+             * \brief The metrics of the bots that have been replaced
+             */
+            Metrics migrated;
+    };
+    /**
+     * \throw std::invalid_argument if the game options are invalid
+     */
+    void checkOptions(const GameOptions& options)
+    {
+        if ((options.players != 0) && ((options.players < 3) ||
+                    (options.players > int(Bot::MAX_PLAYER) + 1)))
+            throw std::invalid_argument("a game needs between 3 and 6 players");
+
+        // with a random amount of players there are at least 4
+        if ((options.smart < 0) || (options.smart > (options.players ? options.players : 4)))
+            throw std::invalid_argument("more AI players than players in the game");
+    }
+}
+
+GameResult AI::playGame(const GameOptions& options, Random& rng)
+{
+    checkOptions(options);
+
+    // make a deck of all the cards
+    std::vector<Bot::Card> cards;
+
+    for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+        cards.push_back(Bot::Player(i));
+    for (int i = 0; i <= int(Bot::MAX_WEAPON); i++)
+        cards.push_back(Bot::Weapon(i));
+    for (int i = 0; i <= int(Bot::MAX_ROOM); i++)
+        cards.push_back(Bot::Room(i));
+
+    const int CARD_COUNT = 21;
+    const unsigned int PLAYER_COUNT = options.players ? options.players : 4 + (rng() % 3);
+    const unsigned int TABLE_CARDS = (CARD_COUNT - 3) % PLAYER_COUNT;
+
+    const unsigned int CARDS_PER_PLAYER = (CARD_COUNT - 3 - TABLE_CARDS) / PLAYER_COUNT;
+
+    // choose the order for the players
+    std::vector<Bot::Player> order;
+
+    for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+        order.push_back(Bot::Player(i));
+
+    while (order.size() > PLAYER_COUNT)
+        order.erase(order.begin() + (rng() % order.size()));
+
+    std::vector<Bot::Player> norder;
+    for (int i = order.size() - 1; i >= 0; i--) {
+        auto p = order[rng() % order.size()];
+        norder.push_back(p);
+        erase(order, p);
+    }
+
+    order = norder;
+
+    // choose the envelope cards
+    Bot::Player envelopePlayer = Bot::Player(rng() % (int(Bot::MAX_PLAYER) + 1));
+    Bot::Weapon envelopeWeapon = Bot::Weapon(rng() % (int(Bot::MAX_WEAPON) + 1));
+    Bot::Room envelopeRoom = Bot::Room(rng() % (int(Bot::MAX_ROOM) + 1));
+
+    erase(cards, Bot::Card(envelopePlayer));
+    erase(cards, Bot::Card(envelopeWeapon));
+    erase(cards, Bot::Card(envelopeRoom));
+
+    // select the deck of cards for each player
+    std::map<Bot::Player, std::vector<Bot::Card>> decks;
+
+    for (auto p : order) {
+        while (decks[p].size() < CARDS_PER_PLAYER) {
+            Bot::Card c = cards[rng() % cards.size()];
+            erase(cards, c);
+            decks[p].push_back(c);
+        }
+    }
+
+    std::map<Bot::Player, std::unique_ptr<Player>> players;
+
+    std::map<Bot::Player, int> board;
+
+    auto genBoard = [&]() {
+        std::vector<std::pair<Bot::Player, Position>> b;
+        for (auto p : order)
+            b.push_back({ p, Position(board[p]) });
+        return b;
+    };
+
+    // create the players
+
+    for (auto p : order)
+        board[p] = 0; // all players start in the middle room
+
+    // the players that are played by the AI
+    std::vector<Bot::Player> smart;
+    while (int(smart.size()) < options.smart) {
+        auto p = order[rng() % order.size()];
+        if (!contains(smart, p))
+            smart.push_back(p);
+    }
+
+    for (auto p : order) {
+        players[p].reset(new Player(p, order, !contains(smart, p), options, rng));
+        players[p]->setCards(decks[p]); // player's cards
+        players[p]->setCards(cards, true); // table cards
+        players[p]->updateBoard(genBoard());
+    }
+
+    // play the game
+    bool won = false;
+    unsigned int curIndex = 0;
+
+    std::map<Bot::Player, int> tc;
+
+    while (true) {
+        // select current player and dice roll
+        Bot::Player cur = order[curIndex];
+        int dice = 2 + (rng() % 11);
+        int pos = players[cur]->getMove(dice);
+        tc[cur]++;
+
+        // check that the player gave a valid move
+        Position start(board[cur]);
+        Position end(pos);
+
+        if (int(start.path(end, 1)) > dice)
+            throw std::logic_error("player moved from " + std::to_string(board[cur]) + " to " +
+                    std::to_string(pos) + " with a dice roll of " + std::to_string(dice));
+
+        // move player (updates all the bots)
+        for (auto o : order)
+            players[o]->movePlayer(cur, pos);
+        board[cur] = pos;
+
+        if (pos < Board::ROOM_COUNT) { // going in to a room
+            Bot::Suggestion sug = players[cur]->getSuggestion(); // get the suggestion
+            if (pos == 0) { // it's making an accusation
+                if ((sug.player != envelopePlayer) || (sug.weapon != envelopeWeapon) ||
+                        (sug.room != envelopeRoom))
+                    throw std::logic_error("player made a wrong accusation");
+
+                won = contains(smart, cur);
+                break;
+            }
+
+            if (sug.room != getPosRoom(pos))
+                throw std::logic_error("player made a suggestion for another room");
+
+            // move the player in the suggestion to the suggestion room
+            if (contains(order, sug.player))
+                board[sug.player] = pos;
+
+            // notify all the players that the currently active bot made a suggestion (note that the
+            // current bot is skipped)
+            for (auto o : order)
+                players[o]->madeSuggestion(cur, sug);
+
+            // determine what player can show a card(s)
+            std::vector<Bot::Card> show;
+            Bot::Player other;
+            for (unsigned int i = curIndex + 1; i != curIndex; i++) {
+                if (i >= PLAYER_COUNT) {
+                    i = 0;
+                    if (i == curIndex)
+                        break;
+                }
+
+                if (contains(decks[order[i]], Bot::Card(sug.player)))
+                    show.push_back(Bot::Card(sug.player));
+                if (contains(decks[order[i]], Bot::Card(sug.weapon)))
+                    show.push_back(Bot::Card(sug.weapon));
+                if (contains(decks[order[i]], Bot::Card(sug.room)))
+                    show.push_back(Bot::Card(sug.room));
+
+                if (!show.empty()) {
+                    other = order[i];
+                    break;
+                }
+            }
+
+            if (show.empty()) { // nobody could show a card
+                players[cur]->noShowCard(); // notify the currently active bot
+                for (auto o : order) // notify all the others (note the current bot is skipped)
+                    if (o != cur)
+                        players[o]->noOtherShownCard();
+            } else { // somebody could show a card
+                Bot::Card c(cur);
+                if (show.size() > 1) { // multiple cards to choose from, ask bot to show one
+                    c = players[other]->getCard(cur, show);
+                    if (!contains(show, c))
+                        throw std::logic_error("player showed a card it wasn't asked about");
+                } else
+                    c = show[0];
+
+                players[cur]->showCard(other, c); // show the card to the active bot
+
+                // notify all the other bots (note that the current bot is skipped)
+                for (auto o : order)
+                    if (o != cur)
+                        players[o]->otherShownCard(other);
+            }
+        }
+
+        curIndex = (curIndex + 1) % PLAYER_COUNT;
+
+        // notify all the bots that a new turn is starting
+        for (auto o : order)
+            players[o]->newTurn();
+    }
+
+    if (options.record)
+        for (auto p : order)
+            players[p]->finish(*options.record);
+    if (options.metrics)
+        for (auto p : order)
+            players[p]->addMetrics(*options.metrics);
+
+    return { won, tc[order[curIndex]] };
+}
+
+void TournamentStats::add(const GameResult& result)
+{
+    games++;
+    if (result.won) {
+        won++;
+        turns[result.turns]++;
+    }
+}
+
+void TournamentStats::merge(const TournamentStats& other)
+{
+    games += other.games;
+    won += other.won;
+    errors += other.errors;
+    if (error.empty())
+        error = other.error;
+    for (auto t : other.turns)
+        turns[t.first] += t.second;
+    metrics.merge(other.metrics);
+}
+
+namespace {
+    /**
+     * \brief The games a single thread still has to play
+     *
+     * Games are taken from the front of the range with an atomic increment, by the thread that owns
+     * the range or by threads that are stealing from it. Ranges are kept on separate cache lines so
+     * that the threads don't slow each other down while taking games.
+     */
+    struct alignas(64) GameRange {
+        std::atomic<int> next;
+        int end;
+    };
+
+    /**
+     * \brief Amount of recorded data a thread collects before appending it to the replay file
+     */
+    const size_t RECORD_FLUSH_SIZE = 1 << 20;
+
+    /**
+     * \brief Plays game index and adds it to the stats
+     * \param record Where to append the replay records of the game to, if the games are recorded
+     */
+    void playIndex(const TournamentOptions& options, int index, TournamentStats& stats,
+            std::vector<uint8_t>* record)
+    {
+        // every game gets its own random choices, so it doesn't matter which thread plays it
+        Random rng((uint64_t(options.seed) << 32) | uint32_t(index));
+
+        GameOptions game = options.game;
+        game.record = record;
+        game.metrics = &stats.metrics;
+
+        try {
+            stats.add(playGame(game, rng));
+        } catch (std::logic_error& e) {
+            stats.games++;
+            stats.errors++;
+            if (stats.error.empty())
+                stats.error = "game " + std::to_string(index) + ": " + e.what();
+        }
+    }
+}
+
+TournamentStats AI::runTournament(const TournamentOptions& options)
+{
+    if (options.games < 0)
+        throw std::invalid_argument("amount of games can't be negative");
+    if (options.threads < 0)
+        throw std::invalid_argument("amount of threads can't be negative");
+
+    // check the game options before starting any threads
+    checkOptions(options.game);
+
+    int threads = options.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // give every thread an equal share of the games
+    std::vector<GameRange> ranges(threads);
+    for (int t = 0; t < threads; t++) {
+        ranges[t].next = options.games * t / threads;
+        ranges[t].end = options.games * (t + 1) / threads;
+    }
+
+    std::vector<TournamentStats> stats(threads);
+
+    // every thread collects its records and appends them to the file a large block at a time
+    bool recording = !options.record.empty();
+    if (recording)
+        appendReplayFile(options.record, {});
+    std::mutex recordLock;
+
+    auto flush = [&](std::vector<uint8_t>& records) {
+        std::lock_guard<std::mutex> l(recordLock);
+        appendReplayFile(options.record, records);
+        records.clear();
+    };
+
+    auto worker = [&](int t) {
+        std::vector<uint8_t> records;
+
+        // play our own games first, then help the others
+        for (int i = 0; i < threads; i++) {
+            GameRange& range = ranges[(t + i) % threads];
+
+            int index;
+            while ((index = range.next.fetch_add(1, std::memory_order_relaxed)) < range.end) {
+                playIndex(options, index, stats[t], recording ? &records : nullptr);
+                if (records.size() >= RECORD_FLUSH_SIZE)
+                    flush(records);
+            }
+        }
+
+        if (!records.empty())
+            flush(records);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.push_back(std::thread(worker, t));
+    for (auto& t : pool)
+        t.join();
+
+    auto end = std::chrono::steady_clock::now();
+
+    TournamentStats total;
+    for (auto& s : stats)
+        total.merge(s);
+    total.seconds = std::chrono::duration<double>(end - start).count();
+
+    return total;
+}
+
+void AI::printStats(std::ostream& out, const TournamentStats& stats)
+{
+    auto flags = out.flags();
+    auto precision = out.precision();
+
+    out << std::setprecision(3);
+
+    out << "games played: " << stats.games << " in " << stats.seconds << "s (" <<
+        int(stats.seconds > 0 ? stats.games / stats.seconds : 0) << " games/s)\n";
+    if (stats.errors)
+        out << "games aborted: " << stats.errors << " (first error: " << stats.error << ")\n";
+
+    int runs = stats.won;
+    double won = stats.games ? double(runs) * 100 / stats.games : 0;
+
+    out << "games won: " << runs << " (" << won << "%) (x" << won / 20 <<
+        " better than reference)\n";
+
+    if (!stats.metrics.empty()) {
+        out << "metrics:\n";
+        stats.metrics.print(out);
+    }
+
+    if (stats.turns.empty()) {
+        out.flags(flags);
+        out.precision(precision);
+        return;
+    }
+
+    int total = 0;
+    int perc = 0;
+    int third = 0;
+    bool tset = false;
+    for (auto t : stats.turns) {
+        total += t.first * t.second;
+        perc += t.second;
+        if (((perc * 100 / runs) >= 75) && !tset) {
+            third = t.first;
+            tset = true;
+        }
+    }
+
+    out << "average turns needed to finish game: " << total / double(runs) << std::endl;
+    out << "minimum turns needed to finish game: " << stats.turns.begin()->first << std::endl;
+    out << "maximum turns needed to finish game: " << stats.turns.rbegin()->first << std::endl;
+    out << "third percentile: " << third << " moves needed" << std::endl;
+
+    total = 0;
+    out << "=========================\n";
+    for (auto t : stats.turns) {
+        total += t.second;
+        out << t.first << ": " << t.second << "\t(" << t.second * 100 / double(runs) <<
+            "%)\t(" << total * 100 / double(runs) << "%)\n";
+    }
+    out << "=========================\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+// vim: set expandtab textwidth=100:
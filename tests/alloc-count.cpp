@@ -0,0 +1,31 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Every allocation made by the test binary passes through here so that the benchmarks can report
+ * how many allocations a piece of code makes. It is kept in its own file, because GCC warns about
+ * mismatched new and delete when it sees these definitions next to the code that uses them.
+ */
+std::atomic<unsigned long> allocCount(0);
+
+void* operator new(std::size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+// vim: set expandtab textwidth=100:
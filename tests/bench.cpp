@@ -0,0 +1,848 @@
+#include <catch/catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../include/bot.h"
+#include "../include/board.h"
+#include "../include/deduction-log.h"
+#include "../include/host.h"
+#include "../include/metrics.h"
+#include "../include/protocol.h"
+#include "../include/tests.h"
+#include "../include/random.h"
+#include "../include/predictors/probability.h"
+#include "../include/predictors/particle.h"
+#include "../include/planners/information.h"
+#include "../include/planners/move.h"
+#include "../include/deductors/incremental.h"
+
+using namespace AI;
+
+/**
+ * \brief Amount of allocations the test binary made, see alloc-count.cpp
+ */
+extern std::atomic<unsigned long> allocCount;
+
+namespace {
+    class BotBench : public Bot {
+        public:
+            BotBench(Player p, std::vector<Player> o) :
+                Bot::Bot(p, o)
+            {}
+
+            using Bot::notesHook;
+            using Bot::notes;
+            using Bot::log;
+    };
+
+    /**
+     * \brief Feeds a bot random suggestions until its log holds count entries
+     */
+    void fillLog(Bot& bot, std::vector<Bot::Player> order, int count)
+    {
+        for (int i = 0; i < count; i++) {
+            Bot::Player from = order[rand() % order.size()];
+            Bot::Suggestion sug(randEnum(Bot::MAX_PLAYER), randEnum(Bot::MAX_WEAPON),
+                    randEnum(Bot::MAX_ROOM));
+
+            bot.madeSuggestion(from, sug);
+            Bot::Player show = order[rand() % order.size()];
+            if ((rand() % 4) && (show != from))
+                bot.otherShownCard(show);
+            else
+                bot.noOtherShownCard();
+            bot.newTurn();
+        }
+    }
+
+    /**
+     * \brief Deals the cards at random and gives the bot, the first player in order, its hand and
+     * the table cards
+     */
+    Deal dealCards(Bot& bot, std::vector<Bot::Player> order, Random& rng)
+    {
+        Deal deal(order, rng);
+
+        bot.setCards(deal.cards(0));
+        if (deal.mask(Deal::TABLE))
+            bot.setCards(deal.cards(Deal::TABLE), true);
+
+        return deal;
+    }
+
+    /**
+     * \brief Feeds a bot a random suggestion that is answered truthfully, so that the log agrees
+     * with the deal
+     */
+    void dealtSuggestion(Bot& bot, const Deal& deal, Random& rng)
+    {
+        int from = rng() % deal.order.size();
+        Bot::Suggestion sug = Deal::suggestion(rng);
+        bot.madeSuggestion(deal.order[from], sug);
+
+        int show = deal.answer(from, sug);
+        if (show < 0)
+            bot.noOtherShownCard();
+        else
+            bot.otherShownCard(deal.order[show]);
+        bot.newTurn();
+    }
+
+    /**
+     * \brief Deals the cards at random and feeds a bot count suggestions that are answered
+     * truthfully
+     */
+    void fillDealtLog(Bot& bot, std::vector<Bot::Player> order, int count, Random& rng)
+    {
+        Deal deal = dealCards(bot, order, rng);
+        for (int i = 0; i < count; i++)
+            dealtSuggestion(bot, deal, rng);
+    }
+
+    /**
+     * \brief The events of a game with count suggestions that are answered truthfully, as the
+     * first player in order is told about them
+     */
+    std::vector<Bot::Event> dealtEvents(std::vector<Bot::Player> order, int count, Random& rng)
+    {
+        const int n = order.size();
+        Deal deal(order, rng);
+
+        std::vector<Bot::Event> events;
+        events.push_back(Bot::Event::setCards(deal.cards(0)));
+        if (deal.mask(Deal::TABLE))
+            events.push_back(Bot::Event::setCards(deal.cards(Deal::TABLE), true));
+
+        for (int i = 0; i < count; i++) {
+            int from = 1 + rng() % (n - 1);
+            Bot::Suggestion sug = Deal::suggestion(rng);
+            events.push_back(Bot::Event::madeSuggestion(order[from], sug));
+
+            int show = deal.answer(from, sug);
+            if (show < 0)
+                events.push_back(Bot::Event::noOtherShownCard());
+            else
+                events.push_back(Bot::Event::otherShownCard(order[show]));
+            events.push_back(Bot::Event::newTurn());
+        }
+
+        return events;
+    }
+}
+
+TEST_CASE("notesHook allocations", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int calls = 1000;
+
+    for (int size : { 10, 50, 200 }) {
+        BotBench bot(Bot::SCARLET, order);
+        bot.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+        fillLog(bot, order, size);
+
+        unsigned long before = allocCount.load();
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < calls; i++)
+            bot.notesHook();
+
+        auto end = std::chrono::steady_clock::now();
+        unsigned long allocs = allocCount.load() - before;
+        double us = std::chrono::duration<double, std::micro>(end - start).count() / calls;
+
+        std::cout << "log size " << size << ": " << double(allocs) / calls <<
+            " allocations per notesHook call, " << us << "us per call" << std::endl;
+    }
+}
+
+TEST_CASE("event latency", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int events = 100;
+
+    for (int size : { 10, 50, 200, 1000 }) {
+        Bot bot(Bot::SCARLET, order);
+        bot.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+        fillLog(bot, order, size);
+
+        auto start = std::chrono::steady_clock::now();
+        fillLog(bot, order, events);
+        auto end = std::chrono::steady_clock::now();
+
+        double us = std::chrono::duration<double, std::micro>(end - start).count() / events;
+
+        std::cout << "log size " << size << ": " << us << "us per suggestion event" << std::endl;
+    }
+}
+
+TEST_CASE("getMove latency", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    Bot bot(Bot::SCARLET, order);
+    bot.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+
+    // ask for a move from every position on the board, with every dice roll
+    int calls = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int pos = 0; pos < Board::BOARD_SIZE; pos++) {
+        bot.updateBoard({ { Bot::SCARLET, pos }, { Bot::PLUM, 10 }, { Bot::PEACOCK, 11 },
+                { Bot::GREEN, 12 }, { Bot::MUSTARD, 13 }, { Bot::WHITE, 14 } });
+
+        for (int roll = 2; roll <= 12; roll++, calls++)
+            bot.getMove(roll);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - start).count() / calls;
+
+    std::cout << calls << " getMove calls: " << us << "us per call" << std::endl;
+}
+
+TEST_CASE("think ahead latency", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    // the same bot twice, one of them thinks ahead before it is asked for its moves
+    Bot live(Bot::SCARLET, order);
+    Bot ahead(Bot::SCARLET, order);
+    live.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+    ahead.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+
+    typedef std::chrono::steady_clock::duration Duration;
+    Duration liveTime(0), thinkTime(0), aheadTime(0);
+    int calls = 0;
+    int steps = 0;
+
+    for (int pos = 0; pos < Board::BOARD_SIZE; pos++) {
+        std::vector<std::pair<Bot::Player, Position>> board = { { Bot::SCARLET, pos },
+            { Bot::PLUM, 10 }, { Bot::PEACOCK, 11 }, { Bot::GREEN, 12 }, { Bot::MUSTARD, 13 },
+            { Bot::WHITE, 14 } };
+        live.updateBoard(board);
+        ahead.updateBoard(board);
+
+        int liveMoves[Bot::MAX_ROLL + 1], aheadMoves[Bot::MAX_ROLL + 1];
+
+        auto start = std::chrono::steady_clock::now();
+        for (int roll = Bot::MIN_ROLL; roll <= Bot::MAX_ROLL; roll++)
+            liveMoves[roll] = live.getMove(roll);
+        liveTime += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (steps++; ahead.thinkAhead(); steps++);
+        thinkTime += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int roll = Bot::MIN_ROLL; roll <= Bot::MAX_ROLL; roll++, calls++)
+            aheadMoves[roll] = ahead.getMove(roll);
+        aheadTime += std::chrono::steady_clock::now() - start;
+
+        for (int roll = Bot::MIN_ROLL; roll <= Bot::MAX_ROLL; roll++)
+            REQUIRE(aheadMoves[roll] == liveMoves[roll]);
+    }
+
+    auto us = [&](Duration d, int n) {
+        return std::chrono::duration<double, std::micro>(d).count() / n;
+    };
+
+    std::cout << calls << " getMove calls: " << us(liveTime, calls) << "us per call, "
+        << us(aheadTime, calls) << "us per call worked out ahead, "
+        << us(thinkTime, steps) << "us per thinkAhead step" << std::endl;
+}
+
+TEST_CASE("card parsing throughput", "[.][bench]") {
+    // suggestion messages like the ones the comms protocol sends, in mixed case
+    std::string messages;
+    Random rng(1);
+    for (int i = 0; i < 1000; i++) {
+        Bot::Suggestion sug(Bot::Player(rng() % (Bot::MAX_PLAYER + 1)),
+                Bot::Weapon(rng() % (Bot::MAX_WEAPON + 1)), Bot::Room(rng() % (Bot::MAX_ROOM + 1)));
+        std::string room = Bot::roomToStr(sug.room);
+        if (i % 2)
+            std::transform(room.begin(), room.end(), room.begin(), ::tolower);
+        messages += Bot::playerToStr(sug.player) + "," + Bot::weaponToStr(sug.weapon) + "," +
+            room + ";";
+    }
+
+    const int rounds = 1000;
+    StringView all(messages);
+    Bot::Card card(Bot::SCARLET);
+    long parses = 0;
+    size_t names = 0;
+
+    unsigned long allocs = allocCount;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < rounds; r++) {
+        size_t begin = 0;
+        while (begin < all.size()) {
+            size_t end = begin;
+            while ((all[end] != ',') && (all[end] != ';'))
+                end++;
+
+            if (!Bot::Card::parse(all.substr(begin, end - begin), card))
+                FAIL("couldn't parse a card");
+            names += card.name().size();
+            parses++;
+            begin = end + 1;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(end - start).count();
+
+    REQUIRE(names > 0);
+    std::cout << parses << " cards: " << parses / s / 1e6 << " million parses per second, " <<
+        double(allocCount - allocs) / parses << " allocations per parse" << std::endl;
+}
+
+TEST_CASE("path search latency", "[.][bench]") {
+    // a few occupied tiles so that the empty board table can't be used
+    std::vector<bool> occupied(Board::BOARD_SIZE, false);
+    for (int pos : { 26, 33, 44, 60 })
+        occupied[pos] = true;
+
+    for (int turns : { 1, 2, Board::ROOM_COUNT }) {
+        int calls = 0;
+        unsigned long allocs = allocCount;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int s = 0; s < Board::BOARD_SIZE; s++) {
+            for (int d = 0; d < Board::BOARD_SIZE; d++, calls++) {
+                try {
+                    Position(s).path(d, occupied, turns);
+                } catch (std::runtime_error&) {
+                }
+            }
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(end - start).count() / calls;
+        double perCall = double(allocCount - allocs) / calls;
+
+        std::cout << "turns " << turns << ": " << perCall << " allocations per path call, " << us
+            << "us per call" << std::endl;
+    }
+}
+
+
+TEST_CASE("probability predictor latency", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int games = 20;
+
+    for (int players : { 3, 4, 6 }) {
+        std::vector<Bot::Player> o(order.begin(), order.begin() + players);
+
+        for (int size : { 0, 10, 30, 60 }) {
+            Random rng(size);
+            double us = 0;
+            double worst = 0;
+            int fallbacks = 0;
+
+            for (int g = 0; g < games; g++) {
+                BotBench bot(Bot::SCARLET, o);
+                fillDealtLog(bot, o, size, rng);
+
+                ProbabilityPredictor predictor(Bot::SCARLET, o);
+                auto start = std::chrono::steady_clock::now();
+                predictor.update(bot.notes, bot.log);
+                auto end = std::chrono::steady_clock::now();
+                fallbacks += predictor.overBudget();
+
+                double t = std::chrono::duration<double, std::micro>(end - start).count();
+                us += t / games;
+                worst = std::max(worst, t);
+            }
+
+            std::cout << players << " players, log size " << size << ": " << us <<
+                "us per update, " << worst << "us worst, " << fallbacks << " over budget" <<
+                std::endl;
+        }
+    }
+}
+
+TEST_CASE("particle predictor event throughput", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int events = 60;
+
+    for (auto policy : { ParticleOptions::RESAMPLE, ParticleOptions::REJECT }) {
+        for (int particles : { 100, 1000, 10000 }) {
+            ParticleOptions options;
+            options.particles = particles;
+            options.policy = policy;
+
+            Random rng(particles);
+            BotBench bot(Bot::SCARLET, order);
+            Deal deal = dealCards(bot, order, rng);
+
+            ParticlePredictor predictor(Bot::SCARLET, order, options, particles);
+            auto start = std::chrono::steady_clock::now();
+            predictor.update(bot.notes, bot.log);
+            auto end = std::chrono::steady_clock::now();
+            double init = std::chrono::duration<double, std::micro>(end - start).count();
+
+            double us = 0;
+            for (int i = 0; i < events; i++) {
+                dealtSuggestion(bot, deal, rng);
+
+                start = std::chrono::steady_clock::now();
+                predictor.update(bot.notes, bot.log);
+                end = std::chrono::steady_clock::now();
+                us += std::chrono::duration<double, std::micro>(end - start).count() / events;
+            }
+
+            std::cout << (policy == ParticleOptions::RESAMPLE ? "resample" : "reject") << ", " <<
+                particles << " particles: " << init << "us to start, " << us << "us per event ("
+                << 1e6 / us << " events/s)" << std::endl;
+        }
+    }
+}
+
+TEST_CASE("move planner latency", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    Random rng(1);
+    BotBench bot(Bot::SCARLET, order);
+    Deal deal = dealCards(bot, order, rng);
+    for (int i = 0; i < 10; i++)
+        dealtSuggestion(bot, deal, rng);
+
+    // scoring the rooms, after the deals are up to date
+    InformationPlanner information(Bot::SCARLET, order, 0);
+    double gains[Bot::MAX_ROOM + 1];
+    information.update(bot.notes, bot.log);
+
+    const int runs = 100;
+    unsigned long allocs = allocCount;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++)
+        information.roomGains(bot.notes, bot.log, gains);
+    auto end = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - start).count() / runs;
+
+    std::cout << "room gains: " << us << "us per call, " << double(allocCount - allocs) / runs <<
+        " allocations per call" << std::endl;
+
+    // choosing the move from every position on the board, with every dice roll
+    MovePlanner planner;
+    double values[Board::ROOM_COUNT] = {};
+    for (int r = 1; r < Board::ROOM_COUNT; r++)
+        values[r] = r;
+
+    int calls = 0;
+    allocs = allocCount;
+    start = std::chrono::steady_clock::now();
+    for (int pos = 0; pos < Board::BOARD_SIZE; pos++)
+        for (int roll = 2; roll <= 12; roll++, calls++)
+            planner.plan(pos, roll, values);
+    end = std::chrono::steady_clock::now();
+    us = std::chrono::duration<double, std::micro>(end - start).count() / calls;
+
+    std::cout << "move: " << us << "us per call, " << double(allocCount - allocs) / calls <<
+        " allocations per call" << std::endl;
+}
+
+TEST_CASE("snapshot latency", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int runs = 1000;
+
+    for (int size : { 10, 50, 200, 1000 }) {
+        Random rng(size);
+        Bot bot(Bot::SCARLET, order);
+        fillDealtLog(bot, order, size, rng);
+
+        std::vector<uint8_t> buffer(bot.serialize(nullptr, 0));
+
+        unsigned long allocs = allocCount;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++)
+            bot.serialize(buffer.data(), buffer.size());
+        auto end = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(end - start).count() / runs;
+
+        std::cout << "log size " << size << ": " << buffer.size() << " bytes, serialize " << us <<
+            "us and " << double(allocCount - allocs) / runs << " allocations per call";
+
+        Bot restored(Bot::SCARLET, order);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++)
+            restored.deserialize(buffer.data(), buffer.size());
+        end = std::chrono::steady_clock::now();
+        us = std::chrono::duration<double, std::micro>(end - start).count() / runs;
+
+        std::cout << ", deserialize " << us << "us per call" << std::endl;
+    }
+}
+
+TEST_CASE("batch ingestion", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int runs = 20;
+
+    for (int size : { 30, 100, 300 }) {
+        Random rng(size);
+        auto events = dealtEvents(order, size, rng);
+
+        // a batch of a single event is the same as calling the function it stands for
+        std::vector<std::vector<Bot::Event>> single;
+        for (auto& e : events)
+            single.push_back({ e });
+
+        std::vector<std::unique_ptr<Bot>> bots;
+        for (int i = 0; i < 2 * runs; i++)
+            bots.emplace_back(new Bot(Bot::SCARLET, order, i % runs));
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++)
+            for (auto& e : single)
+                bots[i]->ingest(e);
+        auto end = std::chrono::steady_clock::now();
+        double one = std::chrono::duration<double, std::milli>(end - start).count() / runs;
+
+        start = std::chrono::steady_clock::now();
+        for (int i = runs; i < 2 * runs; i++)
+            bots[i]->ingest(events);
+        end = std::chrono::steady_clock::now();
+        double batched = std::chrono::duration<double, std::milli>(end - start).count() / runs;
+
+        REQUIRE(bots[0]->serialize() == bots[runs]->serialize());
+
+        std::cout << events.size() << " events: " << one << "ms one at a time, " << batched <<
+            "ms in a batch" << std::endl;
+    }
+}
+
+TEST_CASE("logic log throughput", "[.][bench]") {
+    const int lines = 200000;
+    const std::string msg = "deduced that Plum has the Rope from a suggestion by Scarlet";
+
+    for (int threads : { 1, 2, 4, 8 }) {
+        LogicLog::readFromLast();
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++)
+            pool.push_back(std::thread([&]() {
+                for (int i = 0; i < lines; i++)
+                    LogicLog::addLog(msg);
+            }));
+        for (auto& t : pool)
+            t.join();
+
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+            (double(lines) * threads);
+
+        start = std::chrono::steady_clock::now();
+        size_t read = LogicLog::readFromLast().size();
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        std::cout << threads << " threads: " << ns << "ns per line, " << read <<
+            " lines read in " << ms << "ms" << std::endl;
+    }
+}
+
+TEST_CASE("log sink overhead", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int events = 200;
+    const int games = 50;
+
+    for (LogSink::Level level : { LogSink::OFF, LogSink::INFO, LogSink::LOGIC }) {
+        double us = 0;
+        unsigned long allocs = 0;
+        size_t lines = 0;
+
+        for (int g = 0; g < games; g++) {
+            Bot bot(Bot::SCARLET, order);
+            bot.getLogSink().setLevel(level);
+            bot.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+
+            unsigned long before = allocCount.load();
+            auto start = std::chrono::steady_clock::now();
+            fillLog(bot, order, events);
+            auto end = std::chrono::steady_clock::now();
+
+            allocs += allocCount.load() - before;
+            us += std::chrono::duration<double, std::micro>(end - start).count();
+            lines += bot.getLogSink().readFull().size();
+        }
+
+        std::cout << "level " << level << ": " << us / (games * events) << "us and " <<
+            double(allocs) / (games * events) << " allocations per event, " << lines / games <<
+            " lines kept per game" << std::endl;
+    }
+}
+
+TEST_CASE("deduction log overhead", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+        Bot::MUSTARD, Bot::WHITE };
+
+    const int events = 200;
+    const int games = 50;
+
+    // without recording every deduction is formatted and logged, recording replaces that. The
+    // difference only shows in builds that log, with NO_LOGGING neither allocates.
+    for (bool record : { false, true }) {
+        double us = 0;
+        unsigned long allocs = 0;
+        uint64_t deductions = 0;
+
+        for (int g = 0; g < games; g++) {
+            Bot bot(Bot::SCARLET, order);
+            bot.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+            if (record)
+                bot.recordDeductions();
+
+            unsigned long before = allocCount.load();
+            auto start = std::chrono::steady_clock::now();
+            fillLog(bot, order, events);
+            auto end = std::chrono::steady_clock::now();
+
+            allocs += allocCount.load() - before;
+            us += std::chrono::duration<double, std::micro>(end - start).count();
+            deductions += bot.getDeductions().total();
+        }
+
+        std::cout << (record ? "recording: " : "logging messages: ") << us / (games * events) <<
+            "us and " << double(allocs) / (games * events) << " allocations per event, " <<
+            deductions / games << " deductions per game" << std::endl;
+    }
+
+    // the deductor on its own, so that the cost of the deductions isn't hidden by the rest of
+    // the bot
+    unsigned long logged = 0;
+    for (bool record : { false, true }) {
+        unsigned long allocs = 0;
+        uint64_t deductions = 0;
+
+        for (int g = 0; g < games; g++) {
+            Random rng(g);
+            Deal deal(order, rng);
+            Bot::NotesMatrix notes;
+            deal.note(0, notes);
+            Bot::SuggestionLog suggestions;
+            for (int i = 0; i < events; i++)
+                deal.suggest(rng() % order.size(), rng, suggestions);
+
+            IncrementalDeductor deductor(Bot::SCARLET, order);
+            DeductionLog recorded(Bot::DEFAULT_DEDUCTION_CAPACITY);
+            if (record)
+                deductor.setDeductionLog(&recorded);
+
+            unsigned long before = allocCount.load();
+            while (deductor.run(suggestions, notes)) {}
+            allocs += allocCount.load() - before;
+            deductions += recorded.total();
+        }
+
+        // the same games are played twice, so the first pass has as many deductions
+        if (!record) {
+            logged = allocs;
+            continue;
+        }
+
+        std::cout << "incremental deductor, " << deductions / games << " deductions per game: "
+            << double(logged) / deductions << " allocations per deduction logging messages, " <<
+            double(allocs) / deductions << " recording" << std::endl;
+    }
+
+    // formatting is only paid for when the records are read
+    DeductionLog log(Bot::DEFAULT_DEDUCTION_CAPACITY);
+    for (int i = 0; i < Bot::DEFAULT_DEDUCTION_CAPACITY; i++)
+        log.add(DeductionLog::Rule(i % DeductionLog::RULE_COUNT), DeductionLog::LACKS,
+                Bot::Player(i % Bot::NotesMatrix::PLAYER_COUNT),
+                Bot::NotesMatrix::card(i % Bot::NotesMatrix::CARD_COUNT));
+
+    auto start = std::chrono::steady_clock::now();
+    size_t formatted = log.messages().size();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / formatted;
+
+    std::cout << "formatting: " << ns << "ns per record" << std::endl;
+}
+
+TEST_CASE("host load", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN };
+    const int n = order.size();
+
+    const int games = 10000;
+    const int turns = 5;
+
+    struct Game {
+        BotHost::Handle bot;
+        Random rng;
+        std::unique_ptr<Deal> deal;
+        int turn = 0;
+        std::chrono::steady_clock::time_point asked;
+        Metrics::Histogram latency;
+    };
+
+    BotHost host;
+    std::vector<Game> all(games);
+
+    for (int g = 0; g < games; g++) {
+        Game& game = all[g];
+        game.rng = Random(g);
+        game.bot = host.add(Bot::SCARLET, order, g);
+
+        game.deal.reset(new Deal(order, game.rng));
+        host.setCards(game.bot, game.deal->cards(0));
+        host.updateBoard(game.bot, { { Bot::SCARLET, 20 }, { Bot::PLUM, 30 },
+                { Bot::PEACOCK, 40 }, { Bot::GREEN, 50 } });
+    }
+    host.wait();
+
+    std::atomic<long> events(0);
+
+    // every turn the other players make a suggestion, after which the bot is asked for its move.
+    // Like on a game server the next turn is only played once the bot has answered, so all the
+    // games are in progress at the same time.
+    std::function<void(Game&)> play = [&](Game& game) {
+        for (int from = 1; from < n; from++) {
+            Bot::Suggestion sug = Deal::suggestion(game.rng);
+            host.madeSuggestion(game.bot, order[from], sug);
+
+            int show = game.deal->answer(from, sug);
+            if (show < 0)
+                host.noOtherShownCard(game.bot);
+            else
+                host.otherShownCard(game.bot, order[show]);
+            host.newTurn(game.bot);
+        }
+        events.fetch_add(3 * (n - 1) + 2, std::memory_order_relaxed);
+
+        game.asked = std::chrono::steady_clock::now();
+        host.getMove(game.bot, 2 + game.rng() % 11, [&](int move) {
+            game.latency.add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - game.asked).count());
+
+            host.movePlayer(game.bot, Bot::SCARLET, move);
+            if (++game.turn < turns)
+                play(game);
+        });
+    };
+
+    unsigned long before = allocCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto& game : all)
+        play(game);
+    host.wait();
+
+    auto end = std::chrono::steady_clock::now();
+    unsigned long allocs = allocCount.load() - before;
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    Metrics::Histogram latency;
+    for (auto& game : all)
+        latency.merge(game.latency);
+
+    std::cout << games << " games on " << host.threads() << " threads: " << events / seconds <<
+        " events/s, " << latency.calls / seconds << " getMove calls/s, " << double(allocs) /
+        events << " allocations per event" << std::endl;
+    std::cout << "getMove latency: p50 " << latency.percentile(0.5) / 1e6 << "ms, p99 " <<
+        latency.percentile(0.99) / 1e6 << "ms, max " << latency.maxNs / 1e6 << "ms" << std::endl;
+
+    for (auto& game : all)
+        host.remove(game.bot);
+    host.wait();
+}
+
+TEST_CASE("protocol driver throughput", "[.][bench]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN };
+    const int games = 20;
+    const int turns = 200;
+
+    // the same suggestions as lines for the driver and as calls on bots of our own
+    std::vector<std::string> lines;
+    std::vector<std::unique_ptr<Bot>> direct;
+    std::vector<std::function<void(Bot&)>> calls;
+    Random rng(1);
+
+    for (int g = 0; g < games; g++) {
+        lines.push_back(std::to_string(g) + " new Scarlet Scarlet,Plum,Peacock,Green " +
+                std::to_string(g));
+        direct.push_back(std::unique_ptr<Bot>(new Bot(Bot::SCARLET, order, g)));
+    }
+
+    for (int t = 0; t < turns; t++) {
+        for (int g = 0; g < games; g++) {
+            Bot::Player from = order[1 + rng() % 3];
+            Bot::Player show = order[rng() % 4];
+            Bot::Suggestion sug(Bot::Player(rng() % (Bot::MAX_PLAYER + 1)),
+                    Bot::Weapon(rng() % (Bot::MAX_WEAPON + 1)),
+                    Bot::Room(rng() % (Bot::MAX_ROOM + 1)));
+
+            std::string id = std::to_string(g) + " ";
+            lines.push_back(id + "suggest " + Bot::playerToStr(from) + " " +
+                    Bot::playerToStr(sug.player) + "," + Bot::weaponToStr(sug.weapon) + "," +
+                    Bot::roomToStr(sug.room));
+            lines.push_back(id + ((show == from) ? "noshown" : "shown " + Bot::playerToStr(show)));
+            lines.push_back(id + "turn");
+
+            calls.push_back([=](Bot& b) {
+                b.madeSuggestion(from, sug);
+                if (show == from)
+                    b.noOtherShownCard();
+                else
+                    b.otherShownCard(show);
+                b.newTurn();
+            });
+        }
+    }
+
+    unsigned long allocs = allocCount;
+    for (size_t i = 0; i < calls.size(); i++)
+        calls[i](*direct[i % games]);
+    unsigned long directAllocs = allocCount - allocs;
+
+    int devNull = open("/dev/null", O_WRONLY);
+    REQUIRE(devNull >= 0);
+    ProtocolDriver driver(-1, devNull);
+
+    for (int g = 0; g < games; g++)
+        driver.handle(lines[g]);
+
+    allocs = allocCount;
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = games; i < lines.size(); i++)
+        driver.handle(lines[i]);
+    driver.flush();
+
+    auto end = std::chrono::steady_clock::now();
+    unsigned long driverAllocs = allocCount - allocs;
+    close(devNull);
+
+    const int n = lines.size() - games;
+    double us = std::chrono::duration<double, std::micro>(end - start).count() / n;
+
+    REQUIRE(driver.games() == games);
+    std::cout << n << " lines: " << us << "us per line, " <<
+        double(long(driverAllocs) - long(directAllocs)) / n <<
+        " allocations per line on top of the bot's own" << std::endl;
+}
+
+// vim: set expandtab textwidth=100:
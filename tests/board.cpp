@@ -1,37 +1,52 @@
 #include <catch/catch.hpp>
 #include <algorithm>
+#include <vector>
 #include "../include/board.h"
 
 using namespace AI::Board;
 using Catch::Matchers::VectorContains;
 
+std::vector<int> adjacent(int pos) {
+    Neighbours ngh = neighbours(pos);
+    return std::vector<int>(ngh.begin(), ngh.end());
+}
+
 bool contains(std::vector<int> vec, int v) {
     return std::find(vec.begin(), vec.end(), v) != vec.end();
 }
 
 TEST_CASE("board namespace", "[board]") {
-    // check that board was actually initialized
-    REQUIRE(board.size() == BOARD_SIZE);
+    // check that the offsets cover every edge
+    REQUIRE(NEIGHBOUR_OFFSETS[BOARD_SIZE] == EDGE_COUNT);
 
     // basic
-    REQUIRE_THAT(board[10], VectorContains(11));
+    REQUIRE_THAT(adjacent(10), VectorContains(11));
 
     // check for dual-edge connection
-    REQUIRE_THAT(board[11], VectorContains(10));
+    REQUIRE_THAT(adjacent(11), VectorContains(10));
 
     // some corner-cases (pun intended)
-    REQUIRE_FALSE(contains(board[42], 43));
-    REQUIRE_FALSE(contains(board[43], 53));
+    REQUIRE_FALSE(contains(adjacent(42), 43));
+    REQUIRE_FALSE(contains(adjacent(43), 53));
 
     // some room entrances
-    REQUIRE_THAT(board[0], VectorContains(36));
-    REQUIRE_THAT(board[7], VectorContains(8));
-    REQUIRE_THAT(board[9], VectorContains(13));
-    REQUIRE_THAT(board[4], VectorContains(74));
+    REQUIRE_THAT(adjacent(0), VectorContains(36));
+    REQUIRE_THAT(adjacent(7), VectorContains(8));
+    REQUIRE_THAT(adjacent(9), VectorContains(13));
+    REQUIRE_THAT(adjacent(4), VectorContains(74));
 
     // secret passages
-    REQUIRE_THAT(board[7], VectorContains(2));
-    REQUIRE_THAT(board[4], VectorContains(9));
+    REQUIRE_THAT(adjacent(7), VectorContains(2));
+    REQUIRE_THAT(adjacent(4), VectorContains(9));
+
+    for (int pos = 0; pos < BOARD_SIZE; pos++) {
+        Neighbours ngh = neighbours(pos);
+        REQUIRE(ngh.size() > 0);
+
+        // every edge goes both ways
+        for (int i = 0; i < ngh.size(); i++)
+            REQUIRE(contains(adjacent(ngh[i]), pos));
+    }
 }
 
 // vim: set expandtab textwidth=100:
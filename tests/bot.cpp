@@ -1,9 +1,11 @@
 #include <catch/catch.hpp>
 #include <algorithm>
+#include <cctype>
 #include "../include/bot.h"
 #include "../include/tests.h"
 #include "../include/deck.h"
 #include "../include/board.h"
+#include "../include/deduction-log.h"
 
 using namespace AI;
 using Catch::Matchers::Equals;
@@ -86,6 +88,53 @@ TEST_CASE("Bot class", "[bot]") {
         REQUIRE(notes.knows());
     }
 
+    SECTION("NotesMatrix class") {
+        Bot::NotesMatrix notes;
+
+        // every card must map to a unique index and back
+        Bot::NotesMatrix::CardMask all = 0;
+        for (int i = 0; i < Bot::NotesMatrix::CARD_COUNT; i++) {
+            Bot::Card c = Bot::NotesMatrix::card(i);
+            REQUIRE(Bot::NotesMatrix::index(c) == i);
+            REQUIRE((Bot::NotesMatrix::typeMask(c.type) & Bot::NotesMatrix::mask(c)));
+            all |= Bot::NotesMatrix::mask(c);
+        }
+        REQUIRE(all == Bot::NotesMatrix::ALL_CARDS);
+
+        Bot::Player p = randEnum(Bot::MAX_PLAYER);
+        Bot::Card c = randEnum(Bot::MAX_WEAPON);
+
+        REQUIRE_FALSE(notes[p][c].has);
+        REQUIRE_FALSE(notes[p][c].concluded());
+
+        // the rows and columns must stay in sync
+        notes[p][c].has = true;
+        REQUIRE(notes[p][c].has);
+        REQUIRE(notes[p][c].knows());
+        REQUIRE(notes.get(p, c, Bot::NotesMatrix::HAS));
+        REQUIRE(notes.cards(p, Bot::NotesMatrix::HAS) == Bot::NotesMatrix::mask(c));
+        REQUIRE(notes.players(c, Bot::NotesMatrix::HAS) == Bot::NotesMatrix::playerBit(p));
+        REQUIRE(notes.notes(p, c).has);
+        REQUIRE_FALSE(notes.notes(p, c).lacks);
+
+        notes[p][c].has = false;
+        REQUIRE(notes.cards(p, Bot::NotesMatrix::HAS) == 0);
+        REQUIRE(notes.players(c, Bot::NotesMatrix::HAS) == 0);
+
+        // bulk set
+        notes.set(p, Bot::NotesMatrix::ROOM_CARDS, Bot::NotesMatrix::LACKS);
+        for (int i = 0; i <= int(Bot::MAX_ROOM); i++) {
+            REQUIRE(notes[p][Bot::Room(i)].lacks);
+            REQUIRE(notes.players(Bot::Room(i), Bot::NotesMatrix::LACKS) ==
+                    Bot::NotesMatrix::playerBit(p));
+        }
+
+        Bot::NotesMatrix other = notes;
+        REQUIRE(other == notes);
+        other[p][c].seen = true;
+        REQUIRE(other != notes);
+    }
+
     SECTION("SuggestionLog class") {
         Bot::Player from = randEnum(Bot::MAX_PLAYER);
         Bot::Player show = randEnum(Bot::MAX_PLAYER);
@@ -163,6 +212,45 @@ TEST_CASE("Bot class", "[bot]") {
         REQUIRE_THROWS_AS(Bot::Card("exception"), std::invalid_argument&);
     }
 
+    SECTION("parsing cards from views") {
+        // every card by its own name, in any case, and by the other names the protocol has for it
+        for (int i = 0; i < Bot::NotesMatrix::CARD_COUNT; i++) {
+            Bot::Card card = Bot::NotesMatrix::card(i);
+            std::string upper = card.str();
+            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+            Bot::Card parsed(Bot::SCARLET);
+            REQUIRE(Bot::Card::parse(card.name(), parsed));
+            REQUIRE(parsed == card);
+            REQUIRE(Bot::Card::parse(upper, parsed));
+            REQUIRE(parsed == card);
+            REQUIRE(card.name() == card.str());
+        }
+
+        REQUIRE(Bot::strToWeapon("Knife") == Bot::KNIFE);
+        REQUIRE(Bot::strToWeapon("revolver") == Bot::REVOLVER);
+        REQUIRE(Bot::strToWeapon("SPANNER") == Bot::SPANNER);
+        REQUIRE(Bot::strToRoom("games room") == Bot::GAMES_ROOM);
+        REQUIRE(Bot::strToRoom("Billiard Room") == Bot::GAMES_ROOM);
+
+        // a part of a message, without copying it
+        std::string message = "Plum,Lead Pipe,Dining Room";
+        StringView view(message);
+        REQUIRE(Bot::strToPlayer(view.substr(0, 4)) == Bot::PLUM);
+        REQUIRE(Bot::strToWeapon(view.substr(5, 9)) == Bot::LEAD_PIPE);
+        REQUIRE(Bot::strToRoom(view.substr(15)) == Bot::DINING_ROOM);
+
+        // a card of the wrong type, names that only share a hash slot and the end of a name
+        std::vector<StringView> wrong = { "", "Plu", "Plumb", "Study ", "studx",
+            StringView("Pistol\0", 7), StringView("lead\0pipe", 9) };
+        Bot::Card unchanged(Bot::ROPE);
+        for (auto s : wrong)
+            REQUIRE_FALSE(Bot::Card::parse(s, unchanged));
+        REQUIRE(unchanged == Bot::Card(Bot::ROPE));
+        REQUIRE_THROWS_AS(Bot::strToPlayer("Rope"), std::invalid_argument&);
+        REQUIRE_THROWS_AS(Bot::strToRoom(view.substr(0, 4)), std::invalid_argument&);
+    }
+
     SECTION("set cards") {
         Bot::Player player = Bot::SCARLET;
         Bot::Weapon weapon = Bot::CANDLESTICK;
@@ -194,6 +282,272 @@ TEST_CASE("Bot class", "[bot]") {
         REQUIRE(notes[other][card].has);
     }
 
+    SECTION("record deductions") {
+        Bot bot(Bot::SCARLET, { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK });
+        REQUIRE(bot.getDeductions().size() == 0);
+
+        auto logged = [&]() {
+            int deduced = 0;
+            for (const auto& line : bot.getLogSink().readFromLast())
+                if (line.find("Deduced that") != std::string::npos)
+                    deduced++;
+            return deduced;
+        };
+
+        bot.recordDeductions();
+        logged();
+        bot.madeSuggestion(Bot::PLUM, Bot::Suggestion(Bot::GREEN, Bot::ROPE, Bot::KITCHEN));
+        bot.noOtherShownCard();
+
+        auto messages = bot.getDeductions().messages();
+        REQUIRE_THAT(messages, VectorContains(std::string(
+                        "Deduced that Peacock lacks Kitchen (no-show)")));
+        REQUIRE_THAT(messages, VectorContains(std::string(
+                        "Deduced that Peacock lacks Rope (no-show)")));
+
+        // the records replace the log messages, which are only built when they are read
+        REQUIRE(logged() == 0);
+
+        // nothing more is recorded once it is stopped, and the deductions are logged again
+        bot.recordDeductions(0);
+        bot.madeSuggestion(Bot::PEACOCK, Bot::Suggestion(Bot::WHITE, Bot::KNIFE, Bot::STUDY));
+        bot.noOtherShownCard();
+        REQUIRE(bot.getDeductions().total() == 0);
+#if !defined(NO_LOGGING) && !defined(NO_LOGIC_LOGGING)
+        REQUIRE(logged() > 0);
+#endif
+    }
+
+    SECTION("log sinks") {
+        Bot first(Bot::SCARLET, { Bot::SCARLET, Bot::PLUM });
+        Bot second(Bot::PLUM, { Bot::SCARLET, Bot::PLUM });
+        first.getLogSink().readFromLast();
+        second.getLogSink().readFromLast();
+
+        first.setCards({ Bot::KNIFE });
+        auto lines = first.getLogSink().readFromLast();
+
+#if defined(NO_LOGGING) || defined(NO_INFO_LOGGING)
+        REQUIRE(lines.empty());
+#else
+        REQUIRE_THAT(lines, VectorContains(std::string("setting private cards: [Dagger]")));
+#endif
+        // every bot only has its own lines
+        REQUIRE(second.getLogSink().readFromLast().empty());
+
+        first.getLogSink().setLevel(LogSink::OFF);
+        first.setCards({ Bot::ROPE });
+        REQUIRE(first.getLogSink().readFromLast().empty());
+    }
+
+    SECTION("serialize and deserialize") {
+        std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+        Bot bot(Bot::PLUM, order, 3);
+
+        bot.setCards({ Bot::SCARLET, Bot::KNIFE, Bot::STUDY, Bot::ROPE });
+        bot.setCards({ Bot::GARAGE, Bot::BEDROOM }, true);
+        bot.updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 60 } });
+        bot.showCard(Bot::PEACOCK, Bot::GREEN);
+
+        bot.madeSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::WHITE, Bot::ROPE, Bot::KITCHEN));
+        bot.otherShownCard(Bot::PLUM);
+        bot.newTurn();
+        bot.madeSuggestion(Bot::PEACOCK, Bot::Suggestion(Bot::GREEN, Bot::SPANNER, Bot::STUDY));
+        bot.noOtherShownCard();
+        bot.newTurn();
+
+        // the last suggestion is still waiting for a show
+        bot.madeSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::MUSTARD, Bot::LEAD_PIPE,
+                    Bot::COURTYARD));
+
+        std::vector<uint8_t> data = bot.serialize();
+        REQUIRE(bot.serialize(nullptr, 0) == data.size());
+
+        Bot restored(Bot::WHITE, { Bot::WHITE, Bot::GREEN }, 7);
+        restored.deserialize(data);
+        REQUIRE(restored.getNotes() == bot.getNotes());
+        REQUIRE(restored.serialize() == data);
+
+        // the restored bot carries on exactly where the original left off
+        for (Bot* b : { &bot, &restored }) {
+            b->otherShownCard(Bot::PEACOCK);
+            b->newTurn();
+        }
+        REQUIRE(restored.getNotes() == bot.getNotes());
+        for (int roll = 2; roll <= 12; roll++)
+            REQUIRE(restored.getMove(roll) == bot.getMove(roll));
+        for (Bot* b : { &bot, &restored })
+            b->movePlayer(Bot::PLUM, 4);
+        REQUIRE(restored.getSuggestion() == bot.getSuggestion());
+        REQUIRE(restored.serialize() == bot.serialize());
+
+        SECTION("damaged snapshots") {
+            Bot other(Bot::WHITE, { Bot::WHITE, Bot::GREEN }, 7);
+            std::vector<uint8_t> before = other.serialize();
+
+            // every shorter snapshot is missing something
+            for (size_t size = 0; size < data.size(); size++)
+                REQUIRE_THROWS_AS(other.deserialize(data.data(), size), std::invalid_argument&);
+
+            std::vector<uint8_t> longer = data;
+            longer.push_back(0);
+            REQUIRE_THROWS_AS(other.deserialize(longer), std::invalid_argument&);
+
+            std::vector<uint8_t> version = data;
+            version[2]++;
+            REQUIRE_THROWS_AS(other.deserialize(version), std::invalid_argument&);
+
+            std::vector<uint8_t> magic = data;
+            magic[0] = 0;
+            REQUIRE_THROWS_AS(other.deserialize(magic), std::invalid_argument&);
+
+            // the bot is left unchanged
+            REQUIRE(other.serialize() == before);
+        }
+    }
+
+    SECTION("think ahead") {
+        std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+        Bot bot(Bot::PLUM, order, 3);
+        Bot thinking(Bot::PLUM, order, 3);
+
+        for (Bot* b : { &bot, &thinking }) {
+            b->setCards({ Bot::SCARLET, Bot::KNIFE, Bot::STUDY, Bot::ROPE });
+            b->updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 60 } });
+            b->madeSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::WHITE, Bot::ROPE, Bot::KITCHEN));
+            b->otherShownCard(Bot::PLUM);
+            b->newTurn();
+        }
+
+        // the moves first, then a suggestion for every room the bot can end up in
+        int steps = 0;
+        while (thinking.thinkAhead())
+            steps++;
+        REQUIRE(steps > 1);
+        REQUIRE(!thinking.thinkAhead());
+
+        for (int roll = Bot::MIN_ROLL; roll <= Bot::MAX_ROLL; roll++)
+            REQUIRE(thinking.getMove(roll) == bot.getMove(roll));
+        REQUIRE(thinking.getMove(20) == bot.getMove(20));
+
+        // moving only changes the board, so the suggestions worked out for the rooms still hold
+        int dest = bot.getMove(12);
+        REQUIRE(dest < Board::ROOM_COUNT);
+        for (Bot* b : { &bot, &thinking })
+            b->movePlayer(Bot::PLUM, dest);
+        REQUIRE(thinking.getSuggestion() == bot.getSuggestion());
+
+#ifdef METRICS
+        REQUIRE(thinking.getMetrics().counters[Metrics::THOUGHT_ANSWERS] ==
+                Bot::MAX_ROLL - Bot::MIN_ROLL + 2);
+#endif
+
+        // anything that changes the notes means starting over
+        for (Bot* b : { &bot, &thinking }) {
+            b->noShowCard();
+            b->newTurn();
+            b->madeSuggestion(Bot::PEACOCK, Bot::Suggestion(Bot::GREEN, Bot::SPANNER, Bot::STUDY));
+        }
+        REQUIRE(thinking.thinkAhead());
+        for (Bot* b : { &bot, &thinking })
+            b->noOtherShownCard();
+        while (thinking.thinkAhead());
+
+        REQUIRE(thinking.getSuggestion() == bot.getSuggestion());
+        REQUIRE(thinking.getMove(7) == bot.getMove(7));
+        REQUIRE(thinking.serialize() == bot.serialize());
+
+        // the planner can't be thought ahead for
+        thinking.setStrategy(Bot::INFORMATION);
+        REQUIRE(!thinking.thinkAhead());
+    }
+
+    SECTION("ingesting events in a batch") {
+        std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN };
+        const int n = order.size();
+        Random rng(11);
+        Deal deal(order, rng);
+        std::vector<Bot::Card> hand = deal.cards(1);
+        std::vector<Bot::Card> table = deal.cards(Deal::TABLE);
+
+        // every event is given to one bot straight away and saved for the other
+        Bot direct(Bot::PLUM, order, 3);
+        std::vector<Bot::Event> events;
+
+        direct.setCards(hand);
+        events.push_back(Bot::Event::setCards(hand));
+        direct.setCards(table, true);
+        events.push_back(Bot::Event::setCards(table, true));
+        direct.updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 60 },
+                { Bot::GREEN, 80 } });
+        events.push_back(Bot::Event::updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 },
+                    { Bot::PEACOCK, 60 }, { Bot::GREEN, 80 } }));
+
+        for (int i = 0; i < 40; i++) {
+            // halfway through Scarlet shows the bot a card, which it might have deduced already
+            if (i == 20) {
+                Bot::Card card = deal.cards(0).front();
+                direct.showCard(Bot::SCARLET, card);
+                events.push_back(Bot::Event::showCard(Bot::SCARLET, card));
+            }
+
+            int from = rng() % n;
+            if (from == 1)
+                continue;
+
+            Bot::Suggestion sug = Deal::suggestion(rng);
+            direct.madeSuggestion(order[from], sug);
+            events.push_back(Bot::Event::madeSuggestion(order[from], sug));
+
+            int show = deal.answer(from, sug);
+
+            if (show < 0) {
+                direct.noOtherShownCard();
+                events.push_back(Bot::Event::noOtherShownCard());
+            } else {
+                direct.otherShownCard(order[show]);
+                events.push_back(Bot::Event::otherShownCard(order[show]));
+            }
+
+            direct.newTurn();
+            events.push_back(Bot::Event::newTurn());
+        }
+
+        direct.movePlayer(Bot::PLUM, 4);
+        events.push_back(Bot::Event::movePlayer(Bot::PLUM, 4));
+
+        Bot batched(Bot::PLUM, order, 3);
+        batched.ingest(events);
+
+        REQUIRE(batched.getNotes() == direct.getNotes());
+        REQUIRE(batched.serialize() == direct.serialize());
+        for (int roll = Bot::MIN_ROLL; roll <= Bot::MAX_ROLL; roll++)
+            REQUIRE(batched.getMove(roll) == direct.getMove(roll));
+        REQUIRE(batched.getSuggestion() == direct.getSuggestion());
+
+#ifdef METRICS
+        // once at the end, and to catch up before the bot was given the table cards and shown
+        // Scarlet's card
+        REQUIRE(batched.getMetrics().counters[Metrics::DEDUCTOR_RUNS] <= 3);
+#endif
+
+        SECTION("asking in the middle of a batch") {
+            Bot open(Bot::PLUM, order, 3);
+            open.beginBatch();
+            open.beginBatch();
+            open.ingest(std::vector<Bot::Event>(events.begin(), events.end() - 1));
+
+            // the deductions that are due are made before answering
+            REQUIRE(open.getNotes() == direct.getNotes());
+
+            open.endBatch();
+            open.ingest({ events.back() });
+            open.endBatch();
+            REQUIRE_THROWS_AS(open.endBatch(), std::runtime_error&);
+            REQUIRE(open.getNotes() == direct.getNotes());
+        }
+    }
+
     SECTION("getMove and getSuggestion") {
         Bot::Player player = Bot::SCARLET;
         Bot::Player other1 = Bot::PLUM;
@@ -206,6 +560,31 @@ TEST_CASE("Bot class", "[bot]") {
             REQUIRE_THROWS_AS(bot.getSuggestion(), std::runtime_error&);
         }
 
+        SECTION("same seed makes the same choices") {
+            // knowing the envelope makes the bot choose the weapon at random
+            std::vector<Bot::Card> cards;
+            for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+                if (Bot::Player(i) != Bot::WHITE)
+                    cards.push_back(Bot::Player(i));
+            for (int i = 0; i <= int(Bot::MAX_WEAPON); i++)
+                if (Bot::Weapon(i) != Bot::ROPE)
+                    cards.push_back(Bot::Weapon(i));
+            for (int i = 0; i <= int(Bot::MAX_ROOM); i++)
+                if (Bot::Room(i) != Bot::KITCHEN)
+                    cards.push_back(Bot::Room(i));
+
+            Bot first(player, order, 5);
+            Bot second(player, order, 5);
+
+            for (Bot* b : { &first, &second }) {
+                b->setCards(cards);
+                b->movePlayer(player, 4);
+            }
+
+            for (int i = 0; i < 20; i++)
+                REQUIRE(first.getSuggestion() == second.getSuggestion());
+        }
+
         SECTION("room") {
             std::vector<Bot::Room> wanted = { Bot::DINING_ROOM, Bot::STUDY };
 
@@ -525,8 +904,9 @@ TEST_CASE("Bot class", "[bot]") {
 
             REQUIRE(bot.player == player);
             REQUIRE_THAT(bot.order, Equals(order));
-            // check that a notes entry was created for every player
-            REQUIRE(bot.notes.size() == bot.order.size());
+            // check that the bot lacks every card until it is dealt its cards
+            REQUIRE(bot.notes.cards(player, Bot::NotesMatrix::LACKS) ==
+                    Bot::NotesMatrix::ALL_CARDS);
         }
 
         SECTION("Envelope struct") {
@@ -0,0 +1,112 @@
+#include <catch/catch.hpp>
+#include <stdexcept>
+#include <string>
+#include "../include/deduction-log.h"
+
+using namespace AI;
+
+TEST_CASE("DeductionLog class", "[deduction-log]") {
+    SECTION("records are kept in order") {
+        DeductionLog log(8);
+        REQUIRE(log.size() == 0);
+
+        log.add(DeductionLog::NO_SHOW, DeductionLog::LACKS, Bot::PLUM, Bot::ROPE);
+        log.add(DeductionLog::LOCAL_EXCLUDE, DeductionLog::HAS, Bot::GREEN, Bot::KITCHEN);
+
+        REQUIRE(log.size() == 2);
+        REQUIRE(log.total() == 2);
+        REQUIRE(log[0].rule == DeductionLog::NO_SHOW);
+        REQUIRE(log[0].fact == DeductionLog::LACKS);
+        REQUIRE(log[0].player == Bot::PLUM);
+        REQUIRE(log[0].card == Bot::NotesMatrix::index(Bot::ROPE));
+        REQUIRE(log[1].rule == DeductionLog::LOCAL_EXCLUDE);
+        REQUIRE(log[1].player == Bot::GREEN);
+
+        log.clear();
+        REQUIRE(log.size() == 0);
+        REQUIRE(log.total() == 0);
+    }
+
+    SECTION("only the last records are kept") {
+        DeductionLog log(4);
+
+        for (int i = 0; i < 10; i++)
+            log.add(DeductionLog::CONSTRAINT, DeductionLog::LACKS, Bot::SCARLET,
+                    Bot::NotesMatrix::card(i));
+
+        REQUIRE(log.size() == 4);
+        REQUIRE(log.total() == 10);
+        for (int i = 0; i < 4; i++)
+            REQUIRE(log[i].card == 6 + i);
+    }
+
+    SECTION("nothing is kept without a capacity") {
+        DeductionLog log(0);
+        log.add(DeductionLog::SEEN, DeductionLog::SAW, Bot::WHITE, Bot::STUDY);
+
+        REQUIRE(log.size() == 0);
+        REQUIRE(log.total() == 1);
+        REQUIRE(log.messages().empty());
+    }
+
+    SECTION("records are formatted as log messages") {
+        auto format = [](DeductionLog::Rule rule, DeductionLog::Fact fact, Bot::Player player,
+                const Bot::Card& card) {
+            return DeductionLog::format(DeductionLog::record(rule, fact, player, card));
+        };
+
+        REQUIRE(format(DeductionLog::LOCAL_EXCLUDE, DeductionLog::HAS, Bot::PLUM, Bot::ROPE) ==
+                "Deduced that Plum has Rope (local-exclude)");
+        REQUIRE(format(DeductionLog::NO_SHOW, DeductionLog::LACKS, Bot::GREEN, Bot::KITCHEN) ==
+                "Deduced that Green lacks Kitchen (no-show)");
+        REQUIRE(format(DeductionLog::SEEN, DeductionLog::SAW, Bot::SCARLET, Bot::WHITE) ==
+                "Deduced that Scarlet saw White (seen)");
+        REQUIRE(format(DeductionLog::CARD_COUNT_EXCLUDE, DeductionLog::LACKS, Bot::MUSTARD,
+                    Bot::GAMES_ROOM) ==
+                "Deduced that Mustard lacks Game Room (card-count-exclude)");
+        REQUIRE(format(DeductionLog::CONSTRAINT, DeductionLog::HAS, Bot::PEACOCK, Bot::KNIFE) ==
+                "Deduced that Peacock has Dagger (constraint)");
+        REQUIRE(format(DeductionLog::SEEN_PREDICTOR, DeductionLog::LOW_PROBABILITY, Bot::PLUM,
+                    Bot::SPANNER) == "Identified Wrench as a low probability card");
+        REQUIRE(format(DeductionLog::MULTIPLE_PREDICTOR, DeductionLog::HIGH_PROBABILITY,
+                    Bot::PLUM, Bot::STUDY) == "Identified Study as a high probability card");
+        REQUIRE(format(DeductionLog::NO_SHOW_PREDICTOR, DeductionLog::VERY_HIGH_PROBABILITY,
+                    Bot::PLUM, Bot::GREEN) == "Identified Green as a very high probability card");
+        REQUIRE(format(DeductionLog::ALL_LACKS, DeductionLog::ENVELOPE, Bot::PLUM, Bot::GREEN) ==
+                "SOLVED: Green is the envelope player (all-lacks)");
+        REQUIRE(format(DeductionLog::NO_HAS, DeductionLog::ENVELOPE, Bot::PLUM,
+                    Bot::LEAD_PIPE) == "SOLVED: Lead Pipe is the envelope weapon (no-has)");
+        REQUIRE(format(DeductionLog::NO_HAS, DeductionLog::ENVELOPE, Bot::PLUM,
+                    Bot::DINING_ROOM) == "SOLVED: Dining Room is the envelope room (no-has)");
+
+        DeductionLog log(2);
+        log.add(DeductionLog::SEEN, DeductionLog::SAW, Bot::SCARLET, Bot::WHITE);
+        log.add(DeductionLog::NO_SHOW, DeductionLog::LACKS, Bot::GREEN, Bot::KITCHEN);
+        REQUIRE(log.messages() == std::vector<std::string>({
+                    "Deduced that Scarlet saw White (seen)",
+                    "Deduced that Green lacks Kitchen (no-show)" }));
+    }
+
+    SECTION("invalid records") {
+        DeductionLog::Record record = DeductionLog::record(DeductionLog::SEEN, DeductionLog::SAW,
+                Bot::SCARLET, Bot::WHITE);
+
+        auto damaged = record;
+        damaged.rule = DeductionLog::RULE_COUNT;
+        REQUIRE_THROWS_AS(DeductionLog::format(damaged), std::invalid_argument&);
+
+        damaged = record;
+        damaged.fact = DeductionLog::FACT_COUNT;
+        REQUIRE_THROWS_AS(DeductionLog::format(damaged), std::invalid_argument&);
+
+        damaged = record;
+        damaged.player = Bot::NotesMatrix::PLAYER_COUNT;
+        REQUIRE_THROWS_AS(DeductionLog::format(damaged), std::invalid_argument&);
+
+        damaged = record;
+        damaged.card = Bot::NotesMatrix::CARD_COUNT;
+        REQUIRE_THROWS_AS(DeductionLog::format(damaged), std::invalid_argument&);
+    }
+}
+
+// vim: set expandtab textwidth=100:
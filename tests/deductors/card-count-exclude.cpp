@@ -10,7 +10,7 @@ void erase(std::vector<T>& vec, T obj)
 }
 
 TEST_CASE("CardCountExclude", "[card-count-exclude-deductor]") {
-    std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes;
+    Bot::NotesMatrix notes;
     std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN };
     if (rand() % 2)
         order.push_back(Bot::MUSTARD);
@@ -0,0 +1,170 @@
+#include <catch/catch.hpp>
+#include <algorithm>
+#include "../../include/deductors/constraint.h"
+#include "../../include/deductors/incremental.h"
+#include "../../include/tests.h"
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+
+    void markLacking(NM& notes, const std::vector<Bot::Player>& order)
+    {
+        for (auto p : order)
+            for (auto o : order)
+                if (o != p)
+                    notes.set(o, notes.cards(p, NM::HAS), NM::LACKS);
+    }
+
+    /**
+     * \brief Runs the deductors the same way the bot does, until nothing changes
+     */
+    void deduce(const std::vector<Deductor*>& deductors, const Bot::SuggestionLog& log,
+            NM& notes, const std::vector<Bot::Player>& order)
+    {
+        markLacking(notes, order);
+
+        bool made;
+        do {
+            made = false;
+            for (auto d : deductors)
+                if (d->run(log, notes))
+                    made = true;
+
+            if (made)
+                markLacking(notes, order);
+        } while (made);
+    }
+}
+
+TEST_CASE("ConstraintDeductor class", "[constraint-deductor]") {
+    SECTION("finds at least as much as the incremental deductor") {
+        int more = 0;
+        Random rng(12);
+
+        for (int game = 0; game < 50; game++) {
+            std::vector<Bot::Player> order;
+            for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+                order.push_back(Bot::Player(i));
+            std::shuffle(order.begin(), order.end(), rng);
+            order.resize(3 + rng() % 4);
+
+            Bot::Player player = order[0];
+            Deal deal(order, rng);
+            NM::CardMask envelope = deal.mask(Deal::ENVELOPE);
+
+            NM notes;
+            deal.note(0, notes);
+            for (auto c : deal.cards(Deal::TABLE)) {
+                notes[player][c].lacks = false;
+                notes[player][c].has = true;
+                notes[player][c].table = true;
+            }
+
+            Bot::NotesMatrix reference = notes;
+            Bot::SuggestionLog log;
+            IncrementalDeductor incremental(player, order);
+            IncrementalDeductor other(player, order);
+            ConstraintDeductor constraint(player, order);
+
+            for (int turn = 0; turn < 30; turn++) {
+                int from = rng() % order.size();
+                int show = deal.suggest(from, rng, log);
+
+                if ((from == 0) && (show >= 0)) {
+                    Bot::Player o = order[show];
+                    NM::CardMask match = deal.mask(show) & NM::mask(log.log().back().suggestion);
+                    Bot::Card c = NM::card(__builtin_ctz(match));
+                    for (auto n : { &notes, &reference }) {
+                        (*n)[player][c].seen = true;
+                        (*n)[o][c].has = true;
+                    }
+                }
+
+                deduce({ &incremental, &constraint }, log, notes, order);
+                deduce({ &other }, log, reference, order);
+
+                for (size_t i = 0; i < order.size(); i++) {
+                    Bot::Player o = order[i];
+                    NM::CardMask has = notes.cards(o, NM::HAS);
+                    NM::CardMask lacks = notes.cards(o, NM::LACKS);
+                    NM::CardMask refHas = reference.cards(o, NM::HAS);
+                    NM::CardMask refLacks = reference.cards(o, NM::LACKS);
+
+                    REQUIRE((refHas & ~has) == 0);
+                    REQUIRE((refLacks & ~lacks) == 0);
+
+                    REQUIRE((has & lacks) == 0);
+
+                    // nothing may contradict the actual deal
+                    if (o != player) {
+                        REQUIRE((has & ~deal.mask(i)) == 0);
+                        REQUIRE((lacks & deal.mask(i)) == 0);
+                    }
+                    REQUIRE((has & envelope) == 0);
+
+                    if ((has != refHas) || (lacks != refLacks))
+                        more++;
+                }
+            }
+
+            // running it again without anything new must not find anything
+            REQUIRE_FALSE(constraint.run(log, notes));
+        }
+
+        REQUIRE(more > 0);
+    }
+
+    SECTION("combines a show with the hand size") {
+        // six players hold three cards each, so once PLUM is known to have two cards and lack
+        // MUSTARD, the show of PLUM, ROPE or KITCHEN must have been ROPE or KITCHEN and PLUM
+        // lacks everything else
+        std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+            Bot::MUSTARD, Bot::WHITE };
+
+        NM notes;
+        Bot::SuggestionLog log;
+        notes[Bot::PLUM][Bot::SCARLET].has = true;
+        notes[Bot::PLUM][Bot::SPANNER].has = true;
+        notes[Bot::PLUM][Bot::MUSTARD].lacks = true;
+
+        log.addSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::MUSTARD, Bot::ROPE, Bot::KITCHEN));
+        log.addShow(Bot::PLUM);
+
+        ConstraintDeductor deductor(Bot::SCARLET, order);
+        REQUIRE(deductor.run(log, notes));
+        REQUIRE(notes.cards(Bot::PLUM, NM::LACKS) ==
+                (NM::ALL_CARDS & ~NM::mask(Bot::Card(Bot::SCARLET)) & ~NM::mask(Bot::SPANNER) &
+                 ~NM::mask(Bot::ROPE) & ~NM::mask(Bot::KITCHEN)));
+
+        // a no-show from everyone else then leaves only PLUM to have ROPE
+        log.addSuggestion(Bot::PEACOCK, Bot::Suggestion(Bot::PEACOCK, Bot::ROPE, Bot::GARAGE));
+        log.addShow(Bot::PLUM);
+        REQUIRE(deductor.run(log, notes));
+        REQUIRE(notes[Bot::PLUM][Bot::ROPE].has);
+        REQUIRE(notes[Bot::PLUM][Bot::ROPE].deduced);
+        REQUIRE(notes[Bot::PLUM][Bot::KITCHEN].lacks);
+    }
+
+    SECTION("contradicting notes") {
+        std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+
+        NM notes;
+        Bot::SuggestionLog log;
+
+        // PLUM can't have shown anything if they lack all three cards
+        notes[Bot::PLUM][Bot::MUSTARD].lacks = true;
+        notes[Bot::PLUM][Bot::ROPE].lacks = true;
+        notes[Bot::PLUM][Bot::KITCHEN].lacks = true;
+        log.addSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::MUSTARD, Bot::ROPE, Bot::KITCHEN));
+        log.addShow(Bot::PLUM);
+
+        NM before = notes;
+        ConstraintDeductor deductor(Bot::SCARLET, order);
+        REQUIRE_FALSE(deductor.run(log, notes));
+        REQUIRE(notes == before);
+    }
+}
+
+// vim: set expandtab textwidth=100:
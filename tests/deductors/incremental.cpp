@@ -0,0 +1,108 @@
+#include <catch/catch.hpp>
+#include <algorithm>
+#include "../../include/deductors/incremental.h"
+#include "../../include/tests.h"
+
+using namespace AI;
+
+namespace {
+    /**
+     * \brief Runs the four separate deductors the same way the bot used to, until nothing changes
+     */
+    void fullRescan(const Bot::SuggestionLog& log, Bot::NotesMatrix& notes, Bot::Player player,
+            std::vector<Bot::Player> order)
+    {
+        LocalExcludeDeductor localExclude(player);
+        NoShowDeductor noShow(player, order);
+        SeenDeductor seen(player);
+        CardCountExcludeDeductor cardCount(player, order);
+
+        std::vector<Deductor*> deductors = { &localExclude, &noShow, &seen, &cardCount };
+
+        auto markLacking = [&]() {
+            for (auto p : order)
+                for (auto o : order)
+                    if (o != p)
+                        notes.set(o, notes.cards(p, Bot::NotesMatrix::HAS),
+                                Bot::NotesMatrix::LACKS);
+        };
+
+        markLacking();
+
+        bool made;
+        do {
+            made = false;
+            for (auto d : deductors)
+                if (d->run(log, notes))
+                    made = true;
+
+            if (made)
+                markLacking();
+        } while (made);
+    }
+}
+
+TEST_CASE("IncrementalDeductor class", "[incremental-deductor]") {
+    Random rng(3);
+
+    for (int game = 0; game < 50; game++) {
+        std::vector<Bot::Player> order;
+        for (int i = 0; i <= int(Bot::MAX_PLAYER); i++)
+            order.push_back(Bot::Player(i));
+        std::shuffle(order.begin(), order.end(), rng);
+        order.resize(3 + rng() % 4);
+
+        Bot::Player player = order[0];
+        Deal deal(order, rng);
+
+        Bot::NotesMatrix notes;
+        deal.note(0, notes);
+
+        // reference runs the old deductors after every event, base doesn't have any deductions
+        Bot::NotesMatrix reference = notes;
+        Bot::NotesMatrix base = notes;
+        Bot::SuggestionLog log;
+        IncrementalDeductor deductor(player, order);
+
+        for (int turn = 0; turn < 40; turn++) {
+            int from = rng() % order.size();
+            int show = deal.suggest(from, rng, log);
+
+            // we get to see the card if we made the suggestion
+            if ((from == 0) && (show >= 0)) {
+                Bot::Player o = order[show];
+                Bot::NotesMatrix::CardMask match = deal.mask(show) &
+                    Bot::NotesMatrix::mask(log.log().back().suggestion);
+                Bot::Card c = Bot::NotesMatrix::card(__builtin_ctz(match));
+                for (auto n : { &notes, &reference, &base }) {
+                    (*n)[player][c].seen = true;
+                    (*n)[o][c].has = true;
+                }
+            }
+
+            while (deductor.run(log, notes)) {}
+            fullRescan(log, reference, player, order);
+        }
+
+        REQUIRE(notes == reference);
+
+        // nothing in the notes may contradict the actual hands
+        for (size_t i = 0; i < order.size(); i++) {
+            REQUIRE((notes.cards(order[i], Bot::NotesMatrix::HAS) & ~deal.mask(i)) == 0);
+            REQUIRE((notes.cards(order[i], Bot::NotesMatrix::LACKS) & deal.mask(i)) == 0);
+        }
+
+        // running it again without anything new must not find anything
+        REQUIRE_FALSE(deductor.run(log, notes));
+
+        // a fresh deductor must get to the same result as the old deductors in a single run
+        Bot::NotesMatrix batch = base;
+        fullRescan(log, batch, player, order);
+
+        IncrementalDeductor other(player, order);
+        REQUIRE(other.run(log, base));
+        REQUIRE(base == batch);
+    }
+}
+
+// vim: set expandtab textwidth=100:
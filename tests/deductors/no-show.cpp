@@ -4,7 +4,7 @@
 using namespace AI;
 
 TEST_CASE("NoShowDeductor", "[no-show-deductor]") {
-    std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes;
+    Bot::NotesMatrix notes;
     Bot::SuggestionLog log;
 
     std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN };
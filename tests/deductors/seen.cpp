@@ -4,7 +4,7 @@
 using namespace AI;
 
 TEST_CASE("SeenDeductor", "[seen-deductor]") {
-    std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes;
+    Bot::NotesMatrix notes;
     Bot::SuggestionLog log;
 
     Bot::Player askPlayer = Bot::SCARLET;
@@ -0,0 +1,193 @@
+#include <catch/catch.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include "../include/host.h"
+
+using namespace AI;
+
+TEST_CASE("BotHost class", "[host]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+
+    REQUIRE_THROWS_AS(BotHost(-1), std::invalid_argument&);
+
+    BotHost host(3);
+    REQUIRE(host.threads() == 3);
+
+    SECTION("hosted bots play like bots that are called directly") {
+        Bot direct(Bot::PLUM, order, 3);
+        BotHost::Handle hosted = host.add(Bot::PLUM, order, 3);
+        REQUIRE(host.size() == 1);
+
+        direct.setCards({ Bot::SCARLET, Bot::KNIFE, Bot::STUDY, Bot::ROPE });
+        direct.updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 60 } });
+        direct.madeSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::WHITE, Bot::ROPE, Bot::KITCHEN));
+        direct.otherShownCard(Bot::PLUM);
+        direct.newTurn();
+        direct.madeSuggestion(Bot::PEACOCK, Bot::Suggestion(Bot::GREEN, Bot::SPANNER, Bot::STUDY));
+        direct.noOtherShownCard();
+        direct.newTurn();
+
+        host.setCards(hosted, { Bot::SCARLET, Bot::KNIFE, Bot::STUDY, Bot::ROPE });
+        host.updateBoard(hosted, { { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 60 } });
+        host.madeSuggestion(hosted, Bot::SCARLET,
+                Bot::Suggestion(Bot::WHITE, Bot::ROPE, Bot::KITCHEN));
+        host.otherShownCard(hosted, Bot::PLUM);
+        host.newTurn(hosted);
+        host.madeSuggestion(hosted, Bot::PEACOCK,
+                Bot::Suggestion(Bot::GREEN, Bot::SPANNER, Bot::STUDY));
+        host.noOtherShownCard(hosted);
+        host.newTurn(hosted);
+
+        // queries are answered after all the events that were queued before them
+        std::vector<std::future<int>> moves;
+        for (int roll = 2; roll <= 12; roll++)
+            moves.push_back(host.getMove(hosted, roll));
+        for (int roll = 2; roll <= 12; roll++)
+            REQUIRE(moves[roll - 2].get() == direct.getMove(roll));
+
+        direct.movePlayer(Bot::PLUM, 4);
+        host.movePlayer(hosted, Bot::PLUM, 4);
+        REQUIRE(host.getSuggestion(hosted).get() == direct.getSuggestion());
+        REQUIRE(host.getCard(hosted, Bot::PEACOCK, { Bot::KNIFE, Bot::ROPE }).get() ==
+                direct.getCard(Bot::PEACOCK, { Bot::KNIFE, Bot::ROPE }));
+
+        auto notes = host.call<Bot::NotesMatrix>(hosted, [](Bot& b) { return b.getNotes(); });
+        REQUIRE(notes.get() == direct.getNotes());
+
+        host.remove(hosted);
+        host.wait();
+        REQUIRE(host.size() == 0);
+    }
+
+    SECTION("thinking ahead doesn't change the answers") {
+        host.setThinkAhead(true);
+
+        std::vector<std::unique_ptr<Bot>> direct;
+        std::vector<BotHost::Handle> hosted;
+        for (int i = 0; i < 6; i++) {
+            direct.push_back(std::unique_ptr<Bot>(new Bot(Bot::PEACOCK, order, i)));
+            hosted.push_back(host.add(Bot::PEACOCK, order, i));
+        }
+
+        for (int turn = 0; turn < 3; turn++) {
+            for (int i = 0; i < 6; i++) {
+                std::vector<std::pair<Bot::Player, Position>> board = {
+                    { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 10 + 11 * i + turn }
+                };
+                direct[i]->updateBoard(board);
+                direct[i]->madeSuggestion(Bot::PLUM,
+                        Bot::Suggestion(Bot::GREEN, Bot::ROPE, Bot::KITCHEN));
+                direct[i]->noOtherShownCard();
+                direct[i]->newTurn();
+
+                host.updateBoard(hosted[i], board);
+                host.madeSuggestion(hosted[i], Bot::PLUM,
+                        Bot::Suggestion(Bot::GREEN, Bot::ROPE, Bot::KITCHEN));
+                host.noOtherShownCard(hosted[i]);
+                host.newTurn(hosted[i]);
+            }
+
+            // give the workers some idle time to think in
+            host.wait();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            for (int i = 0; i < 6; i++)
+                for (int roll = 2; roll <= 12; roll += 5)
+                    REQUIRE(host.getMove(hosted[i], roll).get() == direct[i]->getMove(roll));
+        }
+
+        for (auto h : hosted)
+            host.remove(h);
+        host.wait();
+        REQUIRE(host.size() == 0);
+    }
+
+    SECTION("callbacks") {
+        BotHost::Handle hosted = host.add(Bot::SCARLET, order, 1);
+        host.setCards(hosted, { Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+        host.updateBoard(hosted, { { Bot::SCARLET, 20 }, { Bot::PLUM, 30 }, { Bot::PEACOCK, 40 } });
+
+        // a callback runs before the bot's next task, so it can keep playing the bot's turn
+        std::vector<int> seen;
+        host.getMove(hosted, 6, [&](int move) {
+            seen.push_back(move);
+            host.movePlayer(hosted, Bot::SCARLET, move);
+            host.getMove(hosted, 8, [&](int next) { seen.push_back(next); });
+        });
+        host.wait();
+
+        REQUIRE(seen.size() == 2);
+    }
+
+    SECTION("errors") {
+        BotHost::Handle hosted = host.add(Bot::SCARLET, order, 1);
+        host.updateBoard(hosted, { { Bot::SCARLET, 20 }, { Bot::PLUM, 30 }, { Bot::PEACOCK, 40 } });
+
+        // the handler runs on a worker thread, so it only keeps what it was given
+        std::vector<std::pair<BotHost::Handle, std::exception_ptr>> errors;
+        host.setErrorHandler([&](BotHost::Handle h, std::exception_ptr e) {
+            errors.push_back({ h, e });
+        });
+
+        // the bot isn't in a room, so it can't make a suggestion
+        REQUIRE_THROWS_AS(host.getSuggestion(hosted).get(), std::runtime_error&);
+
+        bool called = false;
+        host.getSuggestion(hosted, [&](Bot::Suggestion) { called = true; });
+        host.wait();
+        REQUIRE(!called);
+        REQUIRE(errors.size() == 1);
+        REQUIRE(errors[0].first == hosted);
+        REQUIRE_THROWS_AS(std::rethrow_exception(errors[0].second), std::runtime_error&);
+
+        // the bot carries on after an error
+        REQUIRE(host.getMove(hosted, 6).get() >= 0);
+    }
+
+    SECTION("tasks of a bot run one at a time in order") {
+        const int threads = 4;
+        const int tasks = 2000;
+
+        std::vector<BotHost::Handle> bots;
+        for (int i = 0; i < 8; i++)
+            bots.push_back(host.add(Bot::SCARLET, order, i));
+
+        // only touched by the tasks of each bot, so a plain int is enough if they never overlap
+        std::vector<std::vector<int>> last(bots.size(), std::vector<int>(threads, -1));
+        std::vector<std::atomic<int>> running(bots.size());
+        std::atomic<int> wrong(0);
+
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++) {
+            pool.push_back(std::thread([&, t]() {
+                for (int i = 0; i < tasks; i++) {
+                    int b = i % bots.size();
+                    host.post(bots[b], [&, b, t, i](Bot&) {
+                        if (running[b]++ || (last[b][t] >= i))
+                            wrong++;
+                        last[b][t] = i;
+                        running[b]--;
+                    });
+                }
+            }));
+        }
+        for (auto& t : pool)
+            t.join();
+        host.wait();
+
+        REQUIRE(wrong == 0);
+        for (auto& l : last)
+            for (int i : l)
+                REQUIRE(i >= tasks - int(bots.size()));
+
+        for (auto b : bots)
+            host.remove(b);
+        host.wait();
+        REQUIRE(host.size() == 0);
+    }
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,164 @@
+#include <catch/catch.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/macros.h"
+
+using namespace AI;
+
+TEST_CASE("LogicLog class", "[logic-log]") {
+    // forget everything the other tests logged
+    LogicLog::readFromLast();
+
+    SECTION("lines are read in order") {
+        for (int i = 0; i < 10; i++)
+            LogicLog::addLog(std::to_string(i));
+
+        auto lines = LogicLog::readFromLast();
+        REQUIRE(lines.size() == 10);
+        for (int i = 0; i < 10; i++)
+            REQUIRE(lines[i] == std::to_string(i));
+
+        // only the new lines are read the next time
+        LogicLog::addLog("next");
+        lines = LogicLog::readFromLast();
+        REQUIRE(lines.size() == 1);
+        REQUIRE(lines[0] == "next");
+        REQUIRE(LogicLog::readFromLast().empty());
+
+        // while the full log still has them all
+        lines = LogicLog::readFull();
+        REQUIRE(lines.size() >= 11);
+        REQUIRE(lines.back() == "next");
+    }
+
+    SECTION("only the last lines are kept") {
+        for (int i = 0; i < LogicLog::CAPACITY + 10; i++)
+            LogicLog::addLog(std::to_string(i));
+
+        auto lines = LogicLog::readFromLast();
+        REQUIRE(lines.size() == size_t(LogicLog::CAPACITY));
+        REQUIRE(lines.front() == "10");
+        REQUIRE(lines.back() == std::to_string(LogicLog::CAPACITY + 9));
+    }
+
+    SECTION("long lines are cut off") {
+        LogicLog::addLog(std::string(LogicLog::LINE_LENGTH + 10, 'x'));
+        LogicLog::addLog(std::string(13, 'y'));
+
+        auto lines = LogicLog::readFromLast();
+        REQUIRE(lines.size() == 2);
+        REQUIRE(lines[0] == std::string(LogicLog::LINE_LENGTH, 'x'));
+        REQUIRE(lines[1] == std::string(13, 'y'));
+    }
+
+    SECTION("lines from many threads are merged") {
+        const int threads = 4;
+        const int count = 200;
+
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++)
+            pool.push_back(std::thread([=]() {
+                for (int i = 0; i < count; i++)
+                    LogicLog::addLog(std::to_string(t) + ":" + std::to_string(i));
+            }));
+        for (auto& t : pool)
+            t.join();
+
+        auto lines = LogicLog::readFromLast();
+        REQUIRE(lines.size() == size_t(threads * count));
+
+        // the lines of every thread are in the order they were added
+        std::vector<int> next(threads, 0);
+        for (auto& line : lines) {
+            int t = std::stoi(line.substr(0, line.find(':')));
+            REQUIRE(line == std::to_string(t) + ":" + std::to_string(next[t]));
+            next[t]++;
+        }
+    }
+
+    SECTION("lines that are being written aren't skipped") {
+        const int threads = 4;
+        const int count = 500;
+
+        // the threads stay until they are all done, so that none of them takes over the ring
+        // buffer of another
+        std::atomic<int> running(threads);
+        std::atomic<bool> done(false);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++)
+            pool.push_back(std::thread([=, &running, &done]() {
+                for (int i = 0; i < count; i++)
+                    LogicLog::addLog(std::to_string(t) + ":" + std::to_string(i));
+                running--;
+                while (!done.load())
+                    std::this_thread::yield();
+            }));
+
+        // read while the lines are added, every line is returned exactly once
+        std::vector<std::string> lines;
+        while (running.load()) {
+            auto read = LogicLog::readFromLast();
+            lines.insert(lines.end(), read.begin(), read.end());
+        }
+        done = true;
+        for (auto& t : pool)
+            t.join();
+
+        auto read = LogicLog::readFromLast();
+        lines.insert(lines.end(), read.begin(), read.end());
+        REQUIRE(lines.size() == size_t(threads * count));
+
+        std::vector<int> next(threads, 0);
+        for (auto& line : lines) {
+            int t = std::stoi(line.substr(0, line.find(':')));
+            REQUIRE(line == std::to_string(t) + ":" + std::to_string(next[t]));
+            next[t]++;
+        }
+    }
+}
+
+TEST_CASE("LogSink class", "[log-sink]") {
+    SECTION("lines are read in order") {
+        LogSink sink;
+        REQUIRE(sink.getLevel() == LogSink::LOGIC);
+
+        sink.add(LogSink::INFO, "first");
+        sink.add(LogSink::LOGIC, "second");
+
+        auto lines = sink.readFromLast();
+        REQUIRE(lines == std::vector<std::string>({ "first", "second" }));
+        REQUIRE(sink.readFromLast().empty());
+
+        sink.add(LogSink::LOGIC, "third");
+        REQUIRE(sink.readFromLast() == std::vector<std::string>({ "third" }));
+        REQUIRE(sink.readFull().size() == 3);
+    }
+
+    SECTION("only the last lines are kept") {
+        LogSink sink(LogSink::LOGIC, 4);
+        for (int i = 0; i < 10; i++)
+            sink.add(LogSink::LOGIC, std::to_string(i));
+
+        REQUIRE(sink.readFromLast() == std::vector<std::string>({ "6", "7", "8", "9" }));
+    }
+
+    SECTION("levels") {
+        LogSink sink(LogSink::INFO);
+        REQUIRE(sink.enabled(LogSink::INFO));
+        REQUIRE_FALSE(sink.enabled(LogSink::LOGIC));
+
+        sink.setLevel(LogSink::OFF);
+        REQUIRE_FALSE(sink.enabled(LogSink::INFO));
+        REQUIRE_FALSE(LogSink::wants(&sink, LogSink::INFO));
+
+        // without a sink the lines go to the LogicLog
+        REQUIRE(LogSink::wants(nullptr, LogSink::LOGIC));
+        LogicLog::readFromLast();
+        LogSink::write(nullptr, LogSink::LOGIC, "to the logic log");
+        REQUIRE(LogicLog::readFromLast() == std::vector<std::string>({ "to the logic log" }));
+    }
+}
+
+// vim: set expandtab textwidth=100:
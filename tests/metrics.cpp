@@ -0,0 +1,98 @@
+#include <catch/catch.hpp>
+#include <sstream>
+#include <string>
+#include "../include/metrics.h"
+#include "../include/bot.h"
+
+using namespace AI;
+
+TEST_CASE("Metrics class", "[metrics]") {
+    Metrics metrics;
+    REQUIRE(metrics.empty());
+
+    SECTION("histograms") {
+        Metrics::Histogram& h = metrics.timers[Metrics::GET_MOVE];
+        for (int i = 0; i < 98; i++)
+            h.add(1000);
+        h.add(100000);
+        h.add(0);
+
+        REQUIRE(h.calls == 100);
+        REQUIRE(h.totalNs == 98 * 1000 + 100000);
+        REQUIRE(h.maxNs == 100000);
+
+        // 1000ns is in the bucket from 512 to 1024
+        REQUIRE(h.percentile(0.5) == 1024);
+        REQUIRE(h.percentile(0.99) == 1024);
+        REQUIRE(h.percentile(1) == 100000);
+        REQUIRE(Metrics::Histogram().percentile(0.5) == 0);
+    }
+
+    SECTION("merge and print") {
+        metrics.timers[Metrics::NOTES_HOOK].add(2000);
+        metrics.counters[Metrics::PATH_NODES] = 5;
+
+        Metrics other;
+        other.timers[Metrics::NOTES_HOOK].add(4000);
+        other.counters[Metrics::PATH_NODES] = 7;
+        metrics.merge(other);
+
+        REQUIRE(metrics.timers[Metrics::NOTES_HOOK].calls == 2);
+        REQUIRE(metrics.timers[Metrics::NOTES_HOOK].maxNs == 4000);
+        REQUIRE(metrics.counters[Metrics::PATH_NODES] == 12);
+
+        std::ostringstream out;
+        metrics.print(out);
+        REQUIRE(out.str() == "notesHook calls=2 mean_us=3 p50_us=2.048 p99_us=4 max_us=4\n"
+                "pathNodes count=12\n");
+    }
+
+    SECTION("current metrics") {
+        REQUIRE(Metrics::current() == nullptr);
+
+        // without current metrics nothing is counted
+        Metrics::count(Metrics::PATH_CALLS);
+
+        {
+            Metrics::Scope scope(Metrics::GET_CARD, &metrics);
+            REQUIRE(Metrics::current() == &metrics);
+            Metrics::count(Metrics::PATH_CALLS, 3);
+
+            {
+                Metrics::Scope inner(Metrics::SEEN_PREDICTOR);
+                Metrics::count(Metrics::PATH_CALLS);
+            }
+            REQUIRE(Metrics::current() == &metrics);
+        }
+
+        REQUIRE(Metrics::current() == nullptr);
+        REQUIRE(metrics.counters[Metrics::PATH_CALLS] == 4);
+        REQUIRE(metrics.timers[Metrics::GET_CARD].calls == 1);
+        REQUIRE(metrics.timers[Metrics::SEEN_PREDICTOR].calls == 1);
+    }
+
+    SECTION("bot metrics") {
+        std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+        Bot bot(Bot::SCARLET, order, 1);
+        bot.setCards({ Bot::PLUM, Bot::KNIFE, Bot::STUDY });
+        bot.updateBoard({ { Bot::SCARLET, 20 }, { Bot::PLUM, 30 }, { Bot::PEACOCK, 40 } });
+        bot.madeSuggestion(Bot::PLUM, Bot::Suggestion(Bot::GREEN, Bot::ROPE, Bot::KITCHEN));
+        bot.noOtherShownCard();
+        bot.getMove(6);
+
+        Metrics m = bot.getMetrics();
+
+#ifdef METRICS
+        REQUIRE(m.timers[Metrics::GET_MOVE].calls == 1);
+        REQUIRE(m.timers[Metrics::NOTES_HOOK].calls >= 2);
+        REQUIRE(m.timers[Metrics::PROBABILITY_PREDICTOR].calls >= 1);
+        REQUIRE(m.counters[Metrics::DEDUCTOR_RUNS] == m.timers[Metrics::NOTES_HOOK].calls);
+        REQUIRE(m.counters[Metrics::DEDUCTOR_ITERATIONS] >= m.counters[Metrics::DEDUCTOR_RUNS]);
+        REQUIRE(m.counters[Metrics::NO_SHOW_FACTS] >= 3);
+#else
+        REQUIRE(m.empty());
+#endif
+    }
+}
+
+// vim: set expandtab textwidth=100:
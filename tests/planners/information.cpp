@@ -0,0 +1,82 @@
+#include <catch/catch.hpp>
+#include "../../include/planners/information.h"
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+}
+
+TEST_CASE("InformationPlanner class", "[information-planner]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+
+    // SCARLET has six cards, the rest are unknown
+    NM notes;
+    Bot::SuggestionLog log;
+    notes.set(Bot::SCARLET, NM::ALL_CARDS, NM::LACKS);
+    for (auto c : { Bot::Card(Bot::PLUM), Bot::Card(Bot::WHITE), Bot::Card(Bot::ROPE),
+            Bot::Card(Bot::KNIFE), Bot::Card(Bot::KITCHEN), Bot::Card(Bot::STUDY) }) {
+        notes[Bot::SCARLET][c].lacks = false;
+        notes[Bot::SCARLET][c].has = true;
+    }
+
+    ParticleOptions options;
+    options.particles = 2000;
+
+    SECTION("gains") {
+        InformationPlanner planner(Bot::SCARLET, order, 0, options, 1);
+        REQUIRE(planner.update(notes, log));
+        REQUIRE(planner.entropy() > 0);
+
+        // nobody else can show any of our own cards, so the answer tells us nothing
+        REQUIRE(planner.gain(Bot::Suggestion(Bot::PLUM, Bot::ROPE, Bot::KITCHEN)) ==
+                Approx(0).margin(1e-9));
+
+        for (int p = 0; p <= int(Bot::MAX_PLAYER); p++) {
+            for (int w = 0; w <= int(Bot::MAX_WEAPON); w++) {
+                double g = planner.gain(Bot::Suggestion(Bot::Player(p), Bot::Weapon(w),
+                            Bot::GARAGE));
+                REQUIRE(g >= 0);
+                REQUIRE(g <= planner.entropy() + 1e-9);
+            }
+        }
+    }
+
+    SECTION("plan chooses the largest gain") {
+        InformationPlanner planner(Bot::SCARLET, order, 0, options, 2);
+        Bot::Suggestion sug(Bot::SCARLET, Bot::CANDLESTICK, Bot::BEDROOM);
+
+        REQUIRE(planner.plan(Bot::GARAGE, notes, log, sug));
+        REQUIRE(planner.evaluated() == (int(Bot::MAX_PLAYER) + 1) * (int(Bot::MAX_WEAPON) + 1));
+        REQUIRE(sug.room == Bot::GARAGE);
+
+        double best = planner.gain(sug);
+        for (int p = 0; p <= int(Bot::MAX_PLAYER); p++)
+            for (int w = 0; w <= int(Bot::MAX_WEAPON); w++)
+                REQUIRE(best >= planner.gain(Bot::Suggestion(Bot::Player(p), Bot::Weapon(w),
+                                Bot::GARAGE)));
+    }
+
+    SECTION("budget") {
+        InformationPlanner planner(Bot::SCARLET, order, 1, options, 3);
+        Bot::Suggestion sug(Bot::SCARLET, Bot::CANDLESTICK, Bot::BEDROOM);
+
+        // at least one candidate is always evaluated
+        REQUIRE(planner.plan(Bot::GARAGE, notes, log, sug));
+        REQUIRE(planner.evaluated() >= 1);
+        REQUIRE(sug.room == Bot::GARAGE);
+    }
+
+    SECTION("contradicting notes") {
+        InformationPlanner planner(Bot::SCARLET, order, 0, options, 4);
+        Bot::Suggestion sug(Bot::SCARLET, Bot::CANDLESTICK, Bot::BEDROOM);
+
+        notes[Bot::PLUM][Bot::GREEN].has = true;
+        notes[Bot::PLUM][Bot::GREEN].lacks = true;
+
+        REQUIRE_FALSE(planner.plan(Bot::GARAGE, notes, log, sug));
+        REQUIRE(sug == Bot::Suggestion(Bot::SCARLET, Bot::CANDLESTICK, Bot::BEDROOM));
+    }
+}
+
+// vim: set expandtab textwidth=100:
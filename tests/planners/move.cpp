@@ -0,0 +1,51 @@
+#include <catch/catch.hpp>
+#include <algorithm>
+#include <cmath>
+#include "../../include/planners/move.h"
+
+using namespace AI;
+
+TEST_CASE("MovePlanner class", "[move-planner]") {
+    MovePlanner planner;
+
+    for (int start : { 0, 3, 7, 30, 70 }) {
+        // the closest room that isn't the start, and the room furthest from it
+        int near = -1;
+        int far = -1;
+        for (int room = 1; room < Board::ROOM_COUNT; room++) {
+            if (room == start)
+                continue;
+            int d = Position(start).distance(room);
+            if ((near == -1) || (d < Position(start).distance(near)))
+                near = room;
+            if ((far == -1) || (d > Position(start).distance(far)))
+                far = room;
+        }
+
+        // a secret passage is free, but a dice roll is at least two
+        int roll = std::max(2, Position(start).distance(near));
+        int turns = (Position(start).distance(far) - roll + MovePlanner::AVERAGE_ROLL - 1) /
+            MovePlanner::AVERAGE_ROLL;
+        REQUIRE(turns > 0);
+
+        double values[Board::ROOM_COUNT] = {};
+        REQUIRE(planner.plan(start, roll, values) == start);
+
+        // a room that can be reached is worth its full value
+        values[near] = 1;
+        REQUIRE(planner.plan(start, roll, values) == near);
+
+        // the room further away only wins if it is worth enough more to make up for the turns
+        values[far] = 0.9 / std::pow(MovePlanner::DISCOUNT, turns);
+        REQUIRE(planner.plan(start, roll, values) == near);
+
+        values[far] = 1.1 / std::pow(MovePlanner::DISCOUNT, turns);
+        REQUIRE(planner.plan(start, roll, values) == Position(start).path(far).partial(roll));
+
+        // the middle room is never chosen
+        values[0] = 100;
+        REQUIRE(planner.plan(start, roll, values) != 0);
+    }
+}
+
+// vim: set expandtab textwidth=100:
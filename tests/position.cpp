@@ -1,5 +1,6 @@
 #include <catch/catch.hpp>
 #include <stdexcept>
+#include <vector>
 #include "../include/position.h"
 #include "../include/board.h"
 
@@ -72,11 +73,17 @@ TEST_CASE("Path struct", "[path]") {
     }
 }
 
+std::vector<int> neighbours(Position pos)
+{
+    auto ngh = pos.getNeighbours();
+    return std::vector<int>(ngh.begin(), ngh.end());
+}
+
 void validatePath(Position::Path path, std::vector<bool> occupied = std::vector<bool>())
 {
     auto p = path.getPath();
     for (size_t i = 0; i < p.size() - 1; i++) {
-        REQUIRE_THAT(Board::board[p[i]], VectorContains(p[i+1]));
+        REQUIRE_THAT(neighbours(Position(p[i])), VectorContains(p[i+1]));
         if (!occupied.empty())
             REQUIRE_FALSE(occupied[p[i+1]]);
     }
@@ -91,9 +98,9 @@ TEST_CASE("Position class", "[position]") {
         REQUIRE_THROWS_AS(Position(-1), std::invalid_argument&);
         REQUIRE_THROWS_AS(Position(83), std::invalid_argument&);
 
-        REQUIRE_THAT(Position(0).getNeighbours(), Equals(Board::board[0]));
-        REQUIRE_THAT(Position(20).getNeighbours(), Equals(Board::board[20]));
-        REQUIRE_THAT(Position(50).getNeighbours(), Equals(Board::board[50]));
+        REQUIRE_THAT(neighbours(Position(0)), Equals(std::vector<int>{ 20, 37, 68, 36 }));
+        REQUIRE_THAT(neighbours(Position(20)), Equals(std::vector<int>{ 19, 21, 0 }));
+        REQUIRE_THAT(neighbours(Position(50)), Equals(std::vector<int>{ 49, 40, 60, 1 }));
 
         REQUIRE(int(Position(10)) == 10);
 
@@ -180,6 +187,23 @@ TEST_CASE("Position class", "[position]") {
             REQUIRE(int(Position(3).path(10, 3)) == 7);
         }
 
+        SECTION("room limit") {
+            // every room passed through uses up a turn
+            for (int turns = 1; turns <= 3; turns++) {
+                for (int s = 0; s < Board::BOARD_SIZE; s++) {
+                    for (int d = 0; d < Board::BOARD_SIZE; d++) {
+                        auto p = Position(s).path(d, turns).getPath();
+                        int rooms = 0;
+                        for (size_t i = 1; i + 1 < p.size(); i++)
+                            if (p[i] < Board::ROOM_COUNT)
+                                rooms++;
+                        REQUIRE(rooms < turns);
+                        REQUIRE(int(Position(s).path(d, turns)) <= int(Position(s).path(d)));
+                    }
+                }
+            }
+        }
+
         SECTION("middle room") {
             // never use as shortcut (even with multiple turns)
             REQUIRE(int(Position(36).path(37, 2)) > 2);
@@ -189,6 +213,135 @@ TEST_CASE("Position class", "[position]") {
             REQUIRE(int(Position(20).path(0)) == 1);
         }
 
+        SECTION("empty board table") {
+            // the looked up paths must be exactly what a search would find
+            std::vector<bool> occupied(Board::BOARD_SIZE, false);
+            for (int s = 0; s < Board::BOARD_SIZE; s++) {
+                for (int d = 0; d < Board::BOARD_SIZE; d++) {
+                    Position::Path searched = Position(s).path(d, occupied, 1);
+                    REQUIRE_THAT(Position(s).path(d).getPath(), Equals(searched.getPath()));
+                    REQUIRE(Position(s).distance(d) == int(searched));
+                }
+            }
+        }
+
+        SECTION("same as the recursive search") {
+            // what the recursive search path() used to do found: paths through secret passages,
+            // around blocked tiles and through rooms with more turns (where it kept to the room
+            // limit), and where they get to in 1, 4 and 12 moves
+            struct Expected {
+                bool blocked;
+                int turns, from, to, distance;
+                std::vector<int> path, partial;
+            };
+
+            std::vector<Expected> expected = {
+                { false, 1, 2, 7, 0, { 2, 7 }, { 7, 7, 7 } },
+                { false, 1, 7, 8, 0, { 7, 8 }, { 8, 8, 8 } },
+                { false, 1, 4, 9, 0, { 4, 9 }, { 9, 9, 9 } },
+                { false, 1, 0, 1, 5, { 0, 37, 38, 39, 40, 1 }, { 37, 40, 1 } },
+                { false, 1, 0, 2, 7, { 0, 68, 69, 70, 71, 72, 82, 2 }, { 68, 71, 2 } },
+                { false, 1, 3, 10, 13, { 3, 78, 77, 76, 75, 65, 55, 45, 44, 43, 33, 25, 15, 10 },
+                    { 78, 75, 15 } },
+                { false, 1, 20, 0, 1, { 20, 0 }, { 0, 0, 0 } },
+                { false, 1, 11, 60, 14, { 11, 16, 17, 18, 19, 20, 21, 22, 23, 24, 31, 32, 40, 50,
+                    60 }, { 16, 19, 40 } },
+                { false, 1, 82, 45, 10, { 82, 81, 80, 79, 78, 77, 76, 75, 65, 55, 45 },
+                    { 81, 78, 45 } },
+                { false, 1, 6, 30, 17, { 6, 41, 42, 52, 53, 54, 55, 56, 46, 36, 28, 18, 19, 20, 21,
+                    22, 23, 30 }, { 41, 53, 19 } },
+                { false, 1, 5, 5, 0, { 5 }, { 5, 5, 5 } },
+                { true, 1, 2, 25, 17, { 2, 82, 81, 80, 79, 78, 77, 76, 75, 65, 55, 45, 35, 27, 17,
+                    16, 15, 25 }, { 82, 79, 35 } },
+                { true, 1, 0, 25, 7, { 0, 20, 19, 18, 17, 16, 15, 25 }, { 20, 17, 25 } },
+                { true, 1, 1, 34, 14, { 1, 40, 39, 38, 37, 29, 22, 21, 20, 19, 18, 17, 27, 35, 34 },
+                    { 40, 37, 27 } },
+                { true, 1, 3, 50, 9, { 3, 78, 79, 80, 81, 82, 72, 59, 49, 50 }, { 78, 81, 50 } },
+                { true, 1, 60, 20, 9, { 60, 59, 58, 57, 47, 37, 29, 22, 21, 20 }, { 59, 47, 20 } },
+                { true, 1, 26, 10, 3, { 26, 25, 15, 10 }, { 25, 10, 10 } },
+                { true, 1, 0, 43, -1, {}, {} },
+                { false, 2, 4, 22, 3, { 4, 9, 13, 12, 22 }, { 9, 9, 9 } },
+                { false, 2, 63, 9, 3, { 63, 62, 74, 4, 9 }, { 62, 4, 4 } },
+                { false, 2, 7, 65, 8, { 7, 8, 19, 18, 17, 27, 35, 45, 55, 65 }, { 8, 8, 8 } },
+                { true, 2, 51, 4, 1, { 51, 5, 4 }, { 5, 5, 5 } },
+                { false, 3, 32, 65, 10, { 32, 31, 30, 23, 13, 9, 4, 74, 62, 63, 64, 65 },
+                    { 31, 13, 9 } },
+                { true, 3, 76, 12, 9, { 76, 75, 65, 64, 63, 62, 74, 4, 9, 13, 12 }, { 75, 63, 4 } },
+                { false, 3, 18, 70, 9, { 18, 17, 16, 15, 10, 7, 2, 82, 81, 80, 70 },
+                    { 17, 10, 7 } },
+                { false, 3, 65, 13, 6, { 65, 64, 63, 62, 74, 4, 9, 13 }, { 64, 74, 4 } },
+                { true, 3, 37, 10, 7, { 37, 29, 22, 21, 20, 19, 8, 7, 10 }, { 29, 20, 8 } },
+                { true, 3, 48, 15, 7, { 48, 49, 59, 72, 82, 2, 7, 10, 15 }, { 49, 82, 2 } },
+                { false, 3, 51, 39, 9, { 51, 52, 62, 74, 4, 9, 13, 14, 24, 31, 39 }, { 52, 4, 4 } },
+                { true, 3, 0, 43, -1, {}, {} },
+            };
+
+            std::vector<bool> occupied(Board::BOARD_SIZE, false);
+            std::vector<bool> blocked(Board::BOARD_SIZE, false);
+            for (int pos : { 26, 33, 44, 60 })
+                blocked[pos] = true;
+
+            for (auto& e : expected) {
+                const std::vector<bool>& occ = e.blocked ? blocked : occupied;
+                if (e.distance < 0) {
+                    REQUIRE_THROWS_AS(Position(e.from).path(e.to, occ, e.turns),
+                            std::runtime_error&);
+                    continue;
+                }
+
+                Position::Path p = Position(e.from).path(e.to, occ, e.turns);
+                REQUIRE(int(p) == e.distance);
+                REQUIRE_THAT(p.getPath(), Equals(e.path));
+                REQUIRE(p.partial(1) == e.partial[0]);
+                REQUIRE(p.partial(4) == e.partial[1]);
+                REQUIRE(p.partial(12) == e.partial[2]);
+
+                if (!e.blocked && (e.turns == 1)) {
+                    REQUIRE_THAT(Position(e.from).path(e.to).getPath(), Equals(e.path));
+                    REQUIRE(Position(e.from).distance(e.to) == e.distance);
+                }
+            }
+        }
+
+        SECTION("reach") {
+            // a single search must give the same paths as searching for every destination
+            std::vector<bool> occupied(Board::BOARD_SIZE, false);
+            std::vector<bool> blocked(Board::BOARD_SIZE, false);
+            for (int pos : { 26, 33, 44, 60 })
+                blocked[pos] = true;
+
+            for (auto occ : { occupied, blocked }) {
+                for (int turns = 1; turns <= 3; turns++) {
+                    for (int s = 0; s < Board::BOARD_SIZE; s++) {
+                        Position::Reach reach = Position(s).reach(occ, turns);
+
+                        for (int d = 0; d < Board::BOARD_SIZE; d++) {
+                            Position::Path searched(s);
+                            try {
+                                searched = Position(s).path(d, occ, turns);
+                            } catch (std::runtime_error&) {
+                                REQUIRE_FALSE(reach.reachable(d));
+                                REQUIRE_THROWS_AS(reach.path(d), std::runtime_error&);
+                                continue;
+                            }
+
+                            auto p = searched.getPath();
+                            REQUIRE(reach.reachable(d));
+                            REQUIRE(reach.distance(d) == int(searched));
+                            REQUIRE(reach.next(d) == (p.size() > 1 ? p[1] : s));
+                            REQUIRE_THAT(reach.path(d).getPath(), Equals(p));
+
+                            for (int moves : { 1, 4, 12 })
+                                REQUIRE(reach.partial(d, moves) == searched.partial(moves));
+                        }
+                    }
+                }
+            }
+
+            REQUIRE_THROWS_AS(Position(10).reach(std::vector<bool>()), std::invalid_argument&);
+            REQUIRE_THROWS_AS(Position(10).reach(occupied, 0), std::invalid_argument&);
+        }
+
         SECTION("occupied tiles") {
             std::vector<bool> occupied(Board::BOARD_SIZE, false);
 
@@ -4,7 +4,7 @@
 using namespace AI;
 
 TEST_CASE("MultiplePredictor", "[multiple-predictor]") {
-    std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes;
+    Bot::NotesMatrix notes;
     Bot::SuggestionLog log;
     Deck deck;
     Bot::Player sugPlayer = Bot::SCARLET;
@@ -4,7 +4,7 @@
 using namespace AI;
 
 TEST_CASE("NoShowPredictor", "[no-show-predictor]") {
-    std::map<Bot::Player, std::map<Bot::Card, Bot::Notes>> notes;
+    Bot::NotesMatrix notes;
     Bot::SuggestionLog log;
     Deck deck;
     Bot::Player askPlayer = Bot::SCARLET;
@@ -0,0 +1,111 @@
+#include <catch/catch.hpp>
+#include <algorithm>
+#include "../../include/predictors/particle.h"
+#include "../../include/predictors/probability.h"
+#include "../../include/tests.h"
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+}
+
+TEST_CASE("ParticlePredictor", "[particle-predictor]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+
+    for (auto policy : { ParticleOptions::RESAMPLE, ParticleOptions::REJECT }) {
+        ParticleOptions options;
+        options.particles = 2000;
+        options.policy = policy;
+
+        SECTION("close to the exact probabilities " + std::to_string(policy)) {
+            Random rng(11);
+            ParticlePredictor particles(Bot::SCARLET, order, options, 1);
+            ProbabilityPredictor exact(Bot::SCARLET, order);
+
+            NM notes;
+            Bot::SuggestionLog log;
+            Deal deal(order, rng);
+            deal.note(0, notes);
+            REQUIRE(particles.update(notes, log));
+
+            for (int i = 0; i < 12; i++) {
+                deal.suggest(rng() % order.size(), rng, log);
+                REQUIRE(particles.update(notes, log));
+
+                if (policy == ParticleOptions::RESAMPLE)
+                    REQUIRE(particles.alive() == options.particles);
+                else
+                    REQUIRE(particles.alive() >= options.minAlive * options.particles);
+            }
+
+            REQUIRE(exact.update(notes, log));
+            for (int c = 0; c < NM::CARD_COUNT; c++) {
+                REQUIRE(particles.envelope(NM::card(c)) ==
+                        Approx(exact.envelope(NM::card(c))).margin(0.1));
+                for (auto p : order)
+                    REQUIRE(particles.has(p, NM::card(c)) ==
+                            Approx(exact.has(p, NM::card(c))).margin(0.1));
+            }
+        }
+    }
+
+    SECTION("particles agree with the notes") {
+        Random rng(12);
+        ParticlePredictor particles(Bot::SCARLET, order);
+
+        NM notes;
+        Bot::SuggestionLog log;
+        Deal deal(order, rng);
+        deal.note(0, notes);
+
+        for (int c = 0; c < NM::CARD_COUNT; c += 3)
+            notes.set(Bot::PLUM, NM::card(c), deal.location[c] == 1 ? NM::HAS : NM::LACKS);
+        for (int i = 0; i < 5; i++)
+            deal.suggest(rng() % order.size(), rng, log);
+
+        REQUIRE(particles.update(notes, log));
+        for (int c = 0; c < NM::CARD_COUNT; c++) {
+            for (auto p : order) {
+                if (notes.get(p, NM::card(c), NM::HAS))
+                    REQUIRE(particles.has(p, NM::card(c)) == 1);
+                if (notes.get(p, NM::card(c), NM::LACKS))
+                    REQUIRE(particles.has(p, NM::card(c)) == 0);
+            }
+        }
+    }
+
+    SECTION("scores") {
+        ParticlePredictor particles(Bot::SCARLET, order);
+        NM notes;
+        Bot::SuggestionLog log;
+        Deck deck;
+        deck.players = { Bot::SCARLET, Bot::PLUM };
+
+        // PLUM is in the envelope because nobody has it
+        for (auto p : order)
+            notes[p][Bot::PLUM].lacks = true;
+        notes[Bot::PEACOCK][Bot::SCARLET].has = true;
+
+        particles.run(deck, notes, log);
+        REQUIRE(particles.envelope(Bot::PLUM) == 1);
+        REQUIRE(deck.scores[Bot::PLUM] == 0);
+        REQUIRE(deck.scores[Bot::SCARLET] == ProbabilityPredictor::SCORE_SCALE);
+    }
+
+    SECTION("contradicting notes") {
+        ParticlePredictor particles(Bot::SCARLET, order);
+        NM notes;
+        Bot::SuggestionLog log;
+
+        notes[Bot::PLUM][Bot::SCARLET].has = true;
+        REQUIRE(particles.update(notes, log));
+
+        notes[Bot::PLUM][Bot::SCARLET].lacks = true;
+        REQUIRE_FALSE(particles.update(notes, log));
+        REQUIRE(particles.alive() == 0);
+        REQUIRE(particles.envelope(Bot::SCARLET) == 0);
+    }
+}
+
+// vim: set expandtab textwidth=100:
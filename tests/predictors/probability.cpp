@@ -0,0 +1,259 @@
+#include <catch/catch.hpp>
+#include <algorithm>
+#include <functional>
+#include "../../include/predictors/probability.h"
+#include "../../include/random.h"
+#include "../../include/tests.h"
+
+using namespace AI;
+
+namespace {
+    typedef Bot::NotesMatrix NM;
+
+    struct Counts {
+        double deals = 0;
+        double envelope[NM::CARD_COUNT] = {};
+        double has[NM::PLAYER_COUNT][NM::CARD_COUNT] = {};
+    };
+
+    /**
+     * \brief Counts the deals that agree with the notes and log by trying every deal
+     */
+    Counts bruteForce(const std::vector<Bot::Player>& order, const NM& notes,
+            const Bot::SuggestionLog& log)
+    {
+        const int n = order.size();
+        const int hand = 18 / n;
+
+        Counts counts;
+        std::vector<int> location(NM::CARD_COUNT, -1);
+        std::vector<int> sizes(n + 1, 0);
+
+        auto holds = [&](int loc, const Bot::Suggestion& sug) {
+            for (auto c : { Bot::Card(sug.player), Bot::Card(sug.weapon), Bot::Card(sug.room) })
+                if (location[NM::index(c)] == loc)
+                    return true;
+            return false;
+        };
+
+        auto agrees = [&]() {
+            for (int i = 0; i < n; i++) {
+                for (int c = 0; c < NM::CARD_COUNT; c++) {
+                    if (notes.get(order[i], NM::card(c), NM::HAS) && (location[c] != i))
+                        return false;
+                    if (notes.get(order[i], NM::card(c), NM::LACKS) && (location[c] == i))
+                        return false;
+                }
+            }
+
+            for (const auto& l : log.log()) {
+                int start = std::find(order.begin(), order.end(), l.from) - order.begin();
+                for (int pos = (start + 1) % n; pos != start; pos = (pos + 1) % n) {
+                    if (l.showed && (order[pos] == l.show)) {
+                        if (!holds(pos, l.suggestion))
+                            return false;
+                        break;
+                    }
+                    if (holds(pos, l.suggestion))
+                        return false;
+                }
+            }
+
+            return true;
+        };
+
+        std::function<void(int)> deal = [&](int c) {
+            if (c == NM::CARD_COUNT) {
+                if (!agrees())
+                    return;
+                counts.deals++;
+                for (int i = 0; i < NM::CARD_COUNT; i++) {
+                    if (location[i] == n)
+                        counts.envelope[i]++;
+                    else
+                        counts.has[order[location[i]]][i]++;
+                }
+                return;
+            }
+
+            Bot::Card card = NM::card(c);
+            int owner = -1;
+            for (int i = 0; i < n; i++)
+                if (notes.get(order[i], card, NM::HAS))
+                    owner = i;
+
+            for (int loc = 0; loc <= n; loc++) {
+                if ((owner >= 0) && (loc != owner)) {
+                    continue;
+                } else if (loc == n) {
+                    bool taken = false;
+                    for (int i = 0; i < c; i++)
+                        if ((location[i] == n) && (NM::card(i).type == card.type))
+                            taken = true;
+                    if (taken)
+                        continue;
+                } else if ((sizes[loc] == hand) || notes.get(order[loc], card, NM::LACKS)) {
+                    continue;
+                }
+
+                location[c] = loc;
+                sizes[loc]++;
+                deal(c + 1);
+                sizes[loc]--;
+                location[c] = -1;
+            }
+        };
+
+        deal(0);
+        return counts;
+    }
+
+    /**
+     * \brief Deals the cards at random and plays random suggestions, noting what the first player
+     * would know
+     */
+    void randomGame(Random& rng, const std::vector<Bot::Player>& order, int suggestions,
+            int hints, NM& notes, Bot::SuggestionLog& log)
+    {
+        const int n = order.size();
+
+        Deal deal(order, rng);
+        deal.note(0, notes);
+
+        for (int i = 0; i < hints; i++) {
+            int c = rng() % NM::CARD_COUNT;
+            int p = 1 + rng() % (n - 1);
+            notes.set(order[p], NM::card(c), deal.location[c] == p ? NM::HAS : NM::LACKS);
+        }
+
+        for (int i = 0; i < suggestions; i++)
+            deal.suggest(rng() % n, rng, log);
+    }
+}
+
+TEST_CASE("ProbabilityPredictor", "[probability-predictor]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+    ProbabilityPredictor predictor(Bot::SCARLET, order);
+
+    SECTION("same as counting every deal") {
+        Random rng(3);
+        for (int game = 0; game < 4; game++) {
+            NM notes;
+            Bot::SuggestionLog log;
+            randomGame(rng, order, 8, 6, notes, log);
+
+            REQUIRE(predictor.update(notes, log));
+            Counts counts = bruteForce(order, notes, log);
+
+            REQUIRE(counts.deals > 0);
+            REQUIRE(predictor.deals() == counts.deals);
+            for (int c = 0; c < NM::CARD_COUNT; c++) {
+                REQUIRE(predictor.envelope(NM::card(c)) ==
+                        Approx(counts.envelope[c] / counts.deals));
+                for (auto p : order)
+                    REQUIRE(predictor.has(p, NM::card(c)) ==
+                            Approx(counts.has[p][c] / counts.deals));
+            }
+        }
+    }
+
+    SECTION("probabilities add up") {
+        std::vector<Bot::Player> six = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+            Bot::MUSTARD, Bot::WHITE };
+        ProbabilityPredictor predictor(Bot::SCARLET, six);
+
+        Random rng(5);
+        NM notes;
+        Bot::SuggestionLog log;
+        randomGame(rng, six, 20, 10, notes, log);
+
+        REQUIRE(predictor.update(notes, log));
+
+        for (auto type : { Bot::Card::PLAYER, Bot::Card::WEAPON, Bot::Card::ROOM }) {
+            double sum = 0;
+            for (int c = 0; c < NM::CARD_COUNT; c++)
+                if (NM::card(c).type == type)
+                    sum += predictor.envelope(NM::card(c));
+            REQUIRE(sum == Approx(1));
+        }
+
+        for (int c = 0; c < NM::CARD_COUNT; c++) {
+            double sum = predictor.envelope(NM::card(c));
+            for (auto p : six)
+                sum += predictor.has(p, NM::card(c));
+            REQUIRE(sum == Approx(1));
+        }
+    }
+
+    SECTION("gives up over the budget") {
+        std::vector<Bot::Player> six = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK, Bot::GREEN,
+            Bot::MUSTARD, Bot::WHITE };
+
+        Random rng(7);
+        NM notes;
+        Bot::SuggestionLog log;
+        randomGame(rng, six, 5, 0, notes, log);
+
+        ProbabilityPredictor unbounded(Bot::SCARLET, six);
+        REQUIRE(unbounded.update(notes, log));
+        REQUIRE_FALSE(unbounded.overBudget());
+
+        ProbabilityPredictor bounded(Bot::SCARLET, six, 100);
+        REQUIRE_FALSE(bounded.update(notes, log));
+        REQUIRE(bounded.overBudget());
+        for (int c = 0; c < NM::CARD_COUNT; c++)
+            REQUIRE(bounded.envelope(NM::card(c)) == 0);
+
+        // the cards are left to the other predictors to rank
+        Deck deck;
+        deck.players = { Bot::SCARLET, Bot::PLUM };
+        deck.scores[Bot::PLUM] = 3;
+        bounded.run(deck, notes, log);
+        REQUIRE(deck.scores[Bot::SCARLET] == 0);
+        REQUIRE(deck.scores[Bot::PLUM] == 3);
+
+        // a problem that fits in the budget is still counted
+        std::vector<Bot::Player> three = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+        NM small;
+        Bot::SuggestionLog smallLog;
+        randomGame(rng, three, 30, 10, small, smallLog);
+
+        ProbabilityPredictor generous(Bot::SCARLET, three, 100000);
+        REQUIRE(generous.update(small, smallLog));
+        REQUIRE_FALSE(generous.overBudget());
+    }
+
+    SECTION("scores") {
+        NM notes;
+        Bot::SuggestionLog log;
+        Deck deck;
+        deck.players = { Bot::SCARLET, Bot::PLUM };
+
+        // PLUM is in the envelope because nobody has it
+        for (auto p : order)
+            notes[p][Bot::PLUM].lacks = true;
+        notes[Bot::PEACOCK][Bot::SCARLET].has = true;
+
+        predictor.run(deck, notes, log);
+        REQUIRE(predictor.envelope(Bot::PLUM) == Approx(1));
+        REQUIRE(deck.scores[Bot::PLUM] == 0);
+        REQUIRE(deck.scores[Bot::SCARLET] == ProbabilityPredictor::SCORE_SCALE);
+    }
+
+    SECTION("contradicting notes") {
+        NM notes;
+        Bot::SuggestionLog log;
+        Deck deck;
+        deck.players = { Bot::SCARLET };
+
+        notes[Bot::PLUM][Bot::SCARLET].has = true;
+        notes[Bot::PEACOCK][Bot::SCARLET].has = true;
+
+        predictor.run(deck, notes, log);
+        REQUIRE_FALSE(predictor.update(notes, log));
+        REQUIRE(deck.scores[Bot::SCARLET] == 0);
+        REQUIRE(predictor.envelope(Bot::SCARLET) == 0);
+    }
+}
+
+// vim: set expandtab textwidth=100:
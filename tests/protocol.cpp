@@ -0,0 +1,207 @@
+#include <catch/catch.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../include/protocol.h"
+
+using namespace AI;
+
+namespace {
+    /**
+     * \brief A server that talks to a ProtocolDriver over a local socket
+     *
+     * The driver runs on a thread of its own until the server closes its end of the socket.
+     */
+    class Loopback {
+        public:
+            Loopback()
+            {
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+                    throw std::runtime_error("couldn't create a socket pair");
+
+                driver = std::thread([this]() {
+                    ProtocolDriver d(fds[1], fds[1]);
+                    d.run();
+                });
+            }
+
+            ~Loopback()
+            {
+                shutdown(fds[0], SHUT_WR);
+                driver.join();
+                close(fds[0]);
+                close(fds[1]);
+            }
+
+            void send(const std::string& lines)
+            {
+                size_t sent = 0;
+                while (sent < lines.size()) {
+                    ssize_t w = write(fds[0], lines.data() + sent, lines.size() - sent);
+                    if (w < 0)
+                        throw std::runtime_error("couldn't write to the driver");
+                    sent += w;
+                }
+            }
+
+            /**
+             * \returns the next line the driver wrote, without its newline
+             */
+            std::string receive()
+            {
+                size_t end;
+                while ((end = received.find('\n')) == std::string::npos) {
+                    char buffer[256];
+                    ssize_t r = read(fds[0], buffer, sizeof(buffer));
+                    if (r <= 0)
+                        throw std::runtime_error("the driver stopped answering");
+                    received.append(buffer, r);
+                }
+
+                std::string line = received.substr(0, end);
+                received.erase(0, end + 1);
+                return line;
+            }
+
+        private:
+            int fds[2];
+            std::thread driver;
+            std::string received;
+    };
+}
+
+TEST_CASE("ProtocolDriver class", "[protocol]") {
+    std::vector<Bot::Player> order = { Bot::SCARLET, Bot::PLUM, Bot::PEACOCK };
+    Loopback server;
+
+    SECTION("games are played like bots that are called directly") {
+        Bot plum(Bot::PLUM, order, 3);
+        Bot scarlet(Bot::SCARLET, order, 5);
+
+        plum.setCards({ Bot::SCARLET, Bot::KNIFE, Bot::STUDY, Bot::ROPE });
+        plum.updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 }, { Bot::PEACOCK, 60 } });
+        plum.madeSuggestion(Bot::SCARLET, Bot::Suggestion(Bot::WHITE, Bot::ROPE, Bot::KITCHEN));
+        plum.otherShownCard(Bot::PLUM);
+        plum.newTurn();
+
+        scarlet.setCards({ Bot::GREEN, Bot::LEAD_PIPE, Bot::DINING_ROOM });
+        scarlet.setCards({ Bot::WHITE }, true);
+        scarlet.updateBoard({ { Bot::SCARLET, 20 }, { Bot::PLUM, 30 }, { Bot::PEACOCK, 40 } });
+        scarlet.madeSuggestion(Bot::PEACOCK, Bot::Suggestion(Bot::GREEN, Bot::KNIFE, Bot::STUDY),
+                true);
+        scarlet.noOtherShownCard();
+        scarlet.newTurn();
+
+        // the two games are sent interleaved, in two writes that split a line
+        server.send("7 new Plum Scarlet,Plum,Peacock 3\n"
+                "12 new scarlet Scarlet,Plum,Peacock 5\n"
+                "7 cards Scarlet,Knife,Study,Rope\n"
+                "12 cards Green, Lead Pipe, Dining Room\r\n"
+                "12 table White\n"
+                "7 board Scarlet:4,Plum:20,Peacock:60\n"
+                "12 board Scarlet:20,Plum:30,Peacock:40\n"
+                "7 suggest Scarlet White,Rope,Kitchen\n"
+                "12 accuse Peacock Green,Dagger,Study\n"
+                "7 shown Plum\n"
+                "12 nosh");
+        server.send("own\n"
+                "7 turn\n"
+                "12 turn\n"
+                "7 getmove 6\n"
+                "12 getmove 8\n");
+
+        REQUIRE(server.receive() == "7 move " + std::to_string(plum.getMove(6)));
+        REQUIRE(server.receive() == "12 move " + std::to_string(scarlet.getMove(8)));
+
+        plum.movePlayer(Bot::PLUM, 4);
+        server.send("7 move Plum 4\n7 getsuggestion\n7 getcard Peacock Knife,Rope\n");
+
+        Bot::Suggestion sug = plum.getSuggestion();
+        REQUIRE(server.receive() == "7 suggestion " + Bot::playerToStr(sug.player) + "," +
+                Bot::weaponToStr(sug.weapon) + "," + Bot::roomToStr(sug.room));
+        REQUIRE(server.receive() == "7 card " +
+                plum.getCard(Bot::PEACOCK, { Bot::KNIFE, Bot::ROPE }).str());
+
+        // a game that has ended can be started again
+        server.send("7 end\n7 getmove 6\n7 new Plum Scarlet,Plum,Peacock\n7 getmove 6\n");
+        REQUIRE(server.receive() == "7 error the game hasn't started");
+        REQUIRE(server.receive().substr(0, 7) == "7 move ");
+    }
+
+    SECTION("errors") {
+        server.send("1 new Plum Scarlet,Plum,Peacock 1\n"
+                "hello\n"
+                "2 turn\n"
+                "1 new Plum Scarlet,Plum,Peacock 1\n"
+                "1 dance\n"
+                "1 cards Plum,Spoon\n"
+                "1 move Plum\n"
+                "1 move Plum 400\n"
+                "1 getcard Peacock Knife\n"
+                "1 new Plum Scarlet,Plum 1x\n"
+                "\n"
+                "1 getmove 6\n");
+
+        REQUIRE(server.receive() == "error a line has to start with a game id");
+        REQUIRE(server.receive() == "2 error the game hasn't started");
+        REQUIRE(server.receive() == "1 error the game has already started");
+        REQUIRE(server.receive() == "1 error unknown command \"dance\"");
+        REQUIRE(server.receive() == "1 error \"Spoon\" is not a valid card");
+        REQUIRE(server.receive() == "1 error missing position");
+        REQUIRE(server.receive().substr(0, 8) == "1 error ");
+        REQUIRE(server.receive().substr(0, 8) == "1 error ");
+        REQUIRE(server.receive() == "1 error the game has already started");
+
+        // the game carries on after its errors
+        REQUIRE(server.receive().substr(0, 7) == "1 move ");
+    }
+
+    SECTION("invalid orders") {
+        server.send("1 new scarlet plum,white\n"
+                "2 new scarlet scarlet,scarlet,plum\n"
+                "3 new scarlet plum,white,peacock\n"
+                "3 getmove 6\n"
+                "4 new scarlet plum,scarlet,white\n"
+                "4 getmove 6\n");
+
+        REQUIRE(server.receive() == "1 error the order needs at least 3 players");
+        REQUIRE(server.receive() == "2 error Scarlet is in the order more than once");
+        REQUIRE(server.receive() == "3 error the order doesn't include Scarlet");
+        REQUIRE(server.receive() == "3 error the game hasn't started");
+        REQUIRE(server.receive().substr(0, 7) == "4 move ");
+    }
+
+    SECTION("lines that don't fit in the buffer") {
+        std::string line = "1 cards " + std::string(ProtocolDriver::BUFFER_SIZE, 'x') + "\n";
+        server.send("1 new Plum Scarlet,Plum,Peacock 1\n" + line + "1 getmove 6\n");
+
+        REQUIRE(server.receive() == "error line is too long");
+        REQUIRE(server.receive().substr(0, 7) == "1 move ");
+    }
+
+    SECTION("many games over one connection") {
+        const int games = 50;
+
+        std::string lines;
+        for (int g = 0; g < games; g++) {
+            lines += std::to_string(g) + " new Peacock Scarlet,Plum,Peacock " + std::to_string(g) +
+                "\n" + std::to_string(g) + " board Scarlet:4,Plum:20,Peacock:" +
+                std::to_string(10 + g) + "\n";
+        }
+        for (int g = 0; g < games; g++)
+            lines += std::to_string(g) + " getmove 7\n";
+        server.send(lines);
+
+        for (int g = 0; g < games; g++) {
+            Bot direct(Bot::PEACOCK, order, g);
+            direct.updateBoard({ { Bot::SCARLET, 4 }, { Bot::PLUM, 20 },
+                    { Bot::PEACOCK, 10 + g } });
+            REQUIRE(server.receive() == std::to_string(g) + " move " +
+                    std::to_string(direct.getMove(7)));
+        }
+    }
+}
+
+// vim: set expandtab textwidth=100:
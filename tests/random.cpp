@@ -0,0 +1,34 @@
+#include <catch/catch.hpp>
+#include <vector>
+#include "../include/random.h"
+
+using namespace AI;
+
+TEST_CASE("Random class", "[random]") {
+    SECTION("same seed gives the same numbers") {
+        Random a(42);
+        Random b(42);
+        for (int i = 0; i < 1000; i++)
+            REQUIRE(a() == b());
+    }
+
+    SECTION("different seeds give different numbers") {
+        Random a(1);
+        Random b(2);
+        bool differ = false;
+        for (int i = 0; i < 10; i++)
+            differ |= a() != b();
+        REQUIRE(differ);
+    }
+
+    SECTION("every value of a small range comes up") {
+        Random r(7);
+        std::vector<int> counts(6, 0);
+        for (int i = 0; i < 6000; i++)
+            counts[r() % 6]++;
+        for (auto c : counts)
+            REQUIRE(c > 800);
+    }
+}
+
+// vim: set expandtab textwidth=100:
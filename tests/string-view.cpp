@@ -0,0 +1,46 @@
+#include <catch/catch.hpp>
+#include <sstream>
+#include <string>
+#include "../include/string-view.h"
+
+using namespace AI;
+
+TEST_CASE("StringView class", "[string-view]") {
+    std::string message = "suggest Plum,Rope,Study";
+    StringView view(message);
+
+    REQUIRE(view.size() == message.size());
+    REQUIRE(view.data() == message.data());
+    REQUIRE(view == "suggest Plum,Rope,Study");
+    REQUIRE(view.str() == message);
+    REQUIRE(StringView().empty());
+
+    SECTION("find and substr") {
+        size_t space = view.find(' ');
+        REQUIRE(space == 7);
+        REQUIRE(view.substr(0, space) == "suggest");
+
+        StringView args = view.substr(space + 1);
+        REQUIRE(args == "Plum,Rope,Study");
+        REQUIRE(args.find(',') == 4);
+        REQUIRE(args.find(',', 5) == 9);
+        REQUIRE(args.find(';') == StringView::npos);
+
+        // substr stops at the end of the view
+        REQUIRE(args.substr(10, 100) == "Study");
+        REQUIRE(args.substr(100).empty());
+    }
+
+    SECTION("comparison and output") {
+        REQUIRE(StringView("Plum") != "Plu");
+        REQUIRE(StringView("Plum") != "plum");
+        REQUIRE(StringView("Plum", 3) == "Plu");
+        REQUIRE(std::string("Rope") == StringView("Rope"));
+
+        std::ostringstream out;
+        out << view.substr(8, 4);
+        REQUIRE(out.str() == "Plum");
+    }
+}
+
+// vim: set expandtab textwidth=100:
@@ -0,0 +1,98 @@
+/**
+ * \file tournament.cpp
+ * \author Kobus van Schoor
+ *
+ * Plays many games between the AI and the reference bot and reports how well the AI played and
+ * how fast the games were played. Run with --help for the options.
+ */
+
+#include "include/simulator.h"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <time.h>
+
+namespace {
+    void usage(const char* name)
+    {
+        std::cout << "usage: " << name << " [options]\n"
+            "  --games N    amount of games to play (default 1000)\n"
+            "  --players N  players per game, 3 to 6 (default 4 to 6 at random)\n"
+            "  --smart N    players per game played by the AI, the rest are played by the\n"
+            "               reference bot (default 1)\n"
+            "  --planner N  1 to let the AI choose its suggestions for the most information\n"
+            "               (default 0)\n"
+            "  --think N    1 to let the AI think ahead after every event (default 0)\n"
+            "  --seed N     seed for the games (default the current time)\n"
+            "  --threads N  threads to play on (default all hardware threads)\n"
+            "  --record F   append the AI players' games to the replay file F\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    AI::TournamentOptions options;
+    options.seed = time(NULL);
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
+            usage(argv[0]);
+            return 0;
+        }
+
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        std::string arg = argv[i];
+        int value;
+
+        if (arg == "--record") {
+            options.record = argv[++i];
+            continue;
+        }
+
+        try {
+            value = std::stoi(argv[++i]);
+        } catch (std::exception&) {
+            std::cerr << "invalid value for " << arg << ": " << argv[i] << std::endl;
+            return 1;
+        }
+
+        if (arg == "--games")
+            options.games = value;
+        else if (arg == "--players")
+            options.game.players = value;
+        else if (arg == "--smart")
+            options.game.smart = value;
+        else if (arg == "--planner")
+            options.game.planner = value;
+        else if (arg == "--think")
+            options.game.thinkAhead = value;
+        else if (arg == "--seed")
+            options.seed = value;
+        else if (arg == "--threads")
+            options.threads = value;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    AI::TournamentStats stats;
+
+    try {
+        stats = AI::runTournament(options);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "seed: " << options.seed << std::endl;
+    AI::printStats(std::cout, stats);
+
+    return stats.errors ? 1 : 0;
+}
+
+// vim: set expandtab textwidth=100: